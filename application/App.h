@@ -1,11 +1,41 @@
 #pragma once
 
 #include "Core/Application.h"
+#include "Core/Pipeline/DocumentPipeline.h"
+#include "Core/Render/GLRenderer.h"
+#include "Core/Text/GlyphAtlas.h"
+#include "Core/Text/GlyphCache.h"
+#include <memory>
 #include <string>
+#include <vector>
+
+// Shows one document. Parsing, layout and paint recording run on the
+// DocumentPipeline's worker; a frame only replays the newest snapshot.
+// Window input is dispatched to the document's elements on the worker too,
+// and the wheel scrolls it.
 class Example : public Application {
    public:
-    Example(int width, int height, const std::string& name);
+    Example(int width, int height, const std::string& name,
+            const std::string& document = "example/example.html");
     virtual void OnInit() override;
+    virtual void OnInput(const std::vector<InputEvent>& events) override;
     virtual void OnRender() override;
     virtual void OnUpdate() override;
-};
\ No newline at end of file
+    virtual bool NeedsRedraw() override;
+    // Threads the pipeline lays out on, takes effect at OnInit.
+    void SetLayoutThreads(unsigned threads) { layoutThreads = threads; }
+
+   private:
+    std::unique_ptr<Shader> shader;
+    std::unique_ptr<GlyphAtlas> atlas;
+    std::unique_ptr<GlyphCache> glyphCache;
+    std::unique_ptr<GLRenderer> renderer;
+    FontId font = kInvalidFont;
+    std::string document;
+    unsigned layoutThreads = 1;
+    float viewWidth = 0, viewHeight = 0;  // last size sent to the pipeline
+    uint64_t shownSequence = 0;  // snapshot in the retained back buffer
+    DamageRegion damage;  // of the snapshots acquired since, to repaint
+    // last, so the worker stops before the glyph cache goes
+    std::unique_ptr<DocumentPipeline> pipeline;
+};
@@ -0,0 +1,1979 @@
+#include "Headless.h"
+#include "Core/Input/EventDispatcher.h"
+#include "Core/Input/HitTestGrid.h"
+#include "Core/Layout/LayoutEngine.h"
+#include "Core/Parser/CompiledDocument.h"
+#include "Core/Parser/Parser.h"
+#include "Core/Parser/StreamingParser.h"
+#include "Core/Parser/Tokenizer.h"
+#include "Core/Parser/Whitespace.h"
+#include "Core/Pipeline/DocumentPipeline.h"
+#include "Core/Render/Painter.h"
+#include "Core/Render/SoftwareRenderer.h"
+#include "Core/Style/StyleParser.h"
+#include "Core/Style/StyleSheet.h"
+#include "Core/Style/StyleTable.h"
+#include "Core/Text/GlyphAtlas.h"
+#include "Core/Text/GlyphCache.h"
+#include "Core/Text/TextLayout.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include "Core/ThreadPool.h"
+#include "Core/TreeAccess.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <regex>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#ifdef VISION_COUNT_ALLOCATIONS
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+
+}  // namespace
+
+// Every heap allocation in the process is counted, so a benchmark can tell
+// what one stage allocated. Only benchmark builds define this: the count
+// would tax every allocation the app makes.
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+// out of line, or GCC takes the inlined free() for a mismatched delete
+[[gnu::noinline]] void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+[[gnu::noinline]] void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+#endif
+
+namespace {
+
+#ifdef VISION_COUNT_ALLOCATIONS
+constexpr bool kCountsAllocations = true;
+uint64_t AllocationCount() { return allocationCount.load(); }
+#else
+constexpr bool kCountsAllocations = false;
+uint64_t AllocationCount() { return 0; }
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+double Milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+constexpr int kGridColumns = 24, kGridRows = 48;
+
+// at least this many frames for the frame-by-frame benchmarks, two seconds
+// at 60 Hz
+constexpr int kBenchFrames = 120;
+
+std::string CellStyle(bool highlighted) {
+    return std::string("width: 38px; height: 12px; margin: 1px; "
+                       "font-size: 10px; color: #333333; background-color: ") +
+           (highlighted ? "#ffcc00;" : "#dde4ee;");
+}
+
+// kGridRows flex rows of kGridColumns labelled cells, indexed in document
+// order like a parsed tree.
+std::shared_ptr<Element> BuildGrid(std::vector<Element*>& cells) {
+    uint32_t index = 0;
+    auto root = std::make_shared<Element>(kAtomWindow);
+    root->index = index++;
+    root->SetAttribute(kAtomStyle, "display: flex; flex-direction: column;");
+    for (int row = 0; row < kGridRows; row++) {
+        auto line = std::make_shared<Element>(kAtomDiv);
+        line->index = index++;
+        line->SetAttribute(kAtomStyle, "display: flex;");
+        root->AddChild(line);
+        for (int column = 0; column < kGridColumns; column++) {
+            auto cell = std::make_shared<Element>(kAtomDiv);
+            cell->index = index++;
+            cell->SetAttribute(kAtomStyle, CellStyle(false));
+            cell->SetText(std::to_string(row * kGridColumns + column));
+            line->AddChild(cell);
+            cells.push_back(cell.get());
+        }
+    }
+    return root;
+}
+
+constexpr int kSections = 1000, kSectionRows = 9, kRowCells = 10;
+
+// Blocks of kSectionRows flex rows of kRowCells cells, 100k nodes in wide,
+// independent subtrees with the default kSections.
+std::shared_ptr<Element> BuildWideDocument(int sections = kSections) {
+    uint32_t index = 0;
+    auto root = std::make_shared<Element>(kAtomWindow);
+    root->index = index++;
+    for (int section = 0; section < sections; section++) {
+        auto block = std::make_shared<Element>(kAtomDiv);
+        block->index = index++;
+        block->SetAttribute(kAtomStyle, "padding: 4px; margin: 2px;");
+        root->AddChild(block);
+        for (int row = 0; row < kSectionRows; row++) {
+            auto line = std::make_shared<Element>(kAtomDiv);
+            line->index = index++;
+            line->SetAttribute(kAtomStyle, "display: flex;");
+            block->AddChild(line);
+            for (int cell = 0; cell < kRowCells; cell++) {
+                auto item = std::make_shared<Element>(kAtomDiv);
+                item->index = index++;
+                item->SetAttribute(kAtomStyle, "padding: 2px;");
+                item->SetText("cell " + std::to_string(cell));
+                line->AddChild(item);
+            }
+        }
+    }
+    return root;
+}
+
+void CollectBoxes(const Element& element, const LayoutEngine& layout,
+                  std::vector<LayoutBox>& boxes) {
+    boxes[element.index] = layout.GetBox(element);
+    for (const auto& child : element.children) {
+        CollectBoxes(*child, layout, boxes);
+    }
+}
+
+bool SameBoxes(const std::vector<LayoutBox>& a,
+               const std::vector<LayoutBox>& b) {
+    for (size_t i = 0; i < a.size(); i++) {
+        const LayoutBox &x = a[i], &y = b[i];
+        if (x.x != y.x || x.y != y.y || x.width != y.width ||
+            x.height != y.height || x.text.x != y.text.x ||
+            x.text.y != y.text.y || x.text.width != y.text.width ||
+            x.text.height != y.text.height) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The same shape as BuildWideDocument, as markup.
+std::string GenerateWideMarkup(int sections = kSections) {
+    std::string markup = "<window>\n";
+    for (int section = 0; section < sections; section++) {
+        markup += "    <div style=\"padding: 4px; margin: 2px; "
+                  "background-color: #dde4ee;\">\n";
+        for (int row = 0; row < kSectionRows; row++) {
+            markup += "        <div style=\"display: flex;\">";
+            for (int cell = 0; cell < kRowCells; cell++) {
+                markup += "<div style=\"padding: 2px;\">cell " +
+                          std::to_string(cell) + "</div>";
+            }
+            markup += "</div>\n";
+        }
+        markup += "    </div>\n";
+    }
+    return markup + "</window>\n";
+}
+
+// Paragraphs of 40 to 200 words from a fixed vocabulary, about bytes in
+// all, the same on every run.
+std::vector<std::string> GenerateParagraphs(size_t bytes) {
+    static const char* const kWords[] = {
+        "lorem",     "ipsum",   "dolor",    "sit",       "amet",
+        "consectetur", "adipisicing", "elit", "Dolor",   "nisi",
+        "dolores",   "id",      "architecto", "eveniet", "Dignissimos",
+        "voluptate", "tempora", "repellendus", "sapiente", "AVATAR",
+        "Wolf",      "To",      "yearly",   "—",         "naïve",
+        "café",      "Quick",   "brown",    "fox",       "jumped"};
+    constexpr size_t kWordCount = sizeof(kWords) / sizeof(kWords[0]);
+    uint32_t state = 12345;
+    auto next = [&state](uint32_t range) {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) % range;
+    };
+
+    std::vector<std::string> paragraphs;
+    size_t total = 0;
+    while (total < bytes) {
+        std::string paragraph;
+        for (uint32_t word = 40 + next(161); word > 0; word--) {
+            if (!paragraph.empty()) paragraph += ' ';
+            paragraph += kWords[next(kWordCount)];
+        }
+        total += paragraph.size();
+        paragraphs.push_back(std::move(paragraph));
+    }
+    return paragraphs;
+}
+
+// About 50k nodes in sections of rows of cells, styled only by classes and
+// ids, with a <style> block of the given number of rules. Most rules match
+// nothing, as in a real site's sheet, and many name ancestors.
+std::string GenerateStyledMarkup(int rules) {
+    constexpr int kStyledSections = 50, kStyledRows = 20, kStyledCells = 24;
+    std::string markup = "<html><head><style>\n";
+    for (int i = 0; i < rules; i++) {
+        std::string n = std::to_string(i);
+        std::string c = std::to_string(i % 100);
+        std::string s = std::to_string(i % kStyledSections);
+        switch (i % 8) {
+            case 0: markup += ".c" + c; break;
+            case 1: markup += ".s" + s + " .c" + c; break;
+            case 2: markup += ".r" + std::to_string(i % kStyledRows) +
+                              " > .c" + c;
+                break;
+            case 3: markup += "#s" + s + " span.v" + std::to_string(i % 50);
+                break;
+            case 4: markup += ".x" + n + " .c" + c; break;
+            case 5: markup += "div.u" + n; break;
+            case 6: markup += ".s" + s + " span"; break;
+            case 7: markup += "#s" + s + " > .row .cell"; break;
+        }
+        markup += " { padding: " + std::to_string(i % 7) + "px; ";
+        markup += i % 2 ? "background-color: #" : "color: #";
+        markup += std::to_string(100 + i % 900) + "; }\n";
+    }
+    markup += "</style></head><body>\n";
+    for (int section = 0; section < kStyledSections; section++) {
+        std::string s = std::to_string(section);
+        markup += "<div id=\"s" + s + "\" class=\"section s" + s + "\">\n";
+        for (int row = 0; row < kStyledRows; row++) {
+            markup += "<div class=\"row r" + std::to_string(row) + "\">";
+            for (int cell = 0; cell < kStyledCells; cell++) {
+                int k = section * kStyledCells + row + cell;
+                markup += "<div class=\"cell c" + std::to_string(k % 100) +
+                          "\"><span class=\"v" + std::to_string(k % 50) +
+                          "\">x</span></div>";
+            }
+            markup += "</div>\n";
+        }
+        markup += "</div>\n";
+    }
+    return markup + "</body></html>\n";
+}
+
+// example.html's repeated <div><document /></div>, count times.
+std::string GenerateDocumentList(int count) {
+    std::string markup = "<window><body>\n";
+    for (int i = 0; i < count; i++) markup += "<div><document /></div>\n";
+    return markup + "</body></window>\n";
+}
+
+// A log view: rows alike but for alternating classes, styled by a sheet
+// whose rules look at ancestors.
+std::string GenerateRowList(int rows) {
+    std::string markup =
+        "<html><head><style>\n"
+        ".list > .row { display: flex; padding: 2px; }\n"
+        ".row.odd { background-color: #f4f4f4; }\n"
+        ".list .row .time { width: 80px; color: #888; }\n"
+        ".row > .message { font-size: 13px; }\n"
+        "</style></head><body><div class=\"list\">\n";
+    for (int row = 0; row < rows; row++) {
+        markup += row % 2 ? "<div class=\"row odd\">" : "<div class=\"row\">";
+        markup += "<span class=\"time\">12:00:" +
+                  std::to_string(row % 60) +
+                  "</span><span class=\"message\">request served</span>"
+                  "</div>\n";
+    }
+    return markup + "</div></body></html>\n";
+}
+
+bool SameTree(const Element& a, const Element& b) {
+    if (a.tag != b.tag || a.index != b.index || a.innerText != b.innerText ||
+        a.attributes.size() != b.attributes.size() ||
+        a.children.size() != b.children.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.attributes.size(); i++) {
+        if (a.attributes[i].name != b.attributes[i].name ||
+            a.attributes[i].value != b.attributes[i].value) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.children.size(); i++) {
+        if (!SameTree(*a.children[i], *b.children[i])) return false;
+    }
+    return true;
+}
+
+// The tree of well-formed markup, built with Parser's ElementBuilder but
+// nothing checked, matched or repaired: parsing without MarkupGrammar's
+// recovery, to measure what it costs. Other input gives some tree, or null.
+std::shared_ptr<Element> ParseUnchecked(std::string_view markup) {
+    Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+    ElementBuilder builder;
+    ElementBuilder::Node root;
+    std::vector<ElementBuilder::Node> open;
+    Token token = tokenizer.CurrentToken();
+    for (; token.type != TokenType::EndOfFile; token = tokenizer.Next()) {
+        switch (token.type) {
+            case TokenType::OpenTagStart: {
+                token = tokenizer.Next();
+                Atom tag = InternAtom(token.value);
+                ElementBuilder::Node element = builder.Create(tag);
+                token = tokenizer.Next();
+                while (token.type == TokenType::Identifier) {
+                    Atom key = InternAtom(token.value);
+                    token = tokenizer.Next();
+                    if (token.type != TokenType::Equals) {
+                        builder.SetAttribute(element, key, {});
+                        continue;
+                    }
+                    token = tokenizer.Next();
+                    builder.SetAttribute(element, key, token.value);
+                    token = tokenizer.Next();
+                }
+                if (!root) {
+                    root = element;
+                } else if (!open.empty()) {
+                    builder.AppendChild(open.back(), element);
+                }
+                if (token.type == TokenType::TagEnd && !IsVoidElement(tag)) {
+                    open.push_back(std::move(element));
+                }
+                break;
+            }
+            case TokenType::CloseTagStart:
+                tokenizer.Next();  // the name
+                token = tokenizer.Next();  // '>'
+                if (!open.empty()) open.pop_back();
+                break;
+            case TokenType::TextContent:
+                if (!open.empty()) builder.AppendText(open.back(), token.value);
+                break;
+            case TokenType::RawText:
+                if (!open.empty()) {
+                    builder.AppendRawText(open.back(), token.value);
+                }
+                break;
+            default:
+                break;
+        }
+        if (root && open.empty()) break;
+    }
+    return root;
+}
+
+bool SameDiagnostics(const std::vector<ParseDiagnostic>& a,
+                     const std::vector<ParseDiagnostic>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].line != b[i].line || a[i].column != b[i].column ||
+            a[i].message != b[i].message) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes the file back and drops its pages from the page cache where the
+// system allows it, so the next read comes from the disk. Returns false if
+// the pages may still be cached.
+bool EvictFromPageCache(const std::string& path) {
+#ifdef POSIX_FADV_DONTNEED
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool evicted = fsync(fd) == 0 &&
+                   posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return evicted;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+bool WriteFile(const std::string& path, std::string_view contents) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool written = std::fwrite(contents.data(), 1, contents.size(), file) ==
+                   contents.size();
+    return std::fclose(file) == 0 && written;
+}
+
+// What a HitTestGrid must find: the last element in tree order whose
+// absolute box holds the point, not clipped away by a box around it.
+void WalkHitTest(Element& element, const LayoutEngine& layout,
+                 const StyleTable& styles, float x, float y, float parentX,
+                 float parentY, Element*& hit) {
+    const ComputedStyle& style = styles.Get(element);
+    if (style.display == Display::None) return;
+    const LayoutBox& box = layout.GetBox(element);
+    float left = parentX + box.x, top = parentY + box.y;
+    bool inside = x >= left && y >= top && x < left + box.width &&
+                  y < top + box.height;
+    if (inside) hit = &element;
+    if (!inside && style.overflow != Overflow::Visible) return;
+    auto [first, end] = layout.LaidOutChildren(element);
+    for (size_t i = first; i < end; i++) {
+        WalkHitTest(*element.children[i], layout, styles, x, y,
+                    left - box.scrollX, top - box.scrollY, hit);
+    }
+}
+
+constexpr float kScrollRowHeight = 20;
+
+// A scroll container of rows rows, each a line of text.
+std::shared_ptr<Element> BuildScrollList(int rows, bool virtualized) {
+    uint32_t index = 0;
+    auto root = std::make_shared<Element>(kAtomWindow);
+    root->index = index++;
+    auto list = std::make_shared<Element>(kAtomDiv);
+    list->index = index++;
+    list->SetAttribute(kAtomStyle,
+                       virtualized ? "overflow: scroll; height: 700px; "
+                                     "virtualize: rows;"
+                                   : "overflow: scroll; height: 700px;");
+    root->AddChild(list);
+    const std::string styles[] = {
+        "height: 20px; padding: 0 8px; font-size: 13px;",
+        "height: 20px; padding: 0 8px; font-size: 13px; "
+        "background-color: #f4f4f4;"};
+    for (int row = 0; row < rows; row++) {
+        auto item = std::make_shared<Element>(kAtomDiv);
+        item->index = index++;
+        item->SetAttribute(kAtomStyle, styles[row % 2]);
+        item->SetText("row " + std::to_string(row));
+        list->AddChild(item);
+    }
+    return root;
+}
+
+// Largest resident set so far, in bytes.
+long PeakResident() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return long(usage.ru_maxrss);
+#else
+    return long(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// How far work raises the peak resident set, run in a forked child so
+// every measurement starts from the same heap. -1 if it could not run.
+long PeakResidentGrowth(const std::function<void()>& work) {
+    int channel[2];
+    if (pipe(channel) != 0) return -1;
+    pid_t child = fork();
+    if (child == 0) {
+        close(channel[0]);
+        long before = PeakResident();
+        work();
+        long growth = PeakResident() - before;
+        bool sent = write(channel[1], &growth, sizeof(growth)) ==
+                    ssize_t(sizeof(growth));
+        _exit(sent ? 0 : 1);
+    }
+    close(channel[1]);
+    long growth = -1;
+    if (child < 0 ||
+        read(channel[0], &growth, sizeof(growth)) != ssize_t(sizeof(growth))) {
+        growth = -1;
+    }
+    close(channel[0]);
+    if (child > 0) waitpid(child, nullptr, 0);
+    return growth;
+}
+
+// Visits every node in tree order and folds what a style pass would read.
+uint64_t Traverse(const Element& element) {
+    uint64_t sum = element.tag + element.innerText.size() +
+                   element.attributes.size();
+    for (const auto& child : element.children) sum += Traverse(*child);
+    return sum;
+}
+
+uint64_t Traverse(const Document& document, NodeId id) {
+    const Node& node = document.GetNode(id);
+    uint64_t sum = node.tag + node.innerText.size() + node.attributeCount;
+    for (NodeId child = node.firstChild; child != kInvalidNode;
+         child = document.GetNode(child).nextSibling) {
+        sum += Traverse(document, child);
+    }
+    return sum;
+}
+
+// A sheet written over several lines, with selectors split by newlines,
+// must style its document as it reads.
+bool CheckMultiLineStyleSheet() {
+    const std::string markup =
+        "<html><head><style>\n"
+        "div\np {\n    padding: 3px;\n}\n"
+        "div\n>\nspan,\n.a\n{ padding: 5px; }\n"
+        "</style></head><body><div><p>x</p><span>y</span></div></body>"
+        "</html>";
+    Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+    Parser parser(tokenizer);
+    std::shared_ptr<Element> root = parser.Parse();
+    std::shared_ptr<const StyleSheet> sheet = CollectStyleSheets(*root);
+    StyleTable styles;
+    styles.SetStyleSheet(sheet);
+    styles.Resolve(*root);
+    const Element& div = *root->children[1]->children[0];
+    bool same = sheet && sheet->RuleCount() == 3 &&
+                styles.Get(*div.children[0]).padding[0] == Length::Px(3) &&
+                styles.Get(*div.children[1]).padding[0] == Length::Px(5);
+    std::printf("multi-line <style>: %zu rules, %s\n",
+                sheet ? sheet->RuleCount() : 0, same ? "applied" : "WRONG");
+    return same;
+}
+
+}  // namespace
+
+int RunHeadless(const HeadlessOptions& options) {
+    GlyphAtlas atlas(1024, 1024);
+    GlyphCache glyphs(atlas);
+    FontId font = glyphs.LoadFont(options.font);
+    TextLayout text(glyphs);
+
+    StyleTable styles;
+    LayoutEngine layout(styles);
+    if (font != kInvalidFont) layout.SetTextMeasurer(text.Measurer(font));
+
+    Clock::time_point start = Clock::now();
+    SourceBuffer source = SourceBuffer::Map(options.document);
+    if (!source.IsOpen()) {
+        std::cerr << "Failed to open document: " << options.document
+                  << std::endl;
+        return 1;
+    }
+    // a compiled document is laid out and painted from its mapping
+    std::shared_ptr<Element> root;
+    CompiledDocument compiled;
+    std::unique_ptr<CompiledTree> tree;
+    if (CompiledDocument::IsCompiled(source.View())) {
+        compiled = CompiledDocument::Open(std::move(source));
+        if (!compiled.IsOpen()) {
+            std::cerr << "Unreadable compiled document: " << options.document
+                      << std::endl;
+            return 1;
+        }
+        tree = std::make_unique<CompiledTree>(compiled);
+    } else {
+        Tokenizer tokenizer(std::move(source));
+        Parser parser(tokenizer);
+        root = parser.Parse();
+        for (const ParseDiagnostic& diagnostic : parser.Diagnostics()) {
+            std::cerr << options.document << ":" << diagnostic.line << ":"
+                      << diagnostic.column << ": " << diagnostic.message
+                      << std::endl;
+        }
+        styles.SetStyleSheet(CollectStyleSheets(*root, options.document));
+    }
+    double parseTime = Milliseconds(Clock::now() - start);
+
+    Painter painter(&glyphs, font, &text);
+    SoftwareRenderer renderer(atlas);
+
+    Clock::duration layoutTime{}, recordTime{}, replayTime{};
+    for (int frame = 0; frame < options.frames; frame++) {
+        Clock::time_point frameStart = Clock::now();
+        if (!options.steady) layout.Invalidate();
+        if (tree) {
+            layout.Layout(*tree, float(options.width), float(options.height));
+        } else {
+            layout.Layout(*root, float(options.width), float(options.height));
+        }
+        layout.ScrollViewportTo(0, options.scrollY);
+        Clock::time_point laidOut = Clock::now();
+
+        glyphs.BeginFrame();
+        const DisplayList& list = tree ? painter.Paint(*tree, layout)
+                                       : painter.Paint(*root, layout, styles);
+        Clock::time_point recorded = Clock::now();
+
+        renderer.BeginFrame(options.width, options.height,
+                            {255, 255, 255, 255});
+        list.Replay(renderer);
+        renderer.EndFrame();
+
+        layoutTime += laidOut - frameStart;
+        recordTime += recorded - laidOut;
+        replayTime += Clock::now() - recorded;
+    }
+
+    int frames = options.frames > 0 ? options.frames : 1;
+    double frameTime = (Milliseconds(layoutTime) + Milliseconds(recordTime) +
+                        Milliseconds(replayTime)) /
+                       frames;
+    const DisplayList& list = painter.List();
+    std::printf("parse   %8.3f ms\n", parseTime);
+    std::printf("layout  %8.3f ms/frame\n", Milliseconds(layoutTime) / frames);
+    std::printf("record  %8.3f ms/frame (%u recorded, %u reused)\n",
+                Milliseconds(recordTime) / frames, painter.Stats().recorded,
+                painter.Stats().reused);
+    std::printf("replay  %8.3f ms/frame (%u commands, %zu bytes, %u batches)\n",
+                Milliseconds(replayTime) / frames, list.Stats().commands,
+                list.ByteSize(), list.Stats().batches);
+    std::printf("%d frames at %dx%d, %.1f frames/s\n", options.frames,
+                options.width, options.height,
+                frameTime > 0 ? 1000.0 / frameTime : 0.0);
+
+    if (!options.output.empty() && !renderer.WritePPM(options.output)) {
+        std::cerr << "Failed to write " << options.output << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int RunDamageBenchmark(const HeadlessOptions& options) {
+    GlyphAtlas atlas(1024, 1024);
+    GlyphCache glyphs(atlas);
+    FontId font = glyphs.LoadFont(options.font);
+
+    std::vector<Element*> cells;
+    std::shared_ptr<Element> root = BuildGrid(cells);
+    StyleTable styles;
+    LayoutEngine layout(styles);
+    Painter painter(&glyphs, font);
+    SoftwareRenderer partial(atlas), full(atlas);
+    const Color clearColor = {255, 255, 255, 255};
+
+    Clock::duration partialTime{}, fullTime{};
+    uint64_t partialPixels = 0, fullPixels = 0;
+    int mismatches = 0;
+    size_t highlighted = 0;
+    // the first frame paints everything, the rest change two cells each
+    int frames = std::max(options.frames, kBenchFrames);
+    for (int frame = 0; frame < frames; frame++) {
+        // move the highlight to a scattered cell, two cells change per frame
+        if (frame > 0) {
+            cells[highlighted]->SetAttribute(kAtomStyle, CellStyle(false));
+            highlighted = (highlighted + 7919) % cells.size();
+            cells[highlighted]->SetAttribute(kAtomStyle, CellStyle(true));
+        }
+        layout.Layout(*root, float(options.width), float(options.height));
+        glyphs.BeginFrame();
+        const DisplayList& list = painter.Paint(*root, layout, styles);
+
+        Clock::time_point start = Clock::now();
+        bool kept = partial.BeginRetainedFrame(options.width, options.height,
+                                               clearColor);
+        if (kept) {
+            list.Replay(partial, painter.Damage(), clearColor);
+        } else {
+            list.Replay(partial);
+        }
+        partial.EndFrame();
+        Clock::time_point painted = Clock::now();
+
+        full.BeginFrame(options.width, options.height, clearColor);
+        list.Replay(full);
+        full.EndFrame();
+
+        // the first frame paints everything in both
+        if (frame > 0) {
+            partialTime += painted - start;
+            fullTime += Clock::now() - painted;
+            partialPixels += partial.PixelsShaded();
+            fullPixels += full.PixelsShaded();
+        }
+        size_t bytes = size_t(options.width) * options.height * 4;
+        if (std::memcmp(partial.Pixels(), full.Pixels(), bytes) != 0) {
+            mismatches++;
+        }
+    }
+
+    int changed = frames - 1;
+    std::printf("%zu cells at %dx%d, %d changed frames\n", cells.size(),
+                options.width, options.height, changed);
+    std::printf("partial %8.3f ms/frame %10llu pixels/frame\n",
+                Milliseconds(partialTime) / changed,
+                (unsigned long long)(partialPixels / changed));
+    std::printf("full    %8.3f ms/frame %10llu pixels/frame\n",
+                Milliseconds(fullTime) / changed,
+                (unsigned long long)(fullPixels / changed));
+    std::printf("%d of %d frames differ\n", mismatches, frames);
+
+    if (!options.output.empty() && !partial.WritePPM(options.output)) {
+        std::cerr << "Failed to write " << options.output << std::endl;
+        return 1;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
+
+int RunPipelineStress(const HeadlessOptions& options) {
+    GlyphAtlas atlas(1024, 1024);
+    GlyphCache glyphs(atlas);
+    FontId font = glyphs.LoadFont(options.font);
+    DocumentPipeline pipeline(&glyphs, font);
+    pipeline.SetLayoutThreads(options.layoutThreads);
+
+    // the cells are only touched by mutations, which run on the worker
+    std::vector<Element*> cells;
+    pipeline.SetViewport(float(options.width), float(options.height));
+    pipeline.SetDocument(BuildGrid(cells));
+
+    // the pointer sweeps the page as window input would, listened to at the
+    // root; listeners run on the worker
+    std::atomic<uint64_t> overs{0}, wheels{0};
+    uint64_t submitted = 0;  // mutations, this one included
+    pipeline.Mutate([&pipeline, &overs, &wheels](Element& root) {
+        EventDispatcher& dispatcher = pipeline.Dispatcher();
+        dispatcher.AddEventListener(root, EventType::MouseOver,
+                                    [&overs](Event&) { overs++; });
+        dispatcher.AddEventListener(root, EventType::Wheel,
+                                    [&wheels](Event&) { wheels++; });
+    });
+    submitted++;
+    pipeline.WaitIdle();  // input before the first layout would hit nothing
+
+    std::atomic<bool> running{true};
+    std::thread mutator([&] {
+        size_t cell = 0;
+        bool highlighted = true;
+        while (running.load(std::memory_order_relaxed)) {
+            Element* target = cells[cell];
+            pipeline.Mutate([target, highlighted](Element&) {
+                target->SetAttribute(kAtomStyle, CellStyle(highlighted));
+            });
+            if (!highlighted) cell = (cell + 7919) % cells.size();
+            highlighted = !highlighted;
+            submitted++;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    });
+
+    // frames are kept and repainted where snapshots changed, as the app
+    // does, and checked against a full replay
+    SoftwareRenderer renderer(atlas), full(atlas);
+    const Color clearColor = {255, 255, 255, 255};
+    DamageRegion damage;
+    uint64_t shown = 0, repainted = 0;
+    int mismatches = 0;
+    const Clock::duration period = std::chrono::microseconds(16667);
+    Clock::duration renderTime{}, worstRender{};
+    double buildTime = 0, worstBuild = 0;
+    int dropped = 0, fresh = 0, stale = 0;
+    uint64_t lastSequence = 0;
+    Clock::time_point deadline = Clock::now() + period;
+    uint64_t inputs = 0;
+    int frames = std::max(options.frames, kBenchFrames);
+    for (int frame = 0; frame < frames; frame++) {
+        Clock::time_point start = Clock::now();
+        InputEvent pointer;
+        pointer.type = InputEventType::MouseMove;
+        pointer.x = float(frame * 7 % std::max(options.width, 1));
+        pointer.y = float(frame * 3 % std::max(options.height, 1));
+        std::vector<InputEvent> events = {pointer};
+        if (frame % 30 == 29) {
+            InputEvent wheel = pointer;
+            wheel.type = InputEventType::Scroll;
+            wheel.scrollY = -3;
+            events.push_back(wheel);
+        }
+        inputs += events.size();
+        pipeline.Input(std::move(events));
+
+        if (pipeline.Acquire()) {
+            fresh++;
+            damage.Add(pipeline.Snapshot().damage);
+        }
+        const DocumentSnapshot& snapshot = pipeline.Snapshot();
+        if (snapshot.sequence != lastSequence) {
+            lastSequence = snapshot.sequence;
+            buildTime += snapshot.buildMs;
+            worstBuild = std::max(worstBuild, snapshot.buildMs);
+        }
+        std::unique_lock<std::mutex> lock(pipeline.GlyphLock());
+        bool usable = snapshot.sequence != 0 &&
+                      snapshot.glyphGeneration == glyphs.Generation();
+        if (usable && snapshot.sequence != shown) {
+            if (renderer.BeginRetainedFrame(options.width, options.height,
+                                            clearColor)) {
+                snapshot.list.Replay(renderer, damage, clearColor);
+            } else {
+                snapshot.list.Replay(renderer);
+            }
+            renderer.EndFrame();
+            repainted += renderer.PixelsShaded();
+            shown = snapshot.sequence;
+            damage.Clear();
+        } else if (!usable) {
+            stale++;
+        }
+        Clock::duration elapsed = Clock::now() - start;
+        renderTime += elapsed;
+        worstRender = std::max(worstRender, elapsed);
+
+        if (usable) {
+            full.BeginFrame(options.width, options.height, clearColor);
+            snapshot.list.Replay(full);
+            full.EndFrame();
+            size_t bytes = size_t(options.width) * options.height * 4;
+            if (std::memcmp(renderer.Pixels(), full.Pixels(), bytes) != 0) {
+                mismatches++;
+            }
+        }
+        lock.unlock();
+
+        // a frame that ends past its deadline drops every tick it overran
+        Clock::time_point now = Clock::now();
+        if (now > deadline) {
+            int missed = int((now - deadline) / period) + 1;
+            dropped += missed;
+            deadline += missed * period;
+        }
+        std::this_thread::sleep_until(deadline);
+        deadline += period;
+    }
+
+    running = false;
+    mutator.join();
+    pipeline.WaitIdle();
+    PipelineStats stats = pipeline.Stats();
+
+    std::printf("%d frames at 60 Hz, %d dropped, %d without a snapshot\n",
+                frames, dropped, stale);
+    std::printf("mutations %llu submitted, %llu applied in %llu snapshots "
+                "(%d shown)\n",
+                (unsigned long long)submitted,
+                (unsigned long long)stats.mutations,
+                (unsigned long long)stats.builds, fresh);
+    std::printf("build   %8.3f ms/snapshot, worst %.3f ms\n",
+                fresh > 0 ? buildTime / fresh : 0.0, worstBuild);
+    std::printf("render  %8.3f ms/frame, worst %.3f ms\n",
+                Milliseconds(renderTime) / frames, Milliseconds(worstRender));
+    std::printf("redraw  %llu pixels/frame of %d, %d frames differ from a "
+                "full replay\n",
+                (unsigned long long)(repainted / frames),
+                options.width * options.height, mismatches);
+    std::printf("input   %llu events sent, %llu dispatched: %llu mouseover, "
+                "%llu wheel\n",
+                (unsigned long long)inputs,
+                (unsigned long long)stats.inputEvents,
+                (unsigned long long)overs.load(),
+                (unsigned long long)wheels.load());
+
+    if (!options.output.empty() && !renderer.WritePPM(options.output)) {
+        std::cerr << "Failed to write " << options.output << std::endl;
+        return 1;
+    }
+    // every mutation and event reaches the worker, the pointer crosses
+    // cells, and the kept frame is the picture
+    bool inputSeen = stats.inputEvents == inputs && (inputs == 0 || overs > 0);
+    return stats.mutations == submitted && inputSeen && mismatches == 0 ? 0
+                                                                        : 1;
+}
+
+int RunLayoutBenchmark(const HeadlessOptions& options) {
+    std::shared_ptr<Element> root = BuildWideDocument();
+    size_t count = size_t(kSections) * (1 + kSectionRows * (1 + kRowCells)) + 1;
+    StyleTable styles;
+    LayoutEngine layout(styles);
+    // sizes the box and style arrays so no run pays for allocation
+    layout.Layout(*root, float(options.width), float(options.height));
+
+    unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+
+    int frames = std::max(options.frames, 1);
+    std::vector<LayoutBox> reference(count), boxes(count);
+    double baseline = 0;
+    bool identical = true;
+    std::printf("%zu nodes, %u hardware threads, %d layouts each\n", count,
+                cores, frames);
+    for (unsigned threads : threadCounts) {
+        ThreadPool pool(threads);
+        layout.SetThreadPool(threads > 1 ? &pool : nullptr);
+        Clock::duration elapsed{};
+        for (int frame = 0; frame < frames; frame++) {
+            layout.Invalidate();
+            Clock::time_point start = Clock::now();
+            layout.Layout(*root, float(options.width), float(options.height));
+            elapsed += Clock::now() - start;
+        }
+
+        double time = Milliseconds(elapsed) / frames;
+        std::vector<LayoutBox>& target = threads == 1 ? reference : boxes;
+        CollectBoxes(*root, layout, target);
+        bool same = threads == 1 || SameBoxes(reference, boxes);
+        if (threads == 1) baseline = time;
+        identical = identical && same;
+        std::printf("%2u threads %8.3f ms/layout  %5.2fx  %s\n", threads,
+                    time, time > 0 ? baseline / time : 0.0,
+                    same ? "identical" : "DIFFERENT");
+    }
+    layout.SetThreadPool(nullptr);
+    return identical ? 0 : 1;
+}
+
+int RunStreamBenchmark(const HeadlessOptions& options) {
+    const std::string markup = GenerateWideMarkup();
+    const size_t chunkSize = 16 * 1024;
+    const Clock::duration chunkInterval = std::chrono::milliseconds(1);
+    const Clock::duration framePeriod = std::chrono::microseconds(16667);
+    const Color clearColor = {255, 255, 255, 255};
+    size_t chunks = (markup.size() + chunkSize - 1) / chunkSize;
+
+    GlyphAtlas atlas(1024, 1024);
+    GlyphCache glyphs(atlas);
+    FontId font = glyphs.LoadFont(options.font);
+    SoftwareRenderer renderer(atlas);
+    auto paint = [&](Element& root, LayoutEngine& layout, StyleTable& styles,
+                     Painter& painter) {
+        layout.Layout(root, float(options.width), float(options.height));
+        glyphs.BeginFrame();
+        const DisplayList& list = painter.Paint(root, layout, styles);
+        renderer.BeginFrame(options.width, options.height, clearColor);
+        list.Replay(renderer);
+        renderer.EndFrame();
+        return !list.IsEmpty();
+    };
+
+    // streaming: paint whatever has arrived once per frame
+    StreamingParser stream;
+    StyleTable streamStyles;
+    LayoutEngine streamLayout(streamStyles);
+    Painter streamPainter(&glyphs, font);
+    double firstPaint = -1;
+    uint32_t firstPaintElements = 0;
+    int frames = 0;
+    Clock::time_point start = Clock::now();
+    Clock::time_point nextFrame = start;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        std::this_thread::sleep_until(start + chunk * chunkInterval);
+        stream.Feed(std::string_view(markup).substr(chunk * chunkSize,
+                                                    chunkSize));
+        if (!stream.Root() || Clock::now() < nextFrame) continue;
+        bool painted =
+            paint(*stream.Root(), streamLayout, streamStyles, streamPainter);
+        frames++;
+        nextFrame = Clock::now() + framePeriod;  // a slow frame skips ticks
+        if (painted && firstPaint < 0) {
+            firstPaint = Milliseconds(Clock::now() - start);
+            firstPaintElements = stream.ElementCount();
+        }
+    }
+    stream.Finish();
+    paint(*stream.Root(), streamLayout, streamStyles, streamPainter);
+    frames++;
+    double streamComplete = Milliseconds(Clock::now() - start);
+    if (firstPaint < 0) firstPaint = streamComplete;
+
+    // whole document: nothing can start before the last chunk arrives
+    double arrival = Milliseconds((chunks - 1) * chunkInterval);
+    Clock::time_point parseStart = Clock::now();
+    Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+    Parser parser(tokenizer);
+    std::shared_ptr<Element> root = parser.Parse();
+    Clock::time_point parsed = Clock::now();
+    StyleTable styles;
+    LayoutEngine layout(styles);
+    Painter painter(&glyphs, font);
+    paint(*root, layout, styles, painter);
+    double parseTime = Milliseconds(parsed - parseStart);
+    double renderTime = Milliseconds(Clock::now() - parsed);
+
+    std::printf("%zu bytes in %zu chunks of %zu, one per ms\n",
+                markup.size(), chunks, chunkSize);
+    std::printf("streaming  first paint %8.3f ms (%u elements), complete "
+                "%8.3f ms, %d frames\n",
+                firstPaint, firstPaintElements, streamComplete, frames);
+    std::printf("full parse first paint %8.3f ms (last byte at %.3f, parse "
+                "%.3f, layout and paint %.3f)\n",
+                arrival + parseTime + renderTime, arrival, parseTime,
+                renderTime);
+
+    // the document, cut at odd places, must come out as Parser has it,
+    // repairs and diagnostics included
+    bool same = true;
+    SourceBuffer file = SourceBuffer::Map(options.document);
+    if (!file.View().empty()) {
+        const size_t pieceSize = 61;
+        StreamingParser pieces;
+        for (size_t at = 0; at < file.Size(); at += pieceSize) {
+            pieces.Feed(file.View().substr(at, pieceSize));
+        }
+        pieces.Finish();
+        Tokenizer fileTokenizer(SourceBuffer::Borrow(file.View()));
+        Parser fileParser(fileTokenizer);
+        std::shared_ptr<Element> fileRoot = fileParser.Parse();
+        same = SameTree(*pieces.Root(), *fileRoot) &&
+               SameDiagnostics(pieces.Diagnostics(),
+                               fileParser.Diagnostics());
+        std::printf("%s in chunks of %zu: %zu diagnostics, %s\n",
+                    options.document.c_str(), pieceSize,
+                    pieces.Diagnostics().size(),
+                    same ? "same as Parser" : "DIFFERENT from Parser");
+    }
+
+    if (!options.output.empty() && !renderer.WritePPM(options.output)) {
+        std::cerr << "Failed to write " << options.output << std::endl;
+        return 1;
+    }
+    return same ? 0 : 1;
+}
+
+int RunParseBenchmark(const HeadlessOptions& options) {
+    std::string markup = GenerateWideMarkup();
+    SourceBuffer file = SourceBuffer::Map(options.document);
+    std::string_view sources[] = {markup, file.View()};
+    const char* names[] = {"generated", options.document.c_str()};
+    int runs = std::max(options.frames, 10);
+
+    bool measured = false;
+    for (int i = 0; i < 2; i++) {
+        if (sources[i].empty()) continue;
+        // the fastest run of each, which allocator noise only slows down
+        double treeMs = 0, documentMs = 0, uncheckedMs = 0;
+        auto keepBest = [](double& best, Clock::time_point start) {
+            double ms = Milliseconds(Clock::now() - start);
+            best = best > 0 ? std::min(best, ms) : ms;
+        };
+        size_t diagnostics = 0;
+        bool same = true;
+        for (int run = 0; run < runs; run++) {
+            Clock::time_point start = Clock::now();
+            Tokenizer tokenizer(SourceBuffer::Borrow(sources[i]));
+            Parser parser(tokenizer);
+            std::shared_ptr<Element> root = parser.Parse();
+            keepBest(treeMs, start);
+            diagnostics = parser.Diagnostics().size();
+
+            start = Clock::now();
+            Tokenizer flatTokenizer(SourceBuffer::Borrow(sources[i]));
+            Parser flatParser(flatTokenizer);
+            std::unique_ptr<Document> document = flatParser.ParseDocument();
+            keepBest(documentMs, start);
+            document.reset();
+
+            start = Clock::now();
+            std::shared_ptr<Element> unchecked = ParseUnchecked(sources[i]);
+            keepBest(uncheckedMs, start);
+            same = same && unchecked && SameTree(*unchecked, *root);
+        }
+        double megabytes = double(sources[i].size()) / (1 << 20);
+        std::printf("%-24s %9zu bytes, %zu diagnostics\n", names[i],
+                    sources[i].size(), diagnostics);
+        std::printf("  Parse         %8.1f MB/s\n",
+                    megabytes / (treeMs / 1000));
+        std::printf("  ParseDocument %8.1f MB/s\n",
+                    megabytes / (documentMs / 1000));
+        // only a tree both agree on says what recovery costs
+        if (diagnostics != 0 || !same) {
+            std::printf("  unchecked     not well-formed, not compared\n");
+            continue;
+        }
+        std::printf("  unchecked     %8.1f MB/s, recovery costs Parse %.1f%%\n",
+                    megabytes / (uncheckedMs / 1000),
+                    (treeMs / uncheckedMs - 1) * 100);
+        measured = true;
+    }
+    return measured ? 0 : 1;
+}
+
+int RunCompiler(const HeadlessOptions& options, const std::string& output) {
+    SourceBuffer source = SourceBuffer::Map(options.document);
+    if (!source.IsOpen()) {
+        std::cerr << "Failed to open document: " << options.document
+                  << std::endl;
+        return 1;
+    }
+    Tokenizer tokenizer(std::move(source));
+    Parser parser(tokenizer);
+    std::shared_ptr<Element> root = parser.Parse();
+    for (const ParseDiagnostic& diagnostic : parser.Diagnostics()) {
+        std::cerr << options.document << ":" << diagnostic.line << ":"
+                  << diagnostic.column << ": " << diagnostic.message
+                  << std::endl;
+    }
+    StyleTable styles;
+    styles.SetStyleSheet(CollectStyleSheets(*root, options.document));
+    styles.Resolve(*root);
+    if (!WriteCompiledDocument(*root, styles, output)) {
+        std::cerr << "Failed to write " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int RunLoadBenchmark(const HeadlessOptions& options) {
+    constexpr int kLoadSections = 1260;  // about 5 MB of markup
+    const char* temporary = std::getenv("TMPDIR");
+    std::string directory = temporary && *temporary ? temporary : "/tmp";
+    std::string textPath = directory + "/vision-load-bench.html";
+    std::string compiledPath = directory + "/vision-load-bench.vdoc";
+
+    std::string markup = GenerateWideMarkup(kLoadSections);
+    std::shared_ptr<Element> reference;
+    {
+        Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+        Parser parser(tokenizer);
+        reference = parser.Parse();
+        StyleTable styles;
+        styles.Resolve(*reference);
+        if (!WriteFile(textPath, markup) ||
+            !WriteCompiledDocument(*reference, styles, compiledPath)) {
+            std::cerr << "Failed to write to " << directory << std::endl;
+            return 1;
+        }
+    }
+
+    int runs = std::max(options.frames, 5);
+    bool cold = true;
+    Clock::duration parseTime{}, resolveTime{}, openTime{}, viewTime{},
+        copyTime{};
+    std::shared_ptr<Element> textRoot, copiedRoot;
+    StyleTable textStyles, copiedStyles;
+    CompiledDocument compiled;
+    std::unique_ptr<CompiledTree> tree;
+    for (int run = 0; run < runs; run++) {
+        cold = EvictFromPageCache(textPath) && cold;
+        Clock::time_point start = Clock::now();
+        Tokenizer tokenizer(SourceBuffer::Map(textPath));
+        Parser parser(tokenizer);
+        textRoot = parser.Parse();
+        Clock::time_point parsed = Clock::now();
+        textStyles.Resolve(*textRoot);
+        parseTime += parsed - start;
+        resolveTime += Clock::now() - parsed;
+
+        tree.reset();
+        cold = EvictFromPageCache(compiledPath) && cold;
+        start = Clock::now();
+        compiled = CompiledDocument::Open(compiledPath);
+        Clock::time_point opened = Clock::now();
+        if (!compiled.IsOpen()) {
+            std::cerr << "Failed to open " << compiledPath << std::endl;
+            return 1;
+        }
+        tree = std::make_unique<CompiledTree>(compiled);
+        Clock::time_point viewed = Clock::now();
+        // what a document that is going to change pays on top
+        compiled.LoadStyles(copiedStyles);
+        copiedRoot = compiled.BuildElementTree(true);
+        openTime += opened - start;
+        viewTime += viewed - opened;
+        copyTime += Clock::now() - viewed;
+    }
+
+    // the same tree, boxes, picture and hits from the mapping as from the
+    // markup
+    size_t count = compiled.NodeCount();
+    StyleTable unused;
+    LayoutEngine textLayout(textStyles), compiledLayout(unused);
+    float width = float(options.width), height = float(options.height);
+    Clock::time_point start = Clock::now();
+    textLayout.Layout(*textRoot, width, height);
+    Clock::time_point laidOut = Clock::now();
+    compiledLayout.Layout(*tree, width, height);
+    double textLayoutTime = Milliseconds(laidOut - start);
+    double compiledLayoutTime = Milliseconds(Clock::now() - laidOut);
+
+    std::vector<LayoutBox> textBoxes(count), compiledBoxes(count);
+    CollectBoxes(*textRoot, textLayout, textBoxes);
+    for (NodeId id = 0; id < count; id++) {
+        compiledBoxes[id] = compiledLayout.GetBox(id);
+    }
+
+    GlyphAtlas atlas(1024, 1024);
+    SoftwareRenderer textPicture(atlas), compiledPicture(atlas);
+    Painter textPainter, compiledPainter;
+    for (SoftwareRenderer* picture : {&textPicture, &compiledPicture}) {
+        picture->BeginFrame(options.width, options.height,
+                            {255, 255, 255, 255});
+    }
+    textPainter.Paint(*textRoot, textLayout, textStyles).Replay(textPicture);
+    compiledPainter.Paint(*tree, compiledLayout).Replay(compiledPicture);
+    textPicture.EndFrame();
+    compiledPicture.EndFrame();
+    size_t bytes = size_t(options.width) * options.height * 4;
+    bool samePicture = std::memcmp(textPicture.Pixels(),
+                                   compiledPicture.Pixels(), bytes) == 0;
+
+    HitTestGrid textGrid, compiledGrid;
+    textGrid.Update(*textRoot, textLayout, textStyles);
+    compiledGrid.Update(*tree, compiledLayout);
+    int hitsDiffer = 0;
+    for (int y = 0; y < options.height; y += 7) {
+        for (int x = 0; x < options.width; x += 7) {
+            hitsDiffer += textGrid.HitTestNode(float(x), float(y)) !=
+                          compiledGrid.HitTestNode(float(x), float(y));
+        }
+    }
+
+    bool identical = textStyles.Size() == count &&
+                     SameTree(*textRoot, *copiedRoot) &&
+                     SameBoxes(textBoxes, compiledBoxes) && samePicture &&
+                     hitsDiffer == 0;
+
+    double text = (Milliseconds(parseTime) + Milliseconds(resolveTime)) / runs;
+    double binary = (Milliseconds(openTime) + Milliseconds(viewTime)) / runs;
+    std::printf("%zu bytes of markup, %zu bytes compiled, %zu nodes, %s "
+                "cache\n",
+                markup.size(), SourceBuffer::Map(compiledPath).Size(), count,
+                cold ? "cold" : "warm");
+    std::printf("text      %8.3f ms  (parse %.3f, styles %.3f)\n", text,
+                Milliseconds(parseTime) / runs,
+                Milliseconds(resolveTime) / runs);
+    std::printf("compiled  %8.3f ms  (open %.3f, tree %.3f)  %.1fx\n",
+                binary, Milliseconds(openTime) / runs,
+                Milliseconds(viewTime) / runs,
+                binary > 0 ? text / binary : 0.0);
+    std::printf("copy out  %8.3f ms  more for Elements and a style table\n",
+                Milliseconds(copyTime) / runs);
+    std::printf("layout    %8.3f ms  from the markup, %.3f ms from the "
+                "mapping\n",
+                textLayoutTime, compiledLayoutTime);
+    std::printf("trees, layout, picture and hit tests %s\n",
+                identical ? "identical" : "DIFFER");
+
+    std::remove(textPath.c_str());
+    std::remove(compiledPath.c_str());
+    return identical ? 0 : 1;
+}
+
+int RunTextBenchmark(const HeadlessOptions& options) {
+    GlyphAtlas atlas(1024, 1024);
+    GlyphCache glyphs(atlas);
+    FontId font = glyphs.LoadFont(options.font);
+    if (font == kInvalidFont) return 1;
+
+    const std::vector<std::string> paragraphs = GenerateParagraphs(1 << 20);
+    const float widths[] = {160, 320, 640, 1280};
+    const uint16_t pixelSize = 16;
+    size_t bytes = 0;
+    for (const std::string& paragraph : paragraphs) bytes += paragraph.size();
+
+    // every paragraph at one width, returns the time and counts the lines
+    auto wrap = [&](TextLayout& text, float width, size_t& lines) {
+        lines = 0;
+        Clock::time_point start = Clock::now();
+        for (const std::string& paragraph : paragraphs) {
+            lines += text.Layout(paragraph, font, pixelSize, width)
+                         ->lines.size();
+        }
+        return Milliseconds(Clock::now() - start);
+    };
+
+    std::printf("%zu bytes in %zu paragraphs, %upx, kerning %s\n", bytes,
+                paragraphs.size(), pixelSize,
+                FT_HAS_KERNING(glyphs.Face(font)) ? "on" : "not in font");
+    std::printf("width    shape+break   resize   cached    lines\n");
+    TextLayout cached(glyphs, 64 << 20);
+    double resize[4], repeat[4];
+    size_t lines[4];
+    for (int i = 0; i < 4; i++) resize[i] = wrap(cached, widths[i], lines[i]);
+    for (int i = 0; i < 4; i++) repeat[i] = wrap(cached, widths[i], lines[i]);
+    for (int i = 0; i < 4; i++) {
+        // a fresh cache per width is what every resize cost without one
+        TextLayout uncached(glyphs, 64 << 20);
+        size_t count;
+        double shaped = wrap(uncached, widths[i], count);
+        // the first width has nothing cached to resize from
+        char resized[16] = "     n/a";
+        if (i > 0) {
+            std::snprintf(resized, sizeof resized, "%6.2f ms", resize[i]);
+        }
+        std::printf("%5.0f %11.2f ms %s %6.2f ms %8zu%s\n", widths[i], shaped,
+                    resized, repeat[i], lines[i],
+                    count == lines[i] ? "" : " MISMATCH");
+    }
+    TextLayoutStats stats = cached.Stats();
+    std::printf("%llu runs shaped, %llu breaks, %llu hits, %.1f MB cached\n",
+                (unsigned long long)stats.runMisses,
+                (unsigned long long)stats.blockMisses,
+                (unsigned long long)stats.blockHits,
+                stats.bytesInUse / double(1 << 20));
+    return 0;
+}
+
+int RunStyleBenchmark(const HeadlessOptions& options) {
+    if (!CheckMultiLineStyleSheet()) return 1;
+    constexpr int kRules = 2000;
+    const std::string markup = GenerateStyledMarkup(kRules);
+    Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+    Parser parser(tokenizer);
+    std::shared_ptr<Element> root = parser.Parse();
+
+    Clock::time_point start = Clock::now();
+    std::shared_ptr<const StyleSheet> sheet = CollectStyleSheets(*root);
+    double parseTime = Milliseconds(Clock::now() - start);
+    if (!sheet) return 1;
+
+    struct Mode {
+        const char* name;
+        bool sheet, buckets, filter;
+    };
+    const Mode modes[] = {
+        {"inline only", false, false, false},
+        {"every rule", true, false, false},
+        {"buckets", true, true, false},
+        {"buckets+filter", true, true, true},
+    };
+    int runs = std::max(options.frames, 1);
+    StyleTable styles;
+    std::vector<ComputedStyle> reference;
+    size_t nodes = 0;
+    bool same = true;
+    std::printf("%zu rules parsed in %.2f ms\n", sheet->RuleCount(),
+                parseTime);
+    std::printf("%-16s %10s %12s %10s %10s\n", "", "resolve", "candidates",
+                "filtered", "matched");
+    for (const Mode& mode : modes) {
+        styles.SetStyleSheet(mode.sheet ? sheet : nullptr);
+        styles.Matcher().SetFastPaths(mode.buckets, mode.filter);
+        double best = 0;
+        for (int run = 0; run < runs; run++) {
+            styles.Matcher().ResetStats();
+            Clock::time_point resolveStart = Clock::now();
+            styles.Resolve(*root);
+            double time = Milliseconds(Clock::now() - resolveStart);
+            best = run == 0 ? time : std::min(best, time);
+        }
+        nodes = styles.Size();
+        if (mode.sheet) {
+            std::vector<ComputedStyle> resolved(nodes);
+            for (size_t i = 0; i < nodes; i++) resolved[i] = styles.Get(i);
+            if (reference.empty()) {
+                reference = std::move(resolved);
+            } else if (resolved != reference) {
+                same = false;
+            }
+        }
+        // per node, of the last run
+        const SelectorStats& stats = styles.Matcher().Stats();
+        std::printf("%-16s %7.2f ms %12.1f %10.1f %10.2f\n", mode.name, best,
+                    double(stats.candidates) / nodes,
+                    double(stats.filtered) / nodes,
+                    double(stats.matched) / nodes);
+    }
+    std::printf("%zu nodes, styles %s\n", nodes,
+                same ? "identical" : "DIFFER");
+    return same ? 0 : 1;
+}
+
+int RunStyleSharingBenchmark(const HeadlessOptions& options) {
+    struct Page {
+        const char* name;
+        std::string markup;
+    };
+    const Page pages[] = {
+        {"document list", GenerateDocumentList(100000)},
+        {"row list", GenerateRowList(50000)},
+        {"styled grid", GenerateStyledMarkup(2000)},
+    };
+    // a style allocated with make_shared, with its control block
+    constexpr size_t kStyleBytes = sizeof(ComputedStyle) + 2 * sizeof(void*);
+    int runs = std::max(options.frames, 1);
+    bool same = true;
+    std::printf("%-14s %8s %7s %11s %11s %9s %17s\n", "", "nodes", "shared",
+                "unshared", "sharing", "styles", "style memory");
+    for (const Page& page : pages) {
+        Tokenizer tokenizer(SourceBuffer::Borrow(page.markup));
+        Parser parser(tokenizer);
+        std::shared_ptr<Element> root = parser.Parse();
+        StyleTable styles;
+        styles.SetStyleSheet(CollectStyleSheets(*root));
+
+        double times[2];
+        size_t distinct[2];
+        std::vector<ComputedStyle> resolved[2];
+        for (int sharing = 0; sharing < 2; sharing++) {
+            styles.SetStyleSharing(sharing);
+            for (int run = 0; run < runs; run++) {
+                styles.ResetSharingStats();
+                Clock::time_point start = Clock::now();
+                styles.Resolve(*root);
+                double time = Milliseconds(Clock::now() - start);
+                if (run == 0 || time < times[sharing]) times[sharing] = time;
+            }
+            distinct[sharing] = styles.DistinctStyles();
+            for (size_t i = 0; i < styles.Size(); i++) {
+                resolved[sharing].push_back(styles.Get(i));
+            }
+        }
+        same = same && resolved[0] == resolved[1];
+
+        const StyleSharingStats& stats = styles.SharingStats();
+        size_t nodes = styles.Size();
+        size_t slots = nodes * sizeof(std::shared_ptr<const ComputedStyle>);
+        std::printf("%-14s %8zu %6.1f%% %8.2f ms %8.2f ms %9zu %6.1f -> "
+                    "%4.1f MB\n",
+                    page.name, nodes,
+                    100.0 * stats.shared / (stats.shared + stats.resolved),
+                    times[0], times[1], distinct[1],
+                    (slots + distinct[0] * kStyleBytes) / double(1 << 20),
+                    (slots + distinct[1] * kStyleBytes) / double(1 << 20));
+    }
+    std::printf("styles %s with sharing\n", same ? "identical" : "DIFFER");
+    return same ? 0 : 1;
+}
+
+int RunHitTestBenchmark(const HeadlessOptions& options) {
+    std::shared_ptr<Element> root = BuildWideDocument();
+    StyleTable styles;
+    LayoutEngine layout(styles);
+    layout.Layout(*root, float(options.width), float(options.height));
+    const LayoutBox& page = layout.GetBox(*root);
+
+    HitTestGrid grid;
+    Clock::time_point start = Clock::now();
+    grid.Update(*root, layout, styles);
+    double build = Milliseconds(Clock::now() - start);
+    std::printf("%u boxes over %.0fx%.0f, %u large, %zu cell entries, "
+                "built in %.2f ms\n",
+                grid.Stats().boxes, page.width, page.height,
+                grid.Stats().large, grid.Stats().cellEntries, build);
+
+    constexpr int kQueries = 100000, kWalks = 200;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> across(0, page.width);
+    std::uniform_real_distribution<float> down(0, page.height);
+    std::vector<std::pair<float, float>> points(kQueries);
+    for (auto& point : points) point = {across(random), down(random)};
+
+    std::vector<Element*> found(kQueries);
+    start = Clock::now();
+    for (int i = 0; i < kQueries; i++) {
+        found[i] = grid.HitTest(points[i].first, points[i].second).get();
+    }
+    double gridTime = Milliseconds(Clock::now() - start) / kQueries;
+    std::vector<Element*> walked(kWalks);
+    start = Clock::now();
+    for (int i = 0; i < kWalks; i++) {
+        WalkHitTest(*root, layout, styles, points[i].first, points[i].second,
+                    0, 0, walked[i]);
+    }
+    double walkTime = Milliseconds(Clock::now() - start) / kWalks;
+    int agree = 0;
+    for (int i = 0; i < kWalks; i++) agree += found[i] == walked[i];
+    std::printf("grid %8.3f us/query  walk %8.3f us/query  %6.0fx  "
+                "%d of %d agree\n",
+                gridTime * 1000, walkTime * 1000,
+                gridTime > 0 ? walkTime / gridTime : 0.0, agree, kWalks);
+
+    // one cell per frame grows wider or is hidden, moving the rest of its
+    // row
+    const char* const cellStyles[] = {"padding: 2px 12px;", "display: none;",
+                                      "padding: 2px;"};
+    constexpr int kFrames = 100;
+    Clock::duration incremental{}, rebuild{};
+    uint64_t moved = 0;
+    int differ = 0;
+    for (int frame = 0; frame < kFrames; frame++) {
+        size_t section = size_t(frame) * 7919 % kSections;
+        Element& cell = *root->children[section]->children[4]->children[3];
+        cell.SetAttribute(kAtomStyle, cellStyles[frame % 3]);
+        layout.Layout(*root, float(options.width), float(options.height));
+
+        start = Clock::now();
+        grid.Update(*root, layout, styles);
+        incremental += Clock::now() - start;
+        moved += grid.Stats().moved;
+
+        HitTestGrid fresh;
+        start = Clock::now();
+        fresh.Update(*root, layout, styles);
+        rebuild += Clock::now() - start;
+        for (int i = 0; i < 1000; i++) {
+            auto [x, y] = points[(size_t(frame) * 1000 + i) % kQueries];
+            differ += grid.HitTest(x, y) != fresh.HitTest(x, y);
+        }
+    }
+    std::printf("update %8.3f ms/frame, %llu boxes moved/frame  rebuild "
+                "%8.3f ms/frame  %d differ\n",
+                Milliseconds(incremental) / kFrames,
+                (unsigned long long)(moved / kFrames),
+                Milliseconds(rebuild) / kFrames, differ);
+
+    // frames of a 1000 Hz mouse at 60 Hz, each ending in a click
+    constexpr int kMovesPerFrame = 16;
+    EventDispatcher dispatcher;
+    uint64_t clicks = 0, overs = 0;
+    dispatcher.AddEventListener(*root, EventType::Click,
+                                [&](Event&) { clicks++; });
+    dispatcher.AddEventListener(
+        *root, EventType::MouseOver, [&](Event&) { overs++; }, true);
+    std::vector<InputEvent> events;
+    start = Clock::now();
+    for (int frame = 0; frame < kFrames; frame++) {
+        events.clear();
+        InputEvent input;
+        input.type = InputEventType::MouseMove;
+        for (int move = 0; move < kMovesPerFrame; move++) {
+            input.x = float((frame * kMovesPerFrame + move) % 800);
+            input.y = float(frame * 3);
+            events.push_back(input);
+        }
+        input.type = InputEventType::MouseDown;
+        events.push_back(input);
+        input.type = InputEventType::MouseUp;
+        events.push_back(input);
+        dispatcher.Dispatch(events, grid, root);
+    }
+    double dispatchTime = Milliseconds(Clock::now() - start) / kFrames;
+    const DispatchStats& dispatched = dispatcher.Stats();
+    std::printf("dispatch %6.3f ms/frame: %llu input events, %llu moves "
+                "dispatched, %llu hit tests, %llu events, %llu over, "
+                "%llu clicks\n",
+                dispatchTime, (unsigned long long)dispatched.inputEvents,
+                (unsigned long long)dispatched.moves,
+                (unsigned long long)dispatched.hitTests,
+                (unsigned long long)dispatched.events,
+                (unsigned long long)overs, (unsigned long long)clicks);
+    return agree == kWalks && differ == 0 && clicks == kFrames ? 0 : 1;
+}
+
+int RunScrollBenchmark(const HeadlessOptions& options) {
+    GlyphAtlas atlas(1024, 1024);
+    GlyphCache glyphs(atlas);
+    FontId font = glyphs.LoadFont(options.font);
+    TextLayout text(glyphs);
+    SoftwareRenderer renderer(atlas);
+
+    constexpr int kFrames = 120, kProbes = 4;
+    const struct {
+        int rows;
+        bool virtualized;
+    } runs[] = {{1000, false},  {10000, false},  {100000, false},
+                {1000, true},   {10000, true},   {100000, true},
+                {1000000, true}};
+    int differ = 0;
+    for (const auto& run : runs) {
+        Clock::time_point start = Clock::now();
+        std::shared_ptr<Element> root =
+            BuildScrollList(run.rows, run.virtualized);
+        Element& list = *root->children[0];
+        StyleTable styles;
+        LayoutEngine layout(styles);
+        if (font != kInvalidFont) layout.SetTextMeasurer(text.Measurer(font));
+        layout.Layout(*root, float(options.width), float(options.height));
+        HitTestGrid grid;
+        grid.Update(*root, layout, styles);
+        Painter painter(&glyphs, font, &text);
+        painter.Paint(*root, layout, styles);
+        double setup = Milliseconds(Clock::now() - start);
+
+        // wheel steps through the list, now and then a jump as if the
+        // scroll bar were dragged
+        EventDispatcher dispatcher;
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> anywhere(
+            0, run.rows * kScrollRowHeight);
+        std::uniform_real_distribution<float> across(0, float(options.width));
+        std::uniform_real_distribution<float> down(0, 700);
+        Clock::duration layoutTime{}, gridTime{}, paintTime{};
+        uint64_t laidOut = 0, commands = 0;
+        for (int frame = 0; frame < kFrames; frame++) {
+            Clock::time_point frameStart = Clock::now();
+            if (frame % 30 == 29) {
+                const LayoutBox& box = layout.GetBox(list);
+                layout.ScrollTo(list, box.scrollX, anywhere(random));
+            } else {
+                InputEvent wheel;
+                wheel.type = InputEventType::Scroll;
+                wheel.x = 100;
+                wheel.y = 100;
+                wheel.scrollY = -3;
+                dispatcher.Dispatch({wheel}, grid, root, &layout);
+            }
+            layout.Layout(*root, float(options.width), float(options.height));
+            Clock::time_point laid = Clock::now();
+            grid.Update(*root, layout, styles);
+            Clock::time_point indexed = Clock::now();
+            glyphs.BeginFrame();
+            const DisplayList& painted = painter.Paint(*root, layout, styles);
+            renderer.BeginFrame(options.width, options.height,
+                                {255, 255, 255, 255});
+            painted.Replay(renderer);
+            renderer.EndFrame();
+            layoutTime += laid - frameStart;
+            gridTime += indexed - laid;
+            paintTime += Clock::now() - indexed;
+            laidOut += layout.Stats().nodesLaidOut;
+            commands += painted.Stats().commands;
+
+            for (int probe = 0; probe < kProbes; probe++) {
+                float x = across(random), y = down(random);
+                Element* walked = nullptr;
+                const Rect& viewport = layout.Viewport();
+                WalkHitTest(*root, layout, styles, x, y, -viewport.x,
+                            -viewport.y, walked);
+                differ += grid.HitTest(x, y).get() != walked;
+            }
+        }
+        double total = Milliseconds(layoutTime + gridTime + paintTime);
+        std::printf("%8d rows %-11s setup %9.1f ms  frame %7.3f ms (layout "
+                    "%6.3f, hit grid %6.3f, paint %6.3f)  %5llu laid out, "
+                    "%4llu commands/frame, %u boxes indexed\n",
+                    run.rows, run.virtualized ? "virtualized" : "culled",
+                    setup, total / kFrames,
+                    Milliseconds(layoutTime) / kFrames,
+                    Milliseconds(gridTime) / kFrames,
+                    Milliseconds(paintTime) / kFrames,
+                    (unsigned long long)(laidOut / kFrames),
+                    (unsigned long long)(commands / kFrames),
+                    grid.Stats().boxes);
+    }
+    std::printf("%d hit tests differ from a tree walk\n", differ);
+    return differ == 0 ? 0 : 1;
+}
+
+int RunTokenBenchmark(const HeadlessOptions& options) {
+    SourceBuffer file = SourceBuffer::Map(options.document);
+    if (!file.IsOpen()) {
+        std::cerr << "Failed to open document: " << options.document
+                  << std::endl;
+        return 1;
+    }
+    constexpr int kCopies = 1000;
+    // one root around the copies, or the parser stops after the first
+    std::string markup = "<window>\n";
+    markup.reserve(file.Size() * kCopies + 20);
+    for (int copy = 0; copy < kCopies; copy++) markup += file.View();
+    markup += "</window>\n";
+    double megabytes = double(markup.size()) / (1 << 20);
+    int runs = std::max(options.frames, 1);
+
+    struct Result {
+        const char* name;
+        double ms = 0;
+        uint64_t tokens = 0, allocations = 0;
+    };
+    Result results[] = {{"Next()"}, {"Tokenize()"}, {"Parse()"}};
+    for (int run = 0; run < runs; run++) {
+        // lazily, one slice at a time
+        uint64_t allocated = AllocationCount();
+        Clock::time_point start = Clock::now();
+        Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+        uint64_t tokens = 0;
+        for (Token token = tokenizer.CurrentToken();
+             token.type != TokenType::EndOfFile; token = tokenizer.Next()) {
+            tokens++;
+        }
+        results[0].ms += Milliseconds(Clock::now() - start);
+        results[0].tokens += tokens;
+        results[0].allocations += AllocationCount() - allocated;
+
+        // into a vector, as every token used to be
+        allocated = AllocationCount();
+        start = Clock::now();
+        tokenizer.Reset();
+        std::vector<Token> all = tokenizer.Tokenize();
+        results[1].ms += Milliseconds(Clock::now() - start);
+        results[1].tokens += all.size();
+        all = {};
+        results[1].allocations += AllocationCount() - allocated;
+
+        // and pulled by the parser into an element tree
+        allocated = AllocationCount();
+        start = Clock::now();
+        Tokenizer parsed(SourceBuffer::Borrow(markup));
+        Parser parser(parsed);
+        std::shared_ptr<Element> root = parser.Parse();
+        results[2].ms += Milliseconds(Clock::now() - start);
+        results[2].tokens += tokens;
+        root.reset();
+        results[2].allocations += AllocationCount() - allocated;
+    }
+
+    std::printf("%s x%d: %zu bytes, %llu tokens, %d runs\n",
+                options.document.c_str(), kCopies, markup.size(),
+                (unsigned long long)(results[0].tokens / runs), runs);
+    for (const Result& result : results) {
+        double seconds = result.ms / 1000;
+        std::printf("%-11s %8.1f Mtokens/s %8.1f MB/s", result.name,
+                    result.tokens / seconds / 1e6, megabytes * runs / seconds);
+        if (kCountsAllocations) {
+            std::printf(" %12.1f allocations/MB",
+                        result.allocations / (megabytes * runs));
+        }
+        std::printf("\n");
+    }
+    if (!kCountsAllocations) {
+        std::printf("allocations not counted, build with "
+                    "VISION_COUNT_ALLOCATIONS\n");
+    }
+    return 0;
+}
+
+int RunWhitespaceCheck(const HeadlessOptions& /*options*/) {
+    // what the tokenizer did with a text run before the kernels: drop
+    // newlines, then trim and collapse spaces with a regex
+    const std::regex collapse("^ +| +$|( ) +");
+    auto reference = [&collapse](std::string_view text) {
+        std::string value;
+        for (char c : text) {
+            if (c != '\n') value.push_back(c);
+        }
+        return std::regex_replace(value, collapse, "$1");
+    };
+
+    // mostly whitespace and short words, long enough to cross several
+    // SIMD blocks, with the odd '<' and multibyte character
+    static const char* const kPieces[] = {" ", "  ", "\n", " \n ", "\t",
+                                          "a", "word", "é", "\r", "<"};
+    constexpr int kCases = 200000;
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> length(0, 120);
+    std::uniform_int_distribution<int> piece(0, 9);
+    int mismatches = 0;
+    auto report = [&mismatches](const char* what, std::string_view text) {
+        if (mismatches++ < 10) {
+            std::printf("MISMATCH %s on \"", what);
+            for (char c : text) {
+                if (c == '\n') {
+                    std::printf("\\n");
+                } else {
+                    std::printf("%c", c);
+                }
+            }
+            std::printf("\"\n");
+        }
+    };
+    for (int i = 0; i < kCases; i++) {
+        std::string text;
+        for (int n = length(random); n > 0; n--) text += kPieces[piece(random)];
+
+        // the kernels, on a run that may hold a '<'
+        std::string_view run(text);
+        run = run.substr(0, run.find('<'));
+        bool blank = false;
+        if (ScanTextContent(text, blank) != run.size()) {
+            report("ScanTextContent end", text);
+        }
+        std::string expected = reference(run);
+        if (blank != expected.empty()) report("ScanTextContent blank", text);
+        if (CollapseWhitespace(run) != expected) {
+            report("CollapseWhitespace", text);
+        }
+
+        // the tokenizer, on the run between two tags
+        std::string markup = "<p>" + std::string(run) + "</p>";
+        Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+        std::vector<Token> tokens = tokenizer.Tokenize();
+        bool hasText = tokens.size() > 3 &&
+                       tokens[3].type == TokenType::TextContent;
+        if (hasText == expected.empty() ||
+            (hasText && CollapseWhitespace(tokens[3].value) != expected)) {
+            report("Tokenizer", text);
+        }
+    }
+    std::printf("%d random text runs, %d mismatches against the regex\n",
+                kCases, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+int RunDomBenchmark(const HeadlessOptions& options) {
+    const std::string markup = GenerateWideMarkup();
+    int runs = std::max(options.frames, 5);
+
+    struct Form {
+        const char* name;
+        Clock::duration parse{}, traverse{}, teardown{};
+        uint64_t visited = 0;
+        long peak = -1;
+    };
+    Form tree = {"Element tree"}, flat = {"Document"};
+    // first, while the heap holds no tree yet
+    tree.peak = PeakResidentGrowth([&markup] {
+        Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+        Parser parser(tokenizer);
+        std::shared_ptr<Element> root = parser.Parse();
+    });
+    flat.peak = PeakResidentGrowth([&markup] {
+        Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+        Parser parser(tokenizer);
+        std::unique_ptr<Document> document = parser.ParseDocument();
+    });
+    size_t nodes = 0, documentBytes = 0;
+    for (int run = 0; run < runs; run++) {
+        Clock::time_point start = Clock::now();
+        Tokenizer tokenizer(SourceBuffer::Borrow(markup));
+        Parser parser(tokenizer);
+        std::shared_ptr<Element> root = parser.Parse();
+        Clock::time_point parsed = Clock::now();
+        tree.visited = Traverse(*root);
+        Clock::time_point traversed = Clock::now();
+        root.reset();
+        tree.parse += parsed - start;
+        tree.traverse += traversed - parsed;
+        tree.teardown += Clock::now() - traversed;
+
+        start = Clock::now();
+        Tokenizer flatTokenizer(SourceBuffer::Borrow(markup));
+        Parser flatParser(flatTokenizer);
+        std::unique_ptr<Document> document = flatParser.ParseDocument();
+        parsed = Clock::now();
+        flat.visited = Traverse(*document, document->Root());
+        traversed = Clock::now();
+        nodes = document->NodeCount();
+        documentBytes = document->MemoryUsage();
+        document.reset();
+        flat.parse += parsed - start;
+        flat.traverse += traversed - parsed;
+        flat.teardown += Clock::now() - traversed;
+    }
+    std::printf("%zu nodes, %zu bytes of markup, %d runs, Document uses "
+                "%.1f MB\n",
+                nodes, markup.size(), runs, documentBytes / double(1 << 20));
+    std::printf("%-13s %10s %10s %10s %10s\n", "", "parse", "traverse",
+                "teardown", "peak RSS");
+    for (const Form* form : {&tree, &flat}) {
+        std::printf("%-13s %7.2f ms %7.2f ms %7.2f ms %7.1f MB\n", form->name,
+                    Milliseconds(form->parse) / runs,
+                    Milliseconds(form->traverse) / runs,
+                    Milliseconds(form->teardown) / runs,
+                    form->peak / double(1 << 20));
+    }
+    bool same = tree.visited == flat.visited;
+    std::printf("traversals %s\n", same ? "agree" : "DIFFER");
+    return same ? 0 : 1;
+}
+
+int RunDeclarationBenchmark(const HeadlessOptions& options) {
+    // example.html's block, generated ones of every kind the parser reads,
+    // and malformed ones it has to skip
+    std::vector<std::string> blocks = {
+        "width: 100px; height: 100px; background-color: red; display: flex; "
+        "justify-content: center; align-items: center; color: white; "
+        "font-family: Arial, sans-serif;"};
+    const char* const kNames[] = {"red", "white", "cadetblue", "aqua"};
+    for (int i = 0; i < 1000; i++) {
+        std::string n = std::to_string(i), m = std::to_string(i % 97);
+        blocks.push_back(
+            "width: " + n + "px; height: " + m + ".5%; margin: " + m +
+            "px auto; padding: 1px 2px " + m + "px; border-radius: 4px; "
+            "background-color: #" + std::to_string(100 + i % 900) +
+            "; color: rgba(" + m + ", 20, 30, 0.5); display: flex; "
+            "flex-direction: column; justify-content: space-between; "
+            "align-items: center; font-size: " + m + "px; overflow: hidden");
+        blocks.push_back(std::string("COLOR : ") + kNames[i % 4] +
+                         " ;; width: -" + n + "px; height:;"
+                         " margin: 1px 2px 3px 4px 5px; color: #12345;"
+                         " rgb(1,2); width: 99999999999999px; : ; padding");
+    }
+    size_t bytes = 0, declarations = 0;
+    for (const std::string& block : blocks) {
+        bytes += block.size();
+        declarations += std::count(block.begin(), block.end(), ':');
+    }
+
+    int runs = std::max(options.frames, 100);
+    ComputedStyle style;
+    uint64_t allocated = AllocationCount();
+    Clock::time_point start = Clock::now();
+    for (int run = 0; run < runs; run++) {
+        for (const std::string& block : blocks) {
+            style = ComputedStyle();
+            ParseInlineStyle(block, style);
+        }
+    }
+    double elapsed = Milliseconds(Clock::now() - start);
+    uint64_t allocations = AllocationCount() - allocated;
+
+    // the blocks a stylesheet rule holds, parsed once and applied to many
+    allocated = AllocationCount();
+    start = Clock::now();
+    for (int run = 0; run < runs; run++) {
+        for (const std::string& block : blocks) {
+            DeclarationBlock parsed;
+            ParseDeclarationBlock(block, parsed);
+            parsed.ApplyTo(style);
+        }
+    }
+    double blockElapsed = Milliseconds(Clock::now() - start);
+    allocations += AllocationCount() - allocated;
+
+    double count = double(declarations) * runs;
+    double megabytes = double(bytes) * runs / (1 << 20);
+    std::printf("%zu blocks, %zu declarations, %zu bytes, %d runs\n",
+                blocks.size(), declarations, bytes, runs);
+    std::printf("ParseInlineStyle      %6.1f ns/declaration %8.1f MB/s\n",
+                elapsed * 1e6 / count, megabytes / (elapsed / 1000));
+    std::printf("ParseDeclarationBlock %6.1f ns/declaration %8.1f MB/s\n",
+                blockElapsed * 1e6 / count,
+                megabytes / (blockElapsed / 1000));
+    if (!kCountsAllocations) {
+        std::printf("allocations not counted, build with "
+                    "VISION_COUNT_ALLOCATIONS\n");
+        return 0;
+    }
+    std::printf("%llu allocations\n", (unsigned long long)allocations);
+    return allocations == 0 ? 0 : 1;
+}
+
+int RunRelayoutBenchmark(const HeadlessOptions& options) {
+    constexpr int kRelayoutSections = 100;  // about 10k nodes
+    std::shared_ptr<Element> root = BuildWideDocument(kRelayoutSections);
+    StyleTable styles, fullStyles;
+    LayoutEngine incremental(styles), full(fullStyles);
+    float width = float(options.width), height = float(options.height);
+    incremental.Layout(*root, width, height);
+    full.Layout(*root, width, height);
+    size_t count = styles.Size();
+
+    // one cell per frame grows wider, is hidden, shrinks back or has its
+    // text changed; the rest of its row moves
+    const char* const cellStyles[] = {"padding: 2px 12px;", "display: none;",
+                                      "padding: 2px;"};
+    int frames = std::max(options.frames, 100);
+    Clock::duration incrementalTime{}, fullTime{};
+    uint64_t incrementalNodes = 0, fullNodes = 0;
+    std::vector<LayoutBox> boxes(count), reference(count);
+    int differ = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        Element& section =
+            *root->children[size_t(frame) * 37 % kRelayoutSections];
+        Element& cell = *section.children[size_t(frame) % kSectionRows]
+                             ->children[size_t(frame) % kRowCells];
+        if (frame % 4 == 3) {
+            cell.SetText("changed " + std::to_string(frame));
+        } else {
+            cell.SetAttribute(kAtomStyle, cellStyles[frame % 4]);
+        }
+
+        // the incremental engine goes first, it is the one that reads the
+        // dirty bits
+        Clock::time_point start = Clock::now();
+        incremental.Layout(*root, width, height);
+        incrementalTime += Clock::now() - start;
+        incrementalNodes += incremental.Stats().nodesLaidOut;
+
+        full.Invalidate();
+        start = Clock::now();
+        full.Layout(*root, width, height);
+        fullTime += Clock::now() - start;
+        fullNodes += full.Stats().nodesLaidOut;
+
+        CollectBoxes(*root, incremental, boxes);
+        CollectBoxes(*root, full, reference);
+        differ += !SameBoxes(boxes, reference);
+    }
+
+    double incrementalMs = Milliseconds(incrementalTime) / frames;
+    double fullMs = Milliseconds(fullTime) / frames;
+    std::printf("%zu nodes, %d frames with one element changed\n", count,
+                frames);
+    std::printf("full         %8.3f ms/frame %8llu boxes/frame\n", fullMs,
+                (unsigned long long)(fullNodes / frames));
+    std::printf("incremental  %8.3f ms/frame %8llu boxes/frame  %.0fx\n",
+                incrementalMs,
+                (unsigned long long)(incrementalNodes / frames),
+                incrementalMs > 0 ? fullMs / incrementalMs : 0.0);
+    std::printf("%d of %d frames differ from a full layout\n", differ,
+                frames);
+    return differ == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+
+struct HeadlessOptions {
+    std::string document = "example/example.html";
+    std::string font = "Arial.ttf";
+    std::string output;  // PPM of the last frame, none when empty
+    int width = 1024, height = 768;
+    int frames = 1;
+    bool steady = false;  // keep layout and display list between frames
+    float scrollY = 0;    // page offset painted
+    unsigned layoutThreads = 1;  // of the pipeline's layout, worker included
+};
+
+// Runs parse, layout and paint on the software renderer, with no window or
+// GL context, and prints per-stage timings. Every frame is a full relayout
+// and re-recording unless steady is set, which measures an unchanged page.
+// The document may be markup or compiled, and is painted scrolled down by
+// scrollY. Returns the process exit code.
+int RunHeadless(const HeadlessOptions& options);
+
+// Builds a large grid page, changes one cell's background per frame and
+// paints each frame twice: damaged rectangles only into a retained frame,
+// and in full. Runs at least 120 frames. Prints pixels shaded and paint time
+// for both and checks the two pictures match. Returns the process exit
+// code.
+int RunDamageBenchmark(const HeadlessOptions& options);
+
+// Renders the grid page at 60 Hz on this thread while another thread keeps
+// mutating it through a DocumentPipeline, which parses, lays out and records
+// on its worker, with layoutThreads threads for layout. Each frame also
+// sends a pointer move, and now and then a wheel step, through the
+// pipeline's input. Frames are kept and repainted only where the snapshots
+// shown since changed, and each is checked against a full replay. Runs at
+// least 120 frames. Prints missed frame deadlines, build and render times,
+// pixels repainted and the events listeners saw. Returns the process exit
+// code.
+int RunPipelineStress(const HeadlessOptions& options);
+
+// Lays out a synthetic document of about 100k nodes on thread pools of
+// growing size, checks every box matches single-threaded layout and prints
+// the time and speedup for each. Returns the process exit code.
+int RunLayoutBenchmark(const HeadlessOptions& options);
+
+// Feeds a generated multi-megabyte page to a StreamingParser in chunks that
+// arrive at a fixed rate, laying out and painting the partial tree once per
+// 60 Hz frame, and compares its time to first paint with waiting for the
+// last byte and parsing, laying out and painting in one go. Then feeds
+// options.document in small chunks and checks the tree and diagnostics match
+// Parser's. Returns the process exit code.
+int RunStreamBenchmark(const HeadlessOptions& options);
+
+// Parses the generated page and the given document at least 10 times into
+// both tree forms and prints the best throughput and the diagnostics count.
+// Well-formed input is also parsed by a loop that builds the same Element
+// tree with nothing checked or repaired, and the time Parse() spends over
+// it is printed as the cost of recovery. Returns the process exit code, 1
+// if no input was well-formed.
+int RunParseBenchmark(const HeadlessOptions& options);
+
+// Parses options.document, resolves its styles and writes both as a
+// compiled document to output. Returns the process exit code.
+int RunCompiler(const HeadlessOptions& options, const std::string& output);
+
+// Writes a generated 5 MB page as markup and compiled, then repeatedly loads
+// each into a layout-ready tree and styles, dropping the files from the page
+// cache first where the system allows it. The compiled page is read in place
+// through a CompiledTree. Prints both load times, what copying the page out
+// into Elements would add, and the first layout of each, and checks that
+// the copied tree matches the parsed one and that boxes, the painted
+// picture and hit tests from the mapping match those from the markup.
+// Returns the process exit code.
+int RunLoadBenchmark(const HeadlessOptions& options);
+
+// Wraps 1 MB of generated paragraphs at several widths with a TextLayout:
+// shaping and breaking from scratch, breaking again for a new width with
+// the shaped runs cached, and a repeated width. Returns the process exit
+// code.
+int RunTextBenchmark(const HeadlessOptions& options);
+
+// Resolves the styles of a generated 50k-node page against a <style> block
+// of 2000 rules: inline styles only, every rule tried on every element,
+// rules bucketed by their rightmost key, and buckets with the ancestor
+// filter. Prints the best of options.frames runs with the rules looked at,
+// filtered and matched per node, and checks the matching modes agree.
+// First checks a <style> block written over several lines applies as
+// written. Returns the process exit code.
+int RunStyleBenchmark(const HeadlessOptions& options);
+
+// Resolves generated pages with and without style sharing: example.html's
+// repeated elements, a long list of alike rows styled by a sheet, and the
+// style benchmark's grid, where little is alike. Prints the share of
+// elements that took a candidate's style, resolve times, distinct styles
+// and their memory, and checks sharing changes no style. Returns the
+// process exit code.
+int RunStyleSharingBenchmark(const HeadlessOptions& options);
+
+// Lays out the 100k-node layout benchmark page and hit-tests random points
+// through a HitTestGrid and by walking the tree, checking both find the same
+// element. Then changes one cell per frame and compares updating the grid
+// incrementally with rebuilding it, and dispatches frames of fast pointer
+// input to count the hit tests coalescing leaves. Returns the process exit
+// code.
+int RunHitTestBenchmark(const HeadlessOptions& options);
+
+// Scrolls lists of 1k to 100k rows that paint culls, and of 1k to 1M rows
+// laid out only around the visible window, with the wheel and occasional
+// jumps. Prints per-frame layout, hit grid and paint times with the nodes
+// laid out and commands recorded, which should stay flat as rows grow, and
+// checks hit tests against a tree walk. Returns the process exit code.
+int RunScrollBenchmark(const HeadlessOptions& options);
+
+// Tokenizes options.document repeated 1000 times lazily with Next(), into
+// a vector with Tokenize(), and through Parse() into an element tree, and
+// prints tokens per second, throughput and, in builds with
+// VISION_COUNT_ALLOCATIONS, heap allocations per megabyte of markup for
+// each. Returns the process exit code.
+int RunTokenBenchmark(const HeadlessOptions& options);
+
+// Checks ScanTextContent, CollapseWhitespace and the tokenizer's text runs
+// against the std::regex normalization they replaced, on 200k random runs
+// of spaces, newlines and words. Prints the first mismatches. Returns the
+// process exit code, 1 on any mismatch.
+int RunWhitespaceCheck(const HeadlessOptions& options);
+
+// Parses the layout benchmark page of about 100k nodes into the shared_ptr
+// Element tree and into the arena-backed Document, and prints for each the
+// parse, full traversal and teardown times, and how far parsing raises the
+// peak resident set, measured in a forked child. Returns the process exit
+// code.
+int RunDomBenchmark(const HeadlessOptions& options);
+
+// Parses example.html's inline style, a thousand generated declaration
+// blocks and as many malformed ones, inline and as stylesheet blocks, and
+// prints nanoseconds per declaration and throughput. Returns the process
+// exit code, 1 if parsing allocated in a build with VISION_COUNT_ALLOCATIONS.
+int RunDeclarationBenchmark(const HeadlessOptions& options);
+
+// Changes one element of a generated 10k-node page per frame and lays it
+// out incrementally and from scratch, printing time and boxes recomputed
+// for both. Every frame's boxes must match. Returns the process exit code.
+int RunRelayoutBenchmark(const HeadlessOptions& options);
@@ -0,0 +1,75 @@
+// libFuzzer entry point for Tokenizer, Parser and StreamingParser. Build with
+// -DVISION_BUILD_FUZZERS=ON using clang, then run e.g.
+//     ./parser_fuzzer -max_len=4096 corpus/ fuzz/corpus/parser/ example/
+// fuzz/corpus/parser/ holds seeds for cases random input rarely reaches.
+#include "Core/Parser/Parser.h"
+#include "Core/Parser/SourceBuffer.h"
+#include "Core/Parser/StreamingParser.h"
+#include "Core/Parser/Tokenizer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+bool SameTree(const Element& a, const Element& b) {
+    if (a.tag != b.tag || a.index != b.index || a.innerText != b.innerText ||
+        a.attributes.size() != b.attributes.size() ||
+        a.children.size() != b.children.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.attributes.size(); i++) {
+        if (a.attributes[i].name != b.attributes[i].name ||
+            a.attributes[i].value != b.attributes[i].value) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.children.size(); i++) {
+        if (!SameTree(*a.children[i], *b.children[i])) return false;
+    }
+    return true;
+}
+
+bool SameDiagnostics(const std::vector<ParseDiagnostic>& a,
+                     const std::vector<ParseDiagnostic>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].line != b[i].line || a[i].column != b[i].column ||
+            a[i].message != b[i].message) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string_view input(reinterpret_cast<const char*>(data), size);
+
+    Tokenizer tokenizer(SourceBuffer::Borrow(input));
+    Parser parser(tokenizer);
+    std::shared_ptr<Element> root = parser.Parse();
+
+    // the flat tree takes the other builder through the same grammar
+    Tokenizer flatTokenizer(SourceBuffer::Borrow(input));
+    Parser flatParser(flatTokenizer);
+    flatParser.ParseDocument();
+
+    // however the input is cut, streaming gives Parser's tree and
+    // diagnostics; the first byte picks the chunk size
+    size_t chunkSize = size ? 1 + data[0] % 64 : 1;
+    StreamingParser stream;
+    for (size_t at = 0; at < size; at += chunkSize) {
+        stream.Feed(input.substr(at, std::min(chunkSize, size - at)));
+    }
+    stream.Finish();
+    if (!SameTree(*stream.Root(), *root) ||
+        !SameDiagnostics(stream.Diagnostics(), parser.Diagnostics())) {
+        std::abort();
+    }
+    return 0;
+}
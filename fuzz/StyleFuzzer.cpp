@@ -0,0 +1,38 @@
+// libFuzzer entry point for the CSS declaration parser. Build with
+// -DVISION_BUILD_FUZZERS=ON using clang, then run e.g.
+//     ./style_fuzzer -max_len=512 corpus/
+#include "Core/Style/ComputedStyle.h"
+#include "Core/Style/StyleParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string_view input(reinterpret_cast<const char*>(data), size);
+
+    ComputedStyle style;
+    ParseInlineStyle(input, style);
+
+    DeclarationBlock block;
+    ParseDeclarationBlock(input, block);
+    block.ApplyTo(style);
+
+    // the first colon splits a single declaration
+    size_t colon = input.find(':');
+    if (colon != std::string_view::npos) {
+        ApplyDeclaration(input.substr(0, colon), input.substr(colon + 1),
+                         style);
+    }
+
+    // a length without a minus sign never comes out negative, however
+    // large its number
+    Length length;
+    if (ParseLength(input, length) &&
+        input.find('-') == std::string_view::npos && length.value < 0) {
+        std::abort();
+    }
+    Color color;
+    ParseColor(input, color);
+    return 0;
+}
@@ -1,16 +1,66 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include "Core/Window.h"
+
+enum class FrameMode {
+    Unlocked,   // render back to back, as fast as the loop can go
+    VSync,      // one frame per display refresh
+    FixedRate,  // sleep between frames to hold the target rate
+    OnDemand,   // block on events, render only on input or RequestRedraw()
+};
+
+// Milliseconds spent in each phase of one frame.
+struct FrameTiming {
+    double update = 0;   // OnInput and OnUpdate
+    double layout = 0;   // OnLayout
+    double paint = 0;    // OnRender
+    double present = 0;  // buffer swap, includes any vsync wait
+    double total = 0;
+};
+
 class Application {
    public:
     Application(int width, int height, const std::string& title);
     ~Application();
 
     void Run();  // Main loop
+
+    void SetFrameMode(FrameMode mode, double targetFps = 60);
+    FrameMode GetFrameMode() const { return frameMode; }
+    // Wakes an OnDemand loop for one more frame; safe from any thread.
+    void RequestRedraw();
+
+    const FrameTiming& LastFrameTiming() const { return lastTiming; }
+    FrameTiming AverageFrameTiming() const;  // over the last kTimingWindow
+    uint64_t FramesRendered() const { return framesRendered; }
+
+    static constexpr size_t kTimingWindow = 120;
+
    protected:
     virtual void OnInit() {};    // To be overridden for custom initialization
+    // The input queued since the last frame, coalesced; runs before OnUpdate
+    // and only when there is some.
+    virtual void OnInput(const std::vector<InputEvent>& /*events*/) {}
     virtual void OnUpdate() {};  // Override for updating logic
+    virtual void OnLayout() {};  // Override to lay out before painting
     virtual void OnRender() {};  // Override for custom rendering
+    // Polled by OnDemand after every wakeup, e.g. whether the DOM is dirty.
+    virtual bool NeedsRedraw() { return false; }
     Window* window;
-};
\ No newline at end of file
+
+   private:
+    FrameMode frameMode = FrameMode::VSync;
+    std::chrono::steady_clock::duration framePeriod;
+    std::atomic<bool> redrawRequested{true};
+    uint64_t framesRendered = 0;
+    FrameTiming lastTiming;
+    FrameTiming timings[kTimingWindow];
+
+    double TimeUpdate();  // runs OnInput and OnUpdate, returns milliseconds
+    void RenderFrame(double update);
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator. Allocations are never freed individually; everything goes
+// away at once when the arena is reset or destroyed, so only trivially
+// destructible objects may be placed in it.
+class Arena {
+   public:
+    explicit Arena(size_t blockSize = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void Reset();
+
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        return new (Allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    T* NewArray(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        T* items = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) new (items + i) T();
+        return items;
+    }
+
+    std::string_view CopyString(std::string_view value) {
+        if (value.empty()) return {};
+        char* copy = static_cast<char*>(Allocate(value.size(), 1));
+        std::memcpy(copy, value.data(), value.size());
+        return std::string_view(copy, value.size());
+    }
+
+    size_t BytesAllocated() const { return bytesAllocated; }
+    size_t BytesReserved() const { return bytesReserved; }
+
+   private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t blockSize;
+    size_t bytesAllocated = 0;
+    size_t bytesReserved = 0;
+
+    void Grow(size_t minimum);
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interned tag and attribute name. Two names are equal exactly when their
+// atoms are equal, so matching never touches the characters.
+using Atom = uint32_t;
+constexpr Atom kInvalidAtom = 0xFFFFFFFF;
+
+// Names every table starts with; their atoms are their indices here and are
+// usable as compile-time constants. Append only, ids are baked into callers.
+inline constexpr std::string_view kWellKnownAtomNames[] = {
+    "",
+    // tags
+    "window", "html", "head", "body", "title", "meta", "link", "style", "div",
+    "span", "p", "document", "img", "button", "input",
+    // attributes
+    "id", "class", "name", "content", "charset", "lang", "width", "height",
+    "href", "rel", "src", "type"};
+
+constexpr size_t kWellKnownAtomCount =
+    sizeof(kWellKnownAtomNames) / sizeof(kWellKnownAtomNames[0]);
+
+constexpr Atom FindWellKnownAtom(std::string_view name) {
+    for (size_t i = 0; i < kWellKnownAtomCount; i++) {
+        if (kWellKnownAtomNames[i] == name) return static_cast<Atom>(i);
+    }
+    return kInvalidAtom;
+}
+
+constexpr Atom kAtomEmpty = FindWellKnownAtom("");
+constexpr Atom kAtomWindow = FindWellKnownAtom("window");
+constexpr Atom kAtomHtml = FindWellKnownAtom("html");
+constexpr Atom kAtomHead = FindWellKnownAtom("head");
+constexpr Atom kAtomBody = FindWellKnownAtom("body");
+constexpr Atom kAtomTitle = FindWellKnownAtom("title");
+constexpr Atom kAtomMeta = FindWellKnownAtom("meta");
+constexpr Atom kAtomLink = FindWellKnownAtom("link");
+constexpr Atom kAtomStyle = FindWellKnownAtom("style");
+constexpr Atom kAtomDiv = FindWellKnownAtom("div");
+constexpr Atom kAtomSpan = FindWellKnownAtom("span");
+constexpr Atom kAtomP = FindWellKnownAtom("p");
+constexpr Atom kAtomDocument = FindWellKnownAtom("document");
+constexpr Atom kAtomImg = FindWellKnownAtom("img");
+constexpr Atom kAtomButton = FindWellKnownAtom("button");
+constexpr Atom kAtomInput = FindWellKnownAtom("input");
+constexpr Atom kAtomId = FindWellKnownAtom("id");
+constexpr Atom kAtomClass = FindWellKnownAtom("class");
+constexpr Atom kAtomName = FindWellKnownAtom("name");
+constexpr Atom kAtomContent = FindWellKnownAtom("content");
+constexpr Atom kAtomCharset = FindWellKnownAtom("charset");
+constexpr Atom kAtomLang = FindWellKnownAtom("lang");
+constexpr Atom kAtomWidth = FindWellKnownAtom("width");
+constexpr Atom kAtomHeight = FindWellKnownAtom("height");
+constexpr Atom kAtomHref = FindWellKnownAtom("href");
+constexpr Atom kAtomRel = FindWellKnownAtom("rel");
+constexpr Atom kAtomSrc = FindWellKnownAtom("src");
+constexpr Atom kAtomType = FindWellKnownAtom("type");
+
+// Process-wide, thread-safe intern table. Atoms are never released.
+class AtomTable {
+   public:
+    static AtomTable& Global();
+
+    Atom Intern(std::string_view name);
+    Atom Find(std::string_view name) const;  // kInvalidAtom if not interned
+    std::string_view Name(Atom atom) const;
+    size_t Size() const;
+
+   private:
+    AtomTable();
+
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> storage;  // deque keeps interned bytes in place
+    std::vector<std::string_view> names;
+    std::unordered_map<std::string_view, Atom> ids;
+};
+
+inline Atom InternAtom(std::string_view name) {
+    return AtomTable::Global().Intern(name);
+}
+
+inline Atom FindAtom(std::string_view name) {
+    return AtomTable::Global().Find(name);
+}
+
+inline std::string_view AtomName(Atom atom) {
+    // well-known names never move, so they need no lock
+    if (atom < kWellKnownAtomCount) return kWellKnownAtomNames[atom];
+    return AtomTable::Global().Name(atom);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Core/Arena.h"
+#include "Core/Atom.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+using NodeId = uint32_t;
+constexpr NodeId kInvalidNode = 0xFFFFFFFF;
+
+struct NodeAttribute {
+    Atom name;
+    std::string_view value;
+};
+
+// Flat node record. Links are indices into Document's node array, strings
+// live in the document's arena.
+struct Node {
+    static constexpr uint32_t kInlineAttributes = 2;
+
+    Atom tag = kAtomEmpty;
+    NodeId parent = kInvalidNode;
+    NodeId firstChild = kInvalidNode;
+    NodeId lastChild = kInvalidNode;
+    NodeId nextSibling = kInvalidNode;
+    uint32_t attributeCount = 0;
+    uint32_t attributeCapacity = kInlineAttributes;
+    std::string_view innerText;
+    union {
+        NodeAttribute inlineAttributes[kInlineAttributes];
+        NodeAttribute* spilledAttributes;
+    };
+
+    Node() : inlineAttributes() {}
+
+    const NodeAttribute* Attributes() const {
+        return attributeCapacity > kInlineAttributes ? spilledAttributes
+                                                     : inlineAttributes;
+    }
+};
+
+// Arena-backed alternative to the shared_ptr<Element> tree. Nodes sit in one
+// contiguous array and are addressed by 32-bit NodeId; names are global
+// atoms. Tearing the document down frees the node array and the arena blocks,
+// nothing per node.
+class Document {
+   public:
+    explicit Document(size_t sourceSizeHint = 0);
+
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    NodeId CreateNode(Atom tag);
+    void AppendChild(NodeId parent, NodeId child);
+    void SetAttribute(NodeId node, Atom name, std::string_view value);
+    void AppendText(NodeId node, std::string_view text);
+
+    NodeId Root() const { return nodes.empty() ? kInvalidNode : 0; }
+    size_t NodeCount() const { return nodes.size(); }
+    const Node& GetNode(NodeId id) const { return nodes[id]; }
+    std::string_view Name(NodeId id) const { return AtomName(nodes[id].tag); }
+    std::string_view GetAttribute(NodeId id, Atom name) const;
+    bool HasAttribute(NodeId id, Atom name) const;
+
+    size_t MemoryUsage() const;
+
+   private:
+    Arena arena;
+    std::vector<Node> nodes;
+
+    const NodeAttribute* FindAttribute(NodeId id, Atom name) const;
+};
@@ -1,31 +1,117 @@
 #pragma once
 
+#include "Core/Atom.h"
+#include <cstdint>
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 #include <vector>
+
+struct ElementAttribute {
+    Atom name;
+    std::string value;
+};
+
+enum ElementDirtyFlags : uint8_t {
+    kDirtyStyle = 1 << 0,        // own style must be re-resolved
+    kDirtyLayout = 1 << 1,       // own box must be recomputed
+    kDirtyDescendants = 1 << 2,  // something below this element is dirty
+    // the same two for snapshot copies, which layout never clears
+    kDirtyCopy = 1 << 3,
+    kDirtyCopyDescendants = 1 << 4,
+};
+
 class Element : public std::enable_shared_from_this<Element> {
    public:
-    std::string name;
-    std::unordered_map<std::string, std::string> attributes;
+    Atom tag = kAtomEmpty;
+    uint32_t index = 0;  // document order, keys the per-node tables
+    uint8_t dirty = kDirtyStyle | kDirtyLayout | kDirtyCopy;
+    std::vector<ElementAttribute> attributes;
     std::string innerText;
     std::vector<std::shared_ptr<Element>> children;
     std::weak_ptr<Element> parent;
 
     Element() = default;
-    Element(const std::string& name) : name(name) {}
+    Element(Atom tag) : tag(tag) {}
+    Element(std::string_view name) : tag(InternAtom(name)) {}
+
+    std::string_view Name() const { return AtomName(tag); }
+
+    // Deep copy of the subtree with the same indices; the copy starts clean.
+    std::shared_ptr<Element> Clone() const {
+        auto copy = std::make_shared<Element>(tag);
+        copy->index = index;
+        copy->dirty = 0;
+        copy->attributes = attributes;
+        copy->innerText = innerText;
+        copy->children.reserve(children.size());
+        for (const auto& child : children) {
+            auto childCopy = child->Clone();
+            childCopy->parent = copy;
+            copy->children.push_back(std::move(childCopy));
+        }
+        return copy;
+    }
 
     void AddChild(const std::shared_ptr<Element>& child) {
         child->parent = shared_from_this();
         children.push_back(child);
+        MarkDirty(kDirtyLayout | kDirtyDescendants);
+    }
+
+    // Flags this element and tells every ancestor that a descendant changed,
+    // stopping at the first ancestor that already knows. Any change also
+    // outdates the element's snapshot copy.
+    void MarkDirty(uint8_t flags = kDirtyStyle | kDirtyLayout) {
+        constexpr uint8_t below = kDirtyDescendants | kDirtyCopyDescendants;
+        dirty |= flags | kDirtyCopy;
+        for (auto ancestor = parent.lock();
+             ancestor && (ancestor->dirty & below) != below;
+             ancestor = ancestor->parent.lock()) {
+            ancestor->dirty |= below;
+        }
+    }
+
+    void SetText(std::string text) {
+        innerText = std::move(text);
+        MarkDirty(kDirtyLayout);
+    }
+
+    // Elements carry a handful of attributes, a linear scan over atoms beats
+    // hashing the key.
+    const ElementAttribute* FindAttribute(Atom key) const {
+        for (const ElementAttribute& attribute : attributes) {
+            if (attribute.name == key) return &attribute;
+        }
+        return nullptr;
+    }
+
+    bool HasAttribute(Atom key) const { return FindAttribute(key) != nullptr; }
+
+    bool HasAttribute(std::string_view key) const {
+        return HasAttribute(FindAtom(key));
+    }
+
+    const std::string& GetAttribute(Atom key) const {
+        static const std::string empty;
+        const ElementAttribute* attribute = FindAttribute(key);
+        return attribute ? attribute->value : empty;
     }
 
-    bool HasAttribute(const std::string& key) const {
-        return attributes.find(key) != attributes.end();
+    const std::string& GetAttribute(std::string_view key) const {
+        return GetAttribute(FindAtom(key));
     }
 
-    std::string GetAttribute(const std::string& key) const {
-        auto iter = attributes.find(key);
-        return iter != attributes.end() ? iter->second : "";
+    void SetAttribute(Atom key, std::string value) {
+        for (ElementAttribute& attribute : attributes) {
+            if (attribute.name == key) {
+                attribute.value = std::move(value);
+                MarkDirty();
+                return;
+            }
+        }
+        attributes.push_back({key, std::move(value)});
+        MarkDirty();
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <algorithm>
+
+struct Rect {
+    float x = 0, y = 0, width = 0, height = 0;
+
+    bool IsEmpty() const { return width <= 0 || height <= 0; }
+    bool Intersects(const Rect& other) const {
+        return x < other.x + other.width && other.x < x + width &&
+               y < other.y + other.height && other.y < y + height;
+    }
+    Rect Intersect(const Rect& other) const {
+        float left = std::max(x, other.x), top = std::max(y, other.y);
+        float right = std::min(x + width, other.x + other.width);
+        float bottom = std::min(y + height, other.y + other.height);
+        return {left, top, std::max(right - left, 0.0f),
+                std::max(bottom - top, 0.0f)};
+    }
+    Rect Union(const Rect& other) const {
+        float left = std::min(x, other.x), top = std::min(y, other.y);
+        float right = std::max(x + width, other.x + other.width);
+        float bottom = std::max(y + height, other.y + other.height);
+        return {left, top, right - left, bottom - top};
+    }
+};
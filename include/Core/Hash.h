@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a, for cache keys and change signatures. Start from kHashSeed
+// and fold in bytes or whole words; the result is the same on every run, so
+// keys may be stored on disk.
+constexpr uint64_t kHashSeed = 14695981039346656037ull;
+constexpr uint64_t kHashPrime = 1099511628211ull;
+
+inline uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= kHashPrime;
+    }
+    return hash;
+}
+
+// The bytes of a value without padding, e.g. a Color or a float.
+template <typename T>
+uint64_t HashValue(uint64_t hash, const T& value) {
+    return HashBytes(hash, &value, sizeof(value));
+}
+
+// One step for a whole word, cheaper than its bytes when a key is built
+// from fields.
+constexpr uint64_t HashWord(uint64_t hash, uint64_t word) {
+    return (hash ^ word) * kHashPrime;
+}
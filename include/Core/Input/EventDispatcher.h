@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Core/Element.h"
+#include "Core/Input/HitTestGrid.h"
+#include "Core/Input/InputEvent.h"
+#include "Core/Layout/LayoutEngine.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+enum class EventType : uint8_t {
+    MouseMove,
+    MouseDown,
+    MouseUp,
+    Click,
+    MouseOver,  // the pointer entered the target, relatedTarget left
+    MouseOut,   // the pointer left the target for relatedTarget
+    Wheel,
+    KeyDown,
+    KeyUp,
+    Char,
+};
+
+enum class EventPhase : uint8_t { Capture, Target, Bubble };
+
+struct Event {
+    EventType type;
+    EventPhase phase = EventPhase::Target;
+    std::shared_ptr<Element> target;
+    std::shared_ptr<Element> currentTarget;  // whose listener is running
+    std::shared_ptr<Element> relatedTarget;  // MouseOver and MouseOut only
+    float x = 0, y = 0;
+    int button = 0;
+    int key = 0;
+    int mods = 0;
+    uint32_t codepoint = 0;
+    float scrollX = 0, scrollY = 0;
+
+    // The other listeners of currentTarget still run, no element after it.
+    void StopPropagation() { stopped = true; }
+    bool PropagationStopped() const { return stopped; }
+    // Keeps the dispatcher from acting on the event, such as scrolling.
+    void PreventDefault() { prevented = true; }
+    bool DefaultPrevented() const { return prevented; }
+
+   private:
+    bool stopped = false;
+    bool prevented = false;
+};
+
+using EventListener = std::function<void(Event&)>;
+using ListenerId = uint32_t;
+
+struct DispatchStats {
+    uint64_t inputEvents = 0;  // taken from the window
+    uint64_t moves = 0;        // pointer moves left after coalescing
+    uint64_t hitTests = 0;
+    uint64_t events = 0;     // Events dispatched
+    uint64_t listeners = 0;  // listener calls
+};
+
+// Turns a frame's window input into element events. Pointer events go to
+// the element a HitTestGrid finds under the pointer, keys to the element
+// last pressed on, or the root. Each event travels like in the DOM: down
+// from the root through the target's ancestors to capture listeners, to the
+// target's own listeners, then back up to the others. The path is read from
+// Element::parent when the event fires.
+//
+// Only the last pointer move of a frame is dispatched: hovering follows the
+// pointer at most once per frame, and buttons hit-test where they happened.
+// A press moves the hover there first, so MouseOver still precedes it.
+//
+// A Wheel event no listener prevented scrolls the nearest clipping box
+// around the target that can still move that way, else the page.
+//
+// Listeners are kept by Element::index; an element that leaves the tree
+// keeps them until they are removed.
+class EventDispatcher {
+   public:
+    ListenerId AddEventListener(const Element& element, EventType type,
+                                EventListener listener, bool capture = false);
+    void RemoveEventListener(ListenerId id);
+
+    // grid must be up to date with root's layout. Wheel events scroll
+    // nothing without a layout.
+    void Dispatch(const std::vector<InputEvent>& events,
+                  const HitTestGrid& grid,
+                  const std::shared_ptr<Element>& root,
+                  LayoutEngine* layout = nullptr);
+    // Fires event at event.target through the three phases.
+    void DispatchEvent(Event& event);
+
+    std::shared_ptr<Element> Hovered() const { return hovered.lock(); }
+    std::shared_ptr<Element> Focused() const { return focused.lock(); }
+
+    const DispatchStats& Stats() const { return stats; }
+    void ResetStats() { stats = DispatchStats(); }
+
+   private:
+    struct Listener {
+        ListenerId id;
+        EventType type;
+        bool capture;
+        EventListener callback;
+    };
+
+    std::vector<std::vector<Listener>> listeners;  // by Element::index
+    std::unordered_map<ListenerId, uint32_t> owners;
+    ListenerId nextId = 1;
+    std::weak_ptr<Element> hovered, pressed, focused;
+    DispatchStats stats;
+
+    void MoveHover(const std::shared_ptr<Element>& target,
+                   const InputEvent& input);
+    // False when a listener prevented the default.
+    bool Fire(EventType type, const std::shared_ptr<Element>& target,
+              const InputEvent& input);
+    void Scroll(const std::shared_ptr<Element>& target,
+                const InputEvent& input, LayoutEngine& layout);
+    void Notify(Event& event, Element& element);
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Core/Document.h"
+#include "Core/Element.h"
+#include "Core/Geometry.h"
+#include "Core/Layout/LayoutEngine.h"
+#include "Core/Style/StyleTable.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CompiledTree;
+
+struct HitTestStats {
+    uint32_t boxes = 0;   // elements in the index
+    uint32_t moved = 0;   // by the last Update(): added, moved or removed
+    uint32_t large = 0;   // kept out of the cells, see HitTestGrid
+    uint32_t layers = 0;  // clipping boxes with cells of their own
+    size_t cellEntries = 0;
+};
+
+// Uniform grid over the absolute border boxes of a laid-out tree, Element
+// or compiled, so the element under the pointer is found from the few boxes
+// in one cell instead of a walk over the tree. An element is hit where its
+// box contains the point; of several, the one painted last wins, which is
+// the last in tree order. display: none subtrees are not in it.
+//
+// The page is one layer of cells in page coordinates, the viewport's scroll
+// added to the pointer. Every clipping box holds its content in a layer of
+// its own, relative to its unscrolled border box, which a query only enters
+// where the box contains the point: scrolling one moves no boxes, and what
+// it clips out cannot be hit. Of a virtualized block only the rows laid out
+// are indexed.
+//
+// Update() follows layout incrementally. A subtree LayoutEngine has not
+// recomputed since the last update, still at the same place, is skipped
+// whole; below the boxes it does visit, only boxes that moved, appeared or
+// went away touch the cells. A layout generation it has already seen costs
+// nothing. Boxes covering more than kMaxCellsPerBox cells, such as the
+// page, sit in a short list every query checks instead of in thousands of
+// cells.
+class HitTestGrid {
+   public:
+    static constexpr float kDefaultCellSize = 64;
+    static constexpr uint32_t kMaxCellsPerBox = 256;
+
+    explicit HitTestGrid(float cellSize = kDefaultCellSize);
+
+    void Update(Element& root, const LayoutEngine& layout,
+                const StyleTable& styles);
+    void Update(const CompiledTree& tree, const LayoutEngine& layout);
+    void Clear();
+
+    // Null when nothing is under the point or the element is gone, and
+    // always for a compiled tree.
+    std::shared_ptr<Element> HitTest(float x, float y) const;
+    // The index of the node under the point, its NodeId in a compiled tree;
+    // kInvalidNode for none.
+    NodeId HitTestNode(float x, float y) const;
+    const HitTestStats& Stats() const { return stats; }
+
+   private:
+    struct Entry {
+        std::weak_ptr<Element> element;  // of an Element tree only
+        const void* raw = nullptr;       // identity only, never followed
+        Rect bounds;         // in its layer
+        uint32_t order = 0;  // pre-order position, hidden nodes counted
+        uint32_t stamp = 0;  // last Update() that saw it, 0 when not indexed
+        uint32_t layer = 0;  // the one it is in
+        uint32_t inner = 0;  // the one its content is in, 0 when it has none
+        int left = 0, top = 0, right = 0, bottom = 0;  // cells, inclusive
+        uint32_t parent = 0;    // element index it was last indexed under
+        uint32_t children = 0;  // of its children, those indexed
+        bool large = false;
+        bool inCells = false;
+    };
+
+    static constexpr uint32_t kNoOwner = ~0u;
+
+    struct Layer {
+        // index of the clipping box, kNoOwner for the page and free layers
+        uint32_t owner = kNoOwner;
+        float scrollX = 0, scrollY = 0;
+        std::vector<uint32_t> largeBoxes;
+    };
+
+    float cellSize;
+    std::vector<Entry> entries;  // by node index
+    // element indices by layer and cell
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+    std::vector<Layer> layers;  // 0 is the page
+    std::vector<uint32_t> freeLayers;
+    std::vector<uint32_t> indexed;  // element indices with stamp != 0
+    uint64_t generation = 0;
+    // orders [first, last) of the subtrees the last Update() skipped
+    std::vector<std::pair<uint32_t, uint32_t>> skipped;
+    uint32_t stamp = 0;
+    bool built = false;
+    bool sweep = false;  // whether this Update() may have lost elements
+    HitTestStats stats;
+
+    template <typename Tree>
+    void UpdateTree(const Tree& tree, typename Tree::Node root,
+                    const LayoutEngine& layout);
+    // False when the node is hidden.
+    template <typename Tree>
+    bool Visit(const Tree& tree, typename Tree::Node node,
+               const LayoutEngine& layout, uint64_t seen, uint32_t layer,
+               float parentX, float parentY, uint32_t& order);
+    bool Skipped(uint32_t order) const;
+    int Cell(float position) const;
+    void Insert(uint32_t index);
+    void Remove(uint32_t index);
+    uint32_t AddLayer(uint32_t owner);
+    void ReleaseLayer(Entry& entry);
+    // The entry with the highest order at x, y in layer, or best. The
+    // layer's origin is where its 0, 0 is on screen.
+    const Entry* Find(uint32_t layer, float x, float y, float originX,
+                      float originY, const Entry* best) const;
+    const Entry* Top(float x, float y) const;  // what is hit, or null
+};
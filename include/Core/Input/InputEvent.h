@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+enum class InputEventType : uint8_t {
+    MouseMove,
+    MouseDown,
+    MouseUp,
+    Scroll,
+    KeyDown,  // also sent for key repeats
+    KeyUp,
+    Char,
+};
+
+// One window event as GLFW reported it, queued by the Window until the frame
+// takes it. Positions are in window coordinates, buttons, keys and mods are
+// GLFW's values.
+struct InputEvent {
+    InputEventType type;
+    float x = 0, y = 0;  // pointer position, also for buttons and scroll
+    int button = 0;
+    int key = 0;
+    int mods = 0;
+    uint32_t codepoint = 0;
+    float scrollX = 0, scrollY = 0;
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "Core/Document.h"
+#include "Core/Element.h"
+#include "Core/Geometry.h"
+#include "Core/Style/StyleTable.h"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class CompiledTree;
+class ThreadPool;
+
+struct LayoutBox {
+    float x = 0, y = 0;  // border-box offset from the parent's border box
+    float width = 0, height = 0;
+    Rect text;  // the element's text run, relative to this box
+    // Everything the subtree paints, relative to this box: the box, its
+    // text and whatever of its descendants sticks out, unless it clips.
+    Rect overflow;
+    // Clipping boxes only: the offset their content is scrolled by and the
+    // size of that content, padding included.
+    float scrollX = 0, scrollY = 0;
+    float scrollWidth = 0, scrollHeight = 0;
+};
+
+struct TextSize {
+    float width = 0, height = 0;
+};
+
+// Measures a run of text wrapped at maxWidth.
+using TextMeasurer = std::function<TextSize(std::string_view text,
+                                            float fontSize, float maxWidth)>;
+
+struct LayoutStats {
+    uint32_t stylesResolved = 0;
+    uint32_t nodesLaidOut = 0;  // boxes recomputed
+    uint32_t nodesReused = 0;   // clean subtrees whose cached box was kept
+};
+
+// Block and flexbox layout over an Element tree, or a CompiledTree read in
+// place (see Core/TreeAccess.h). Boxes live in an array parallel to the
+// nodes, by index, and the calls taking a NodeId read them for either.
+// Layout() only revisits elements carrying dirty bits, and a clean subtree
+// under unchanged constraints keeps its box, so changing one attribute
+// relayouts that subtree and its ancestor chain. Nothing here touches GL;
+// it runs headless.
+//
+// With a thread pool, a block whose subtree holds at least two grains of
+// nodes lays its children out as parallel tasks of at least grainSize nodes
+// each. Children only touch their own subtree's boxes, so the result is
+// the same as on one thread. The text measurer must then be safe to call
+// from several threads at once.
+//
+// Boxes with overflow: hidden or scroll clip their children and can be
+// scrolled, as can the viewport over the page. A virtualize: rows block
+// with a definite height takes its children to be rows as tall as the
+// first and lays out only the ones in view plus half a view above and
+// below, so its cost does not grow with the row count.
+class LayoutEngine {
+   public:
+    explicit LayoutEngine(StyleTable& styles);
+
+    static constexpr uint32_t kDefaultGrainSize = 1024;
+
+    void SetTextMeasurer(TextMeasurer measurer);
+    // null lays out on the calling thread only
+    void SetThreadPool(ThreadPool* pool,
+                       uint32_t grainSize = kDefaultGrainSize);
+    void Layout(Element& root, float viewportWidth, float viewportHeight);
+    // The stored styles are used as they are, nothing is resolved.
+    void Layout(CompiledTree& tree, float viewportWidth,
+                float viewportHeight);
+    void Invalidate();  // drop cached boxes and styles, next Layout is full
+    // Like Invalidate(), for a new tree whose styles are already in the
+    // table and whose elements carry no kDirtyStyle, such as one built by
+    // CompiledDocument: the next Layout is full but resolves nothing.
+    void AdoptStyles();
+
+    const LayoutBox& GetBox(NodeId id) const { return nodes[id].box; }
+    const LayoutBox& GetBox(const Element& element) const {
+        return GetBox(element.index);
+    }
+    // In page coordinates, the scroll offsets of the ancestors applied.
+    Rect GetAbsoluteBox(const Element& element) const;
+    // Children [first, end) of element have boxes from the last Layout():
+    // all of them, except in a virtualized block.
+    std::pair<size_t, size_t> LaidOutChildren(const Element& element) const {
+        return ChildRange(element.index, element.children.size());
+    }
+    template <typename Tree>
+    std::pair<size_t, size_t> LaidOutChildren(
+        const Tree& tree, typename Tree::ConstNode node) const {
+        return ChildRange(tree.Index(node), tree.ChildCount(node));
+    }
+    // Whether the tops and bottoms of those children's overflow rectangles
+    // never decrease in child order, as in a block's normal flow, so the
+    // ones crossing any horizontal band are a contiguous run.
+    bool ChildrenSortedByY(NodeId id) const {
+        return nodes[id].childrenSorted;
+    }
+    bool ChildrenSortedByY(const Element& element) const {
+        return ChildrenSortedByY(element.index);
+    }
+
+    // The part of the page on screen: the viewport's size, at the offset
+    // it is scrolled to.
+    const Rect& Viewport() const { return viewport; }
+    // Offsets are clamped to the content, and Generation() moves when they
+    // change. Scrolling a virtualized block past the rows laid out marks it
+    // for the next Layout(). Both return whether anything moved.
+    bool ScrollViewportTo(float x, float y);
+    bool ScrollTo(Element& element, float x, float y);
+    bool ScrollTo(CompiledTree& tree, NodeId id, float x, float y);
+    const LayoutStats& Stats() const { return stats; }
+    // Bumped by every Layout() that restyled or moved a box; equal values
+    // mean the painted result cannot have changed.
+    uint64_t Generation() const { return generation; }
+    // The Generation() whose Layout() last recomputed element's box. Boxes
+    // in a subtree only change when its root's does, so a subtree whose root
+    // is older than generation g is laid out as it was at g, relative to the
+    // root.
+    uint64_t BoxGeneration(NodeId id) const {
+        return nodes[id].boxGeneration;
+    }
+    uint64_t BoxGeneration(const Element& element) const {
+        return BoxGeneration(element.index);
+    }
+    // Nodes in element's subtree, element included, hidden ones too.
+    uint32_t SubtreeSize(NodeId id) const { return nodes[id].subtreeSize; }
+    uint32_t SubtreeSize(const Element& element) const {
+        return SubtreeSize(element.index);
+    }
+
+   private:
+    struct Constraint {
+        float availableWidth;   // containing block content width
+        float availableHeight;  // < 0 when the containing height is indefinite
+        float forcedWidth;      // border-box size imposed by a flex parent
+        float forcedHeight;     // < 0 when not imposed
+
+        bool operator==(const Constraint& other) const {
+            return availableWidth == other.availableWidth &&
+                   availableHeight == other.availableHeight &&
+                   forcedWidth == other.forcedWidth &&
+                   forcedHeight == other.forcedHeight;
+        }
+    };
+
+    struct NodeLayout {
+        LayoutBox box;
+        Constraint constraint = {-1, -1, -1, -1};
+        bool valid = false;
+        float naturalHeight = 0;  // height before any flex stretch
+        float intrinsicWidth = 0;
+        uint32_t intrinsicPass = 0;  // 0 when intrinsicWidth is stale
+        uint32_t subtreeSize = 1;    // nodes, counted by UpdateStyles
+        uint64_t boxGeneration = 0;
+        // children laid out, fewer than all in a virtualized block only
+        uint32_t firstChild = 0, endChild = kAllChildren;
+        float rowsTop = 0, rowHeight = 0;  // of a virtualized block
+        bool childrenSorted = false;  // see ChildrenSortedByY()
+    };
+
+    static constexpr uint32_t kAllChildren = ~0u;
+
+    StyleTable& styles;
+    TextMeasurer measureText;
+    ThreadPool* pool = nullptr;
+    uint32_t grainSize = kDefaultGrainSize;
+    std::vector<NodeLayout> nodes;
+    uint32_t pass = 0;
+    uint64_t generation = 0;
+    Rect viewport;
+    uint32_t rootIndex = 0;
+    bool invalidated = true;
+    LayoutStats stats;
+
+    std::pair<size_t, size_t> ChildRange(uint32_t index,
+                                         size_t childCount) const {
+        const NodeLayout& node = nodes[index];
+        return {std::min<size_t>(node.firstChild, childCount),
+                std::min<size_t>(node.endChild, childCount)};
+    }
+    NodeLayout& Slot(uint32_t index);
+
+    // The walks, for either tree; Node is the tree's node handle.
+    template <typename Tree>
+    void LayoutRoot(Tree& tree, typename Tree::Node root, float viewportWidth,
+                    float viewportHeight, bool restyle);
+    template <typename Tree>
+    bool ScrollNode(Tree& tree, typename Tree::Node node, float x, float y);
+    template <typename Tree>
+    uint32_t UpdateStyles(Tree& tree, typename Tree::Node node,
+                          const ComputedStyle& parent, bool parentChanged);
+    // counts is the stats of whichever task runs the call
+    template <typename Tree>
+    const LayoutBox& LayoutNode(Tree& tree, typename Tree::Node node,
+                                const Constraint& constraint,
+                                LayoutStats& counts);
+    template <typename Tree>
+    float LayoutBlock(Tree& tree, typename Tree::Node node,
+                      const ComputedStyle& style, float contentWidth,
+                      float contentHeight, float left, float top,
+                      LayoutStats& counts);
+    template <typename Tree>
+    void LayoutChildren(Tree& tree, typename Tree::Node node,
+                        const Constraint& constraint, LayoutStats& counts);
+    template <typename Tree>
+    float LayoutRows(Tree& tree, typename Tree::Node node, float contentWidth,
+                     float contentHeight, float left, float top, float y,
+                     LayoutStats& counts);
+    // Sets the overflow and scroll extent of a laid out box whose content
+    // ends at contentBottom.
+    template <typename Tree>
+    void FinishOverflow(Tree& tree, typename Tree::Node node,
+                        const ComputedStyle& style, float contentBottom);
+    template <typename Tree>
+    float LayoutFlex(Tree& tree, typename Tree::Node node,
+                     const ComputedStyle& style, float contentWidth,
+                     float contentHeight, float left, float top,
+                     LayoutStats& counts);
+    template <typename Tree>
+    float IntrinsicWidth(Tree& tree, typename Tree::Node node);
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Core/Atom.h"
+#include "Core/Document.h"
+#include "Core/Element.h"
+#include "Core/Parser/SourceBuffer.h"
+#include "Core/Style/ComputedStyle.h"
+#include "Core/Style/StyleTable.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Precompiled form of a parsed document and its resolved styles, written
+// once by WriteCompiledDocument() and read from a read-only mapping. Every
+// section is a flat array in host byte order addressed by its offset from
+// the start of the file, so nothing points anywhere and the accessors below
+// read the mapping in place. Nodes are in document order, a node's id is its
+// Element::index.
+//
+// Layout, paint and hit testing read the mapping in place through
+// CompiledTree (Core/TreeAccess.h), so opening a document for them is the
+// header and bounds check and nothing per node beyond it. A document that
+// has to change, like the app's, is copied out into Elements with
+// BuildElementTree().
+//
+// All strings, names included, sit once in a shared byte block, and equal
+// styles are stored once, as most nodes share theirs with many others.
+// Atoms are process-local, so the file stores name indices and opening it
+// interns the few distinct names. A file from another version, or whose
+// styles were written with a different ComputedStyle layout, does not open.
+constexpr char kCompiledMagic[4] = {'V', 'D', 'O', 'C'};
+constexpr uint32_t kCompiledVersion = 3;
+
+struct CompiledString {
+    uint32_t offset, length;  // into the string bytes
+};
+
+struct CompiledHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t styleSize;  // sizeof(ComputedStyle) of the writer
+    uint32_t nodeCount;
+    uint32_t attributeCount;
+    uint32_t styleCount;
+    uint32_t nameCount;
+    uint64_t fileSize;
+    uint64_t nodesOffset;       // CompiledNode[nodeCount]
+    uint64_t childrenOffset;    // uint32_t[nodeCount - 1], node ids
+    uint64_t attributesOffset;  // CompiledAttribute[attributeCount]
+    uint64_t stylesOffset;      // ComputedStyle[styleCount], each distinct
+    uint64_t namesOffset;       // CompiledString[nameCount]
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+// The parent is a node id. The children are a run of the child list, in
+// order, so the i-th is found without walking its siblings; they always
+// come after their node.
+struct CompiledNode {
+    uint32_t name;
+    uint32_t parent;
+    uint32_t firstChild;  // into the child list
+    uint32_t childCount;
+    uint32_t firstAttribute;
+    uint32_t attributeCount;
+    uint32_t style;  // index into the styles
+    CompiledString text;
+};
+
+struct CompiledAttribute {
+    uint32_t name;
+    CompiledString value;
+};
+
+// Writes root's tree and its resolved styles. Nodes are numbered in
+// document order, which is how Parser numbers them. Returns false if the
+// file cannot be written.
+bool WriteCompiledDocument(const Element& root, const StyleTable& styles,
+                           const std::string& path);
+
+class CompiledDocument {
+   public:
+    CompiledDocument() = default;
+
+    // Checks the header and every link and string bound once; on failure
+    // the result is not open.
+    static CompiledDocument Open(SourceBuffer source);
+    static CompiledDocument Open(const std::string& path) {
+        return Open(SourceBuffer::Map(path));
+    }
+    static bool IsCompiled(std::string_view bytes);  // magic only
+
+    bool IsOpen() const { return header != nullptr; }
+
+    NodeId Root() const { return NodeCount() ? 0 : kInvalidNode; }
+    size_t NodeCount() const { return header ? header->nodeCount : 0; }
+    Atom Tag(NodeId id) const { return atoms[nodes[id].name]; }
+    NodeId Parent(NodeId id) const { return nodes[id].parent; }
+    size_t ChildCount(NodeId id) const { return nodes[id].childCount; }
+    NodeId Child(NodeId id, size_t i) const {
+        return children[nodes[id].firstChild + i];
+    }
+    std::string_view Text(NodeId id) const { return View(nodes[id].text); }
+    std::string_view GetAttribute(NodeId id, Atom name) const;
+    const ComputedStyle& Style(NodeId id) const {
+        return styles[nodes[id].style];
+    }
+
+    // Fills the table with the stored styles, ready for
+    // LayoutEngine::AdoptStyles().
+    void LoadStyles(StyleTable& table) const;
+    // Element tree for a document that will change, the same one the markup
+    // parses to. Allocates every element and copies its attributes and
+    // text, O(n) in the document. With cleanStyles the elements carry no
+    // kDirtyStyle, for use with LoadStyles().
+    std::shared_ptr<Element> BuildElementTree(bool cleanStyles = false) const;
+
+   private:
+    SourceBuffer source;
+    const CompiledHeader* header = nullptr;
+    const CompiledNode* nodes = nullptr;
+    const uint32_t* children = nullptr;
+    const CompiledAttribute* attributes = nullptr;
+    const ComputedStyle* styles = nullptr;
+    const char* strings = nullptr;
+    std::vector<Atom> atoms;  // by name index
+
+    std::string_view View(CompiledString string) const {
+        return std::string_view(strings + string.offset, string.length);
+    }
+};
@@ -0,0 +1,352 @@
+#pragma once
+
+#include "Core/Atom.h"
+#include "Core/Element.h"
+#include "Core/Parser/Tokenizer.h"
+#include "Core/Parser/Whitespace.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Creates Elements for MarkupGrammar, indexed in document order.
+class ElementBuilder {
+   public:
+    using Node = std::shared_ptr<Element>;
+
+    Node Create(Atom tag) {
+        Node element = std::make_shared<Element>(tag);
+        element->index = nextIndex++;
+        return element;
+    }
+    void SetAttribute(Node& element, Atom key, std::string_view value) {
+        element->SetAttribute(key, std::string(value));
+    }
+    void AppendText(Node& element, std::string_view text) {
+        CollapseWhitespace(text, element->innerText);
+    }
+    void AppendRawText(Node& element, std::string_view text) {
+        element->innerText.append(text);
+    }
+    void AppendChild(Node& parent, Node child) { parent->AddChild(child); }
+
+    uint32_t Count() const { return nextIndex; }
+
+   private:
+    uint32_t nextIndex = 0;
+};
+
+constexpr size_t kMaxMarkupDepth = 256;  // deeper content is dropped
+
+// Elements that never have children or an end tag.
+inline bool IsVoidElement(Atom tag) {
+    return tag == kAtomMeta || tag == kAtomLink || tag == kAtomImg ||
+           tag == kAtomInput;
+}
+
+// Receives each repair with the byte offset of the token it is about.
+using MarkupReporter = std::function<void(size_t offset, std::string message)>;
+
+// The recovering markup grammar of Parser and StreamingParser, fed one token
+// at a time so a pull tokenizer and a push scanner share it. Open elements
+// sit on an explicit stack and a node is attached as soon as its start tag
+// is complete, so the tree is usable between tokens.
+//
+// Malformed markup is repaired the way browsers do it: end tags close open
+// elements up to the one they name, stray end tags and unexpected tokens
+// are dropped, and elements still open at the end are closed. Attribute
+// values may be unquoted or missing. meta, link, img and input never have
+// children. Content nested deeper than kMaxMarkupDepth is dropped. Input
+// without a root element yields an empty window element. Comments and
+// declarations are the caller's to skip. The raw text of <style> is kept as
+// written, other text has its whitespace folded.
+//
+// Builder supplies node creation: Create(tag), SetAttribute(), AppendText(),
+// AppendRawText() and AppendChild() on its Node type.
+template <typename Builder>
+class MarkupGrammar {
+   public:
+    using Node = typename Builder::Node;
+
+    MarkupGrammar(Builder& builder, MarkupReporter report)
+        : builder(builder), report(std::move(report)) {}
+
+    void Feed(const Token& token) {
+        while (!Step(token)) {
+        }
+    }
+
+    // End of input at offset: closes whatever is still open and returns the
+    // root.
+    Node Finish(size_t offset) {
+        Feed(Token(TokenType::EndOfFile, {}, offset));
+        return root;
+    }
+
+    // Whether the root start tag is complete, and then the root so far.
+    bool HasRoot() const { return phase != Phase::BeforeRoot; }
+    const Node& Root() const { return root; }
+    // The root element is closed; anything after it is ignored.
+    bool IsComplete() const { return phase == Phase::AfterRoot; }
+
+   private:
+    enum class Phase : uint8_t { BeforeRoot, InRoot, AfterRoot };
+
+    enum class State : uint8_t {
+        Content,
+        TagName,         // after '<'
+        Attributes,      // start tag, between attributes
+        AfterKey,        // attribute name, '=' may follow
+        Value,           // after '='
+        CloseName,       // after '</'
+        CloseEnd,        // end tag name, '>' should follow
+        Skipping,        // content too deep, until its end tag
+        SkippingName,    // after '<' inside skipped content
+        SkippingTag,     // a start tag inside skipped content
+        SkippingClose,   // the end tag of the skipped element
+        SkippingCloseEnd,
+    };
+
+    struct OpenElement {
+        Node node;
+        Atom tag;
+    };
+
+    Builder& builder;
+    MarkupReporter report;
+    Phase phase = Phase::BeforeRoot;
+    State state = State::Content;
+    Node root{};
+    Node pending{};  // start tag not complete yet
+    Atom pendingTag = kInvalidAtom;
+    Atom attributeKey = kInvalidAtom;
+    Atom closeTag = kInvalidAtom;
+    std::string closeName;  // as written, for the diagnostic
+    size_t tagStart = 0, closeStart = 0;  // offsets of '<' and '</'
+    size_t skipDepth = 0;
+    bool skipLeaf = false;  // the skipped start tag has no end tag
+    bool reportedBefore = false, reportedAfter = false;
+    std::vector<OpenElement> open;
+
+    // Returns false when the token was not taken and goes to the new state.
+    bool Step(const Token& token) {
+        TokenType type = token.type;
+        if (phase == Phase::AfterRoot) {
+            if (type != TokenType::EndOfFile && !reportedAfter) {
+                report(token.offset,
+                       "Content after the root element is ignored");
+                reportedAfter = true;
+            }
+            return true;
+        }
+
+        switch (state) {
+            case State::Content:
+                if (type == TokenType::OpenTagStart) {
+                    tagStart = token.offset;
+                    state = State::TagName;
+                } else if (type == TokenType::EndOfFile) {
+                    End(token.offset);
+                } else if (phase == Phase::BeforeRoot) {
+                    if (!reportedBefore) {
+                        report(token.offset,
+                               "Content before the root element is ignored");
+                        reportedBefore = true;
+                    }
+                } else if (type == TokenType::CloseTagStart) {
+                    closeStart = token.offset;
+                    closeTag = kInvalidAtom;
+                    closeName.clear();
+                    state = State::CloseName;
+                } else if (type == TokenType::TextContent) {
+                    builder.AppendText(open.back().node, token.value);
+                } else if (type == TokenType::RawText) {
+                    builder.AppendRawText(open.back().node, token.value);
+                } else {
+                    report(token.offset, "Unexpected token in content");
+                }
+                return true;
+
+            case State::TagName:
+                if (type != TokenType::Identifier) {
+                    report(tagStart, "Expected a tag name after '<'");
+                    state = State::Content;
+                    return false;
+                }
+                pendingTag = InternAtom(token.value);
+                pending = builder.Create(pendingTag);
+                state = State::Attributes;
+                return true;
+
+            case State::Attributes:
+                if (type == TokenType::Identifier) {
+                    attributeKey = InternAtom(token.value);
+                    state = State::AfterKey;
+                } else if (type == TokenType::Equals ||
+                           type == TokenType::QuotedString) {
+                    report(token.offset, "Expected an attribute name");
+                } else if (type == TokenType::SelfTagEnd) {
+                    EndStartTag(true);
+                } else if (type == TokenType::TagEnd) {
+                    EndStartTag(false);
+                } else {
+                    report(token.offset,
+                           "Expected '>' to end <" +
+                               std::string(AtomName(pendingTag)) + ">");
+                    EndStartTag(false);
+                    return false;
+                }
+                return true;
+
+            case State::AfterKey:
+                // `key` alone is a boolean attribute
+                if (type == TokenType::Equals) {
+                    state = State::Value;
+                    return true;
+                }
+                builder.SetAttribute(pending, attributeKey, {});
+                state = State::Attributes;
+                return false;
+
+            case State::Value:
+                state = State::Attributes;
+                if (type == TokenType::QuotedString ||
+                    type == TokenType::Identifier) {
+                    builder.SetAttribute(pending, attributeKey, token.value);
+                    return true;
+                }
+                report(token.offset, "Expected an attribute value");
+                builder.SetAttribute(pending, attributeKey, {});
+                return false;
+
+            case State::CloseName:
+                state = State::CloseEnd;
+                if (type != TokenType::Identifier) return false;
+                // well-formed markup closes the innermost element, which
+                // needs no lookup; only a mismatch is reported by name
+                if (!open.empty() && AtomName(open.back().tag) == token.value) {
+                    closeTag = open.back().tag;
+                } else {
+                    closeName.assign(token.value);
+                    closeTag = FindAtom(token.value);
+                }
+                return true;
+
+            case State::CloseEnd:
+                state = State::Content;
+                if (type == TokenType::TagEnd) {
+                    EndTag();
+                    return true;
+                }
+                report(token.offset, "Expected '>' after closing tag");
+                EndTag();
+                return false;
+
+            case State::Skipping:
+                if (type == TokenType::OpenTagStart) {
+                    state = State::SkippingName;
+                } else if (type == TokenType::CloseTagStart &&
+                           --skipDepth == 0) {
+                    state = State::SkippingClose;
+                } else if (type == TokenType::EndOfFile) {
+                    state = State::Content;
+                    return false;
+                }
+                return true;
+
+            case State::SkippingName:
+                // no name, no element, as outside skipped content
+                if (type != TokenType::Identifier) {
+                    state = State::Skipping;
+                    return false;
+                }
+                skipLeaf = IsVoidElement(FindAtom(token.value));
+                state = State::SkippingTag;
+                return true;
+
+            case State::SkippingTag:
+                // counts nesting by '>' alone, the depth is what is too
+                // big; void elements never close, so they do not nest
+                if (type == TokenType::TagEnd && !skipLeaf) skipDepth++;
+                if (type == TokenType::TagEnd ||
+                    type == TokenType::SelfTagEnd) {
+                    state = State::Skipping;
+                } else if (type == TokenType::EndOfFile) {
+                    state = State::Content;
+                    return false;
+                }
+                return true;
+
+            case State::SkippingClose:
+                // the end tag of the skipped element, whatever it names
+                state = State::SkippingCloseEnd;
+                return type == TokenType::Identifier;
+
+            case State::SkippingCloseEnd:
+                state = State::Content;
+                return type == TokenType::TagEnd;
+        }
+        return true;
+    }
+
+    void EndStartTag(bool selfClosing) {
+        Atom tag = pendingTag;
+        Node node = std::move(pending);
+        pending = Node{};
+        state = State::Content;
+        if (phase == Phase::BeforeRoot) {
+            root = node;
+            phase = Phase::InRoot;
+        } else {
+            builder.AppendChild(open.back().node, node);
+        }
+
+        if (selfClosing || IsVoidElement(tag)) {
+            if (open.empty()) phase = Phase::AfterRoot;
+            return;
+        }
+        if (open.size() >= kMaxMarkupDepth) {
+            report(tagStart, "Elements nested too deep, content dropped");
+            skipDepth = 1;
+            state = State::Skipping;
+            return;
+        }
+        open.push_back({std::move(node), tag});
+    }
+
+    void EndTag() {
+        auto named = std::find_if(
+            open.rbegin(), open.rend(),
+            [this](const OpenElement& element) {
+                return element.tag == closeTag;
+            });
+        if (closeTag == kInvalidAtom || named == open.rend()) {
+            report(closeStart, "Unexpected </" + closeName + ">, ignored");
+            return;
+        }
+        for (auto element = open.rbegin(); element != named; ++element) {
+            report(closeStart,
+                   "Missing </" + std::string(AtomName(element->tag)) + ">");
+        }
+        open.erase(named.base() - 1, open.end());
+        if (open.empty()) phase = Phase::AfterRoot;
+    }
+
+    void End(size_t offset) {
+        for (auto element = open.rbegin(); element != open.rend(); ++element) {
+            report(offset, "Missing </" + std::string(AtomName(element->tag)) +
+                               "> at end of input");
+        }
+        open.clear();
+        if (phase == Phase::BeforeRoot) {
+            report(offset, "No root element");
+            root = builder.Create(kAtomWindow);
+        }
+        phase = Phase::AfterRoot;
+    }
+};
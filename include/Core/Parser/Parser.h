@@ -1,24 +1,51 @@
 #pragma once
 
+#include "Core/Document.h"
 #include "Core/Element.h"
+#include "Core/Parser/MarkupGrammar.h"
 #include "Core/Parser/Tokenizer.h"
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
+
+struct ParseDiagnostic {
+    uint32_t line, column;  // 1-based, column in bytes
+    std::string message;
+};
+
+// Never throws. Malformed markup is repaired as MarkupGrammar describes, and
+// each repair is reported as a diagnostic. Comments and declarations such as
+// <!DOCTYPE> are skipped. StreamingParser runs the same grammar over markup
+// that arrives in pieces.
 class Parser {
    public:
+    static constexpr size_t kMaxDepth = kMaxMarkupDepth;
+    static constexpr size_t kMaxDiagnostics = 100;
+
     Parser(Tokenizer& tokenizer)
         : m_Tokenizer(tokenizer), m_CurrentToken(tokenizer.CurrentToken()) {}
 
     std::shared_ptr<Element> Parse();
+    std::unique_ptr<Document> ParseDocument();  // flat, arena-backed tree
+
+    const std::vector<ParseDiagnostic>& Diagnostics() const {
+        return m_Diagnostics;
+    }
 
    private:
     Tokenizer& m_Tokenizer;
     Token m_CurrentToken;
+    std::vector<ParseDiagnostic> m_Diagnostics;
+    // line counting resumes from the previous diagnostic
+    size_t m_LineCursor = 0, m_LineStart = 0;
+    uint32_t m_Line = 1;
 
-    void Advance();
-    bool Match(TokenType type);
-    void Expect(TokenType type, const std::string& err);
+    void SkipMarkupDeclarations();
+    void Report(size_t offset, std::string message);
 
-    std::shared_ptr<Element> ParseElement();
-    void ParseAttributes(std::shared_ptr<Element>& element);
-    void ParseChildren(std::shared_ptr<Element>& parent);
-};
\ No newline at end of file
+    // Feeds the tokens to the grammar; Builder supplies node creation and is
+    // only instantiated inside Parser.cpp.
+    template <typename Builder>
+    typename Builder::Node ParseRoot(Builder& builder);
+};
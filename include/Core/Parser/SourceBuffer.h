@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view over markup source. The bytes either come from a
+// memory-mapped file (released on destruction) or from a caller-owned buffer
+// that must outlive the SourceBuffer and every token sliced from it.
+class SourceBuffer {
+   public:
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+    SourceBuffer(SourceBuffer&& other) noexcept;
+    SourceBuffer& operator=(SourceBuffer&& other) noexcept;
+
+    static SourceBuffer Map(const std::string& filename);
+    static SourceBuffer Borrow(std::string_view buffer);
+
+    bool IsOpen() const { return isOpen; }
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+    std::string_view View() const { return std::string_view(data, size); }
+
+   private:
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t mappedSize = 0;  // non-zero when data is owned by an mmap
+    bool isOpen = false;
+
+    void Release();
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Core/Element.h"
+#include "Core/Parser/MarkupGrammar.h"
+#include "Core/Parser/Parser.h"
+#include "Core/Parser/Tokenizer.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Push parser for markup that arrives in pieces, e.g. from a pipe. Feed()
+// takes the next chunk in any size; an element is attached to the tree as
+// soon as its start tag is complete, and text as soon as the next tag
+// begins, so the partial tree can be laid out and painted between chunks.
+//
+// The scanner is a state machine that produces the same tokens as Tokenizer
+// however the input is cut, keeping a token cut by a chunk boundary in a
+// small buffer and carrying on from there, so no byte is scanned twice. The
+// tokens go through Parser's MarkupGrammar: the tree and the diagnostics
+// come out as Parser's for the whole input. Never throws.
+class StreamingParser {
+   public:
+    StreamingParser();
+
+    void Feed(std::string_view chunk);
+    void Finish();  // end of input, closes whatever is still open
+
+    // Null until the first start tag is complete; after Finish() never null.
+    const std::shared_ptr<Element>& Root() const { return grammar.Root(); }
+    bool IsComplete() const { return grammar.IsComplete(); }  // root closed
+    uint32_t ElementCount() const { return builder.Count(); }
+    uint64_t BytesFed() const { return bytesFed; }
+    const std::vector<ParseDiagnostic>& Diagnostics() const {
+        return diagnostics;
+    }
+
+   private:
+    enum class State : uint8_t {
+        Markup,           // between tokens
+        Text,             // after '>', up to the next '<'
+        LessThan,         // after '<'
+        Slash,            // '/' between tokens, "/>" or skipped
+        Identifier,
+        IdentifierSlash,  // '/' in an identifier, "/>" would end it
+        QuotedString,
+        DeclarationOpen,  // "<!", a comment if "--" follows
+        Declaration,      // up to '>'
+        Comment,          // up to "-->"
+        RawText,          // <style> content, up to kRawTextEnd
+    };
+
+    // Where a token began, for diagnostics about it.
+    struct Mark {
+        size_t offset = 0;
+        uint32_t line = 1, column = 1;
+    };
+
+    ElementBuilder builder;
+    MarkupGrammar<ElementBuilder> grammar;
+    std::vector<ParseDiagnostic> diagnostics;
+
+    State state = State::Markup;
+    std::string_view chunk;  // being fed
+    uint64_t chunkStart = 0;  // offset of chunk[0] in the input
+    uint64_t bytesFed = 0;
+    bool done = false;  // a token after the root was read, the rest is not
+    bool finished = false;
+
+    // the token being scanned: where it began, where its part in this chunk
+    // begins, and the parts from earlier chunks
+    Mark tokenMark, tagMark, closeMark, slashMark;
+    size_t tokenBegin = 0;
+    std::string partial;
+    bool textBlank = true;
+    char quote = 0;
+    uint8_t dashes = 0;  // in a row, for "<!--" and "-->"
+    RawTextStart rawTextStart;
+    bool rawTextNext = false;  // the last token ended <style>
+    size_t endMatched = 0;  // bytes of kRawTextEnd seen, from endMark on
+    Mark endMark;
+
+    // newlines are counted up to each token start
+    uint64_t lineCursor = 0, lineStart = 0;
+    uint32_t line = 1;
+
+    size_t Scan(size_t position);
+    size_t ScanMarkup(size_t position);
+    size_t ScanIdentifier(size_t position);
+    size_t ScanComment(size_t position);
+    size_t ScanRawText(size_t position);
+    size_t EndRawText(size_t end);
+    void Begin(size_t position);
+    void BeginText(size_t position);
+    std::string_view Value(size_t end);
+    void Emit(TokenType type, std::string_view value, Mark mark);
+    void EndToken();  // at the end of input
+    Mark Locate(uint64_t offset);
+    void Report(size_t offset, std::string message);
+};
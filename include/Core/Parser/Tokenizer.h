@@ -1,6 +1,9 @@
 #pragma once
 
+#include "Core/Parser/SourceBuffer.h"
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <vector>
 enum class TokenType {
     OpenTagStart,   // `<tag`
@@ -9,41 +12,94 @@ enum class TokenType {
     SelfTagEnd,     // `/>`
     Identifier,     // tag names and attribute names
     Equals,         // `=`
-    QuotedString,   // `"value"`
+    QuotedString,   // `"value"` or `'value'`
     TextContent,    // text between tags
+    RawText,        // <style> content up to `</style`, kept as written
+    Comment,        // `<!-- ... -->`, the whole slice
+    Declaration,    // `<!DOCTYPE ...>` or `<?...?>`, the whole slice
     NewLine,        // NewLine character
     Space,          // empty space
     EndOfFile,
 };
 
+// A token is a slice of the tokenizer's source buffer and is only valid
+// while that buffer is alive. TextContent is the raw slice, whitespace is not
+// normalized here.
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
+    size_t offset;  // byte offset of value in the source
 
-    Token(TokenType type, const std::string& value)
-        : type(type), value(value) {}
+    Token(TokenType type, std::string_view value, size_t offset)
+        : type(type), value(value), offset(offset) {}
 };
 
+// The end of raw text; the tokens of the end tag begin at its '<'.
+constexpr std::string_view kRawTextEnd = "</style";
+
+// Follows the tokens of a start tag and tells when a <style> start tag has
+// ended, after which the content is raw text: no markup, comments or
+// whitespace folding up to kRawTextEnd.
+class RawTextStart {
+   public:
+    // Returns true for the '>' that ends <style ...>.
+    bool Feed(TokenType type, std::string_view value) {
+        bool tagName = afterOpen;
+        afterOpen = type == TokenType::OpenTagStart;
+        if (type == TokenType::Identifier && tagName) {
+            style = value == "style";
+            return false;
+        }
+        if (type == TokenType::Identifier || type == TokenType::Equals ||
+            type == TokenType::QuotedString) {
+            return false;  // attributes
+        }
+        bool starts = style && type == TokenType::TagEnd;
+        style = false;
+        return starts;
+    }
+
+   private:
+    bool afterOpen = false, style = false;
+};
+
+// Produces tokens lazily, one per Next() call, straight out of the source
+// buffer without copying. Any input is tokenized without reading past the
+// buffer: an unterminated string, comment, declaration or <style> content
+// runs to the end.
 class Tokenizer {
    public:
+    // Memory-maps the file; a missing file tokenizes as empty, see IsOpen().
     explicit Tokenizer(const std::string& filename);
-    void Reset() { position = 0; }
+    explicit Tokenizer(SourceBuffer source);
+    void Reset();
     Token Next();
     Token CurrentToken();
-    std::vector<Token> Tokenize();
+    std::vector<Token> Tokenize();  // drains the remaining tokens
     void Show();  // temporary function to view all the tokens;
-    char Current();
-    char Peek();          // peek the next character
-    char PeekPrevious();  // peek the previous character
-    void Move(unsigned int step);
-    void ProcessString();
-    void ProcessIdentifier();
-    void ProcessTextContent();
-    Token Last();
+    std::string_view Source() const { return source.View(); }
+    bool IsOpen() const { return source.IsOpen(); }
 
    private:
-    unsigned int position = 0;  // current char position
-    unsigned int token_position = 0;
-    std::string source;
-    std::vector<Token> tokens;
-};
\ No newline at end of file
+    size_t position = 0;  // current char position
+    bool started = false;
+    bool inText = false;  // the last token was `>`, text content may follow
+    bool inRawText = false;  // the last token ended <style>
+    RawTextStart rawTextStart;
+    SourceBuffer source;
+    Token current = Token(TokenType::EndOfFile, {}, 0);
+
+    bool AtEnd() const { return position >= source.Size(); }
+    char Current() const { return source.Data()[position]; }
+    char Peek() const;  // peek the next character, '\0' past the end
+    void Move(size_t step) { position += step; }
+    Token Slice(TokenType type, size_t start, size_t length) const;
+
+    Token Scan();
+    Token ScanToken();
+    Token ProcessString(char quote);
+    Token ProcessIdentifier();
+    Token ProcessMarkupDeclaration();
+    bool ProcessTextContent(Token& token);
+    Token ProcessRawText();
+};
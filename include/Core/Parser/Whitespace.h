@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Text-node whitespace kernels. Each has an AVX2, SSE2 and NEON path picked at
+// compile time, and a scalar fallback (forced with VISION_DISABLE_SIMD).
+
+// Returns the index of the first '<' in text, or text.size() if there is none.
+// blank is set when every byte before that index is a space or a newline.
+size_t ScanTextContent(std::string_view text, bool& blank);
+
+// Appends text to out with newlines removed, leading and trailing spaces
+// trimmed and runs of spaces collapsed to a single space. Equivalent to
+// stripping '\n' and then applying regex_replace("^ +| +$|( ) +", "$1").
+void CollapseWhitespace(std::string_view text, std::string& out);
+std::string CollapseWhitespace(std::string_view text);
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Core/Element.h"
+#include "Core/Geometry.h"
+#include "Core/Input/EventDispatcher.h"
+#include "Core/Input/HitTestGrid.h"
+#include "Core/Input/InputEvent.h"
+#include "Core/Layout/LayoutEngine.h"
+#include "Core/Pipeline/TripleBuffer.h"
+#include "Core/Render/Damage.h"
+#include "Core/Render/DisplayList.h"
+#include "Core/Style/StyleTable.h"
+#include "Core/Text/GlyphCache.h"
+#include "Core/Text/TextLayout.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+// Everything the render thread needs for one version of the document. It
+// is written by the worker only and never changes once published.
+struct DocumentSnapshot {
+    uint64_t sequence = 0;  // 0 until the first snapshot is published
+    // A copy the worker never touches. Subtrees nothing changed in are shared
+    // with the previous snapshots, so the copy has no parent links.
+    std::shared_ptr<const Element> root;
+    StyleTable styles;  // resolved styles only, for Get()
+    std::vector<Rect> boxes;  // absolute border boxes by Element::index
+    DisplayList list;
+    // What changed on screen since the last snapshot the render thread
+    // acquired, the ones it never saw included; the whole viewport for a
+    // new document or size.
+    DamageRegion damage;
+    uint64_t glyphGeneration = 0;  // glyph cache generation list was made at
+    float width = 0, height = 0;
+    double buildMs = 0;  // parse, layout and paint time of this version
+};
+
+struct PipelineStats {
+    uint64_t mutations = 0;  // applied on the worker
+    uint64_t builds = 0;     // snapshots published
+    uint64_t parseErrors = 0;  // parser diagnostics, also on stderr
+    uint64_t inputEvents = 0;  // window events dispatched on the worker
+};
+
+using DocumentMutation = std::function<void(Element& root)>;
+
+// Runs parsing, style resolution, layout and paint recording on a worker
+// thread and hands the results to the render thread as snapshots through a
+// TripleBuffer, so a long parse or relayout never blocks a frame.
+//
+// The live tree belongs to the worker: other threads change it only through
+// Mutate(), whose callbacks run on the worker in submission order. Pending
+// mutations are drained together, so a burst costs one layout. New elements
+// need their index set like the parser does.
+//
+// Window input goes to the worker the same way, through Input(). It is
+// hit-tested against the last layout, the one on screen, before the
+// mutations submitted with it run, and dispatched to the listeners of
+// Dispatcher(). A wheel event no listener prevented scrolls the page or a
+// clipping box, which publishes a new snapshot.
+//
+// Recording rasterizes glyphs, which writes the shared atlas. The worker
+// holds GlyphLock() while recording; the render thread must hold it while
+// replaying and uploading, and skip a snapshot whose glyphGeneration is
+// behind the cache, as evicted glyphs may have been overwritten.
+//
+// Each snapshot carries its damage, so a render thread that keeps the last
+// frame only repaints what changed. The damage of a snapshot that was
+// acquired and then skipped is the render thread's to add to the next.
+//
+// Publishing copies the tree only where elements were marked dirty since
+// the last snapshot. The boxes are still copied whole, a flat array, and so
+// are the style pointers: styles are shared, but taking each one's
+// reference is an atomic increment per element.
+class DocumentPipeline {
+   public:
+    DocumentPipeline(GlyphCache* glyphs = nullptr, FontId font = kInvalidFont);
+    ~DocumentPipeline();
+
+    DocumentPipeline(const DocumentPipeline&) = delete;
+    DocumentPipeline& operator=(const DocumentPipeline&) = delete;
+
+    // Any thread.
+    void Load(const std::string& path);  // markup or a compiled document
+    void SetDocument(std::shared_ptr<Element> root);
+    void Mutate(DocumentMutation mutation);
+    void Input(std::vector<InputEvent> events);
+    void SetViewport(float width, float height);
+    // Lays out on a pool of this many threads, the worker included; 1, the
+    // default, keeps layout on the worker. See LayoutEngine::SetThreadPool.
+    void SetLayoutThreads(unsigned threads);
+    // Runs on the worker after each publish, e.g. to wake the render loop.
+    void SetPublishCallback(std::function<void()> callback);
+    void WaitIdle();  // until everything submitted so far is published
+    std::mutex& GlyphLock() { return glyphLock; }
+    PipelineStats Stats() const;
+
+    // Worker only, e.g. from a Mutate() callback or a listener. A new
+    // document starts without listeners.
+    EventDispatcher& Dispatcher() { return dispatcher; }
+
+    // Render thread. Acquire() moves to the newest published snapshot and
+    // returns true if there was one; Snapshot() stays valid until the next
+    // Acquire().
+    bool Acquire() { return snapshots.Acquire(); }
+    bool HasNewSnapshot() const { return snapshots.HasFresh(); }
+    const DocumentSnapshot& Snapshot() const { return snapshots.Front(); }
+
+   private:
+    GlyphCache* glyphs;
+    FontId font;
+    std::unique_ptr<TextLayout> text;  // worker only once running
+    std::mutex glyphLock;
+
+    // requests, guarded by mutex
+    mutable std::mutex mutex;
+    std::condition_variable wake, idle;
+    std::string pendingPath;
+    std::shared_ptr<Element> pendingRoot;
+    std::vector<DocumentMutation> pendingMutations;
+    std::vector<InputEvent> pendingInput;
+    float pendingWidth = 0, pendingHeight = 0;
+    unsigned pendingThreads = 1;
+    std::function<void()> publishCallback;
+    uint64_t submitted = 0, completed = 0;
+    bool stopping = false;
+    PipelineStats stats;
+
+    // worker only
+    std::shared_ptr<Element> root;
+    StyleTable styles;
+    LayoutEngine layout{styles};
+    unsigned layoutThreads = 1;
+    std::unique_ptr<ThreadPool> pool;
+    HitTestGrid grid;
+    EventDispatcher dispatcher;
+    DamageTracker tracker;
+    DamageRegion lastDamage;  // of the last published snapshot
+    float width = 0, height = 0;
+    uint64_t sequence = 0;
+    // the latest copy of each element by Element::index, with the element
+    // it was made from
+    struct ElementCopy {
+        const Element* source = nullptr;
+        std::shared_ptr<Element> copy;
+    };
+    std::vector<ElementCopy> copies;
+
+    TripleBuffer<DocumentSnapshot> snapshots;
+    std::thread worker;
+
+    void Submit(std::unique_lock<std::mutex>& lock);
+    void Run();
+    void Build(std::chrono::steady_clock::time_point start, bool full);
+    std::shared_ptr<Element> Copy(Element& element);
+};
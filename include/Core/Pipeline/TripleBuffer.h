@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer handoff of the latest value. The producer
+// fills Back() and publishes it; the consumer takes whatever was published
+// last and keeps reading it until it acquires again. Neither side waits:
+// the three slots rotate through one atomic word, and a value published
+// while the consumer is still reading the previous one simply replaces the
+// unread middle slot. Slots are reused, so their buffers keep capacity.
+template <typename T>
+class TripleBuffer {
+   public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side.
+    T& Back() { return slots[back]; }
+    void Publish() {
+        uint8_t previous =
+            middle.exchange(uint8_t(back | kFresh), std::memory_order_acq_rel);
+        back = previous & kIndex;
+    }
+
+    // Consumer side. Returns true when a newer value was published since the
+    // last call; Front() stays valid until the next Acquire().
+    bool Acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & kFresh)) return false;
+        uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & kIndex;
+        return true;
+    }
+    const T& Front() const { return slots[front]; }
+    // Whether Acquire() would return true, without taking the value.
+    bool HasFresh() const {
+        return middle.load(std::memory_order_relaxed) & kFresh;
+    }
+
+   private:
+    static constexpr uint8_t kIndex = 3;
+    static constexpr uint8_t kFresh = 4;  // middle holds an unread value
+
+    T slots[3];
+    uint8_t back = 0;   // producer only
+    uint8_t front = 1;  // consumer only
+    std::atomic<uint8_t> middle{2};
+};
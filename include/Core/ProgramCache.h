@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct ProgramCacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t rejected = 0;  // cached binaries the driver refused
+    uint32_t stored = 0;
+    double loadMs = 0;     // restoring binaries on hits
+    double compileMs = 0;  // compiling and linking on misses
+    double savedMs = 0;    // compile time recorded for hits, minus loadMs
+};
+
+// On-disk cache of linked program binaries, keyed by a hash of both shader
+// sources and the driver's vendor, renderer and version strings, so a
+// driver update simply misses. Uses glGetProgramBinary/glProgramBinary and
+// stays disabled until SetDirectory() is called, or when the driver offers
+// no binary formats. Needs a current GL context.
+class ProgramCache {
+   public:
+    static ProgramCache& Global();
+
+    void SetDirectory(const std::string& directory);
+    bool Enabled();
+
+    // The program restored from disk, or 0 on a miss or a rejected binary.
+    unsigned int Load(const std::string& vertexCode,
+                      const std::string& fragmentCode);
+    // Called before glLinkProgram so the driver keeps the binary around.
+    void MarkRetrievable(unsigned int program);
+    void Store(unsigned int program, const std::string& vertexCode,
+               const std::string& fragmentCode, double compileMs);
+
+    const ProgramCacheStats& Stats() const { return stats; }
+
+   private:
+    std::string directory;
+    int supported = -1;  // -1 until the driver has been asked
+    ProgramCacheStats stats;
+
+    std::string PathFor(uint64_t key) const;
+};
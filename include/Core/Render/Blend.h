@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Core/Style/ComputedStyle.h"
+#include <cstddef>
+#include <cstdint>
+
+// Span kernels behind the software renderer. Pixels are RGBA8 in memory
+// order. Every code path rounds the same way, so output does not depend on
+// the instruction set the build targets.
+
+uint32_t PackPixel(Color color);
+
+// Overwrites count pixels with color.
+void FillSpan(uint32_t* dst, size_t count, Color color);
+
+// Blends color over count pixels like glBlendFunc(GL_SRC_ALPHA,
+// GL_ONE_MINUS_SRC_ALPHA). coverage, when given, scales the alpha per pixel.
+void BlendSpan(uint32_t* dst, size_t count, Color color,
+               const uint8_t* coverage = nullptr);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Core/Geometry.h"
+#include <cstdint>
+#include <vector>
+
+// Screen area that must be repainted, kept as a few whole-pixel rectangles.
+// Overlapping rectangles merge; past kMaxRects the pair whose union wastes
+// the least area merges, so a scattered update still costs a few scissored
+// passes.
+class DamageRegion {
+   public:
+    static constexpr size_t kMaxRects = 8;
+
+    void Add(const Rect& rect);
+    void Add(const DamageRegion& other);  // the union of both
+    void SetFull(float width, float height);
+    void Clear();
+
+    bool IsEmpty() const { return rects.empty(); }
+    bool IsFull() const { return full; }
+    float Area() const;
+    const std::vector<Rect>& Rects() const { return rects; }
+
+   private:
+    std::vector<Rect> rects;
+    bool full = false;
+};
+
+// Remembers what every element painted last time: its bounds and a hash of
+// everything that decides its pixels. Recording the tree again reports the
+// old and new bounds of each element whose entry changed, appeared or went
+// away.
+class DamageTracker {
+   public:
+    // nodes sizes the table for the tree up front, so elements met far apart
+    // do not grow it piece by piece.
+    void BeginRecord(uint32_t nodes = 0);
+    void Paint(uint32_t index, const Rect& bounds, uint64_t signature);
+    void EndRecord(DamageRegion& damage);
+    void Reset() {
+        entries.clear();
+        painted.clear();
+    }
+
+   private:
+    struct Entry {
+        Rect bounds;
+        uint64_t signature = 0;
+        uint32_t stamp = 0;  // recording that last painted it, 0 for never
+    };
+
+    std::vector<Entry> entries;  // by Element::index
+    std::vector<uint32_t> painted;  // indices with stamp != 0
+    std::vector<Rect> changed;
+    uint32_t stamp = 0;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Core/Render/Damage.h"
+#include "Core/Renderer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class DisplayOp : uint8_t {
+    Rect,
+    RoundedRect,
+    GlyphRun,
+    PushClip,
+    PopClip
+};
+
+struct DisplayListStats {
+    uint32_t commands = 0;
+    uint32_t batches = 0;  // state runs in the last Replay()
+};
+
+// One frame of paint commands, recorded flat: each command is a one byte
+// opcode followed by its payload in a single byte buffer, and consecutive
+// glyphs of one color share a run. DisplayList is itself a Renderer, so any
+// paint code records into it; Replay() plays it onto a real backend.
+//
+// Replay groups commands by pipeline state, solid fills apart from atlas
+// glyphs. A command only moves ahead of commands it does not overlap and
+// never across a clip, so the picture is the same with fewer state changes.
+class DisplayList : public Renderer {
+   public:
+    RendererBackend Backend() const override {
+        return RendererBackend::Recording;
+    }
+
+    // Starts a new recording; the size and clear color are the replay
+    // target's business.
+    void BeginFrame(int width, int height, Color clearColor) override;
+    void FillRect(float x, float y, float width, float height, Color color,
+                  float radius = 0) override;
+    void DrawGlyph(float x0, float y0, float x1, float y1,
+                   const AtlasRegion& region, Color color) override;
+    void PushClip(const Rect& clip) override;
+    void PopClip() override;
+    void EndFrame() override {}
+
+    void Clear();
+    // Issues the commands only, the caller begins and ends the frame.
+    void Replay(Renderer& renderer) const;
+    // Repaints only the damaged rectangles of a frame that still holds the
+    // previous picture: each is clipped to, cleared with the opaque
+    // clearColor and drawn with the commands that touch it.
+    void Replay(Renderer& renderer, const DamageRegion& damage,
+                Color clearColor) const;
+
+    bool IsEmpty() const { return bytes.empty(); }
+    size_t ByteSize() const { return bytes.size(); }
+    const DisplayListStats& Stats() const { return stats; }
+
+   private:
+    struct RectPayload {
+        Rect rect;
+        Color color;
+        float radius;
+    };
+
+    struct GlyphRunHeader {
+        Color color;
+        uint32_t count;
+        Rect bounds;
+    };
+
+    struct GlyphQuad {
+        float x0, y0, x1, y1;
+        AtlasRegion region;
+    };
+
+    // A decoded command, in replay order once batched.
+    struct Command {
+        uint32_t offset;  // payload offset in bytes
+        uint32_t batch;
+        DisplayOp op;
+        Rect bounds;  // empty for clips
+    };
+
+    static constexpr size_t kNoRun = ~size_t(0);
+
+    std::vector<uint8_t> bytes;
+    size_t runOffset = kNoRun;  // header of the glyph run still open
+    mutable DisplayListStats stats;
+    mutable std::vector<Command> commands;
+
+    template <typename T>
+    size_t Append(DisplayOp op, const T& payload);
+    template <typename T>
+    T Read(size_t offset) const;
+
+    uint32_t AssignBatches() const;
+    void Execute(Renderer& renderer, const Command& command) const;
+};
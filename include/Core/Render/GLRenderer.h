@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Core/Render/RectRenderer.h"
+#include "Core/Renderer.h"
+#include "Core/Shader.h"
+#include "Core/Text/TextRenderer.h"
+#include "Core/UniformBuffer.h"
+#include <cstdint>
+#include <vector>
+
+// Renderer on the GL context of the current window. Glyphs are batched
+// through TextRenderer with the given shader, rectangles as instances
+// through RectRenderer's own program; consecutive primitives of one kind
+// go out in one draw, so a display list replayed in batches draws all of a
+// frame's boxes at once. The projection goes through a "Frame" uniform
+// block, which the glyph shader may also read as a plain projection
+// uniform.
+// Shader stats are reset at BeginFrame, so they cover one frame. The caller
+// sets the viewport to the framebuffer; BeginFrame's size is in window
+// coordinates, which differ on HiDPI screens. Retained frames draw into a
+// persistent back buffer at viewport size that EndFrame blits to the
+// window, so the previous frame survives the swap.
+class GLRenderer : public Renderer {
+   public:
+    GLRenderer(Shader& shader, GlyphAtlas& atlas);
+    ~GLRenderer() override;
+
+    RendererBackend Backend() const override {
+        return RendererBackend::OpenGL;
+    }
+
+    void BeginFrame(int width, int height, Color clearColor) override;
+    bool BeginRetainedFrame(int width, int height, Color clearColor) override;
+    void FillRect(float x, float y, float width, float height, Color color,
+                  float radius = 0) override;
+    void DrawGlyph(float x0, float y0, float x1, float y1,
+                   const AtlasRegion& region, Color color) override;
+    void PushClip(const Rect& clip) override;
+    void PopClip() override;
+    void EndFrame() override;
+
+    const TextRendererStats& Stats() const { return text.Stats(); }
+    const RectRendererStats& RectStats() const { return rects.Stats(); }
+    const ShaderStats& UniformStats() const { return shader.Stats(); }
+
+   private:
+    // What is queued and not yet drawn; only one kind at a time, so paint
+    // order holds.
+    enum class Pending : uint8_t { None, Rects, Glyphs };
+
+    Shader& shader;
+    TextRenderer text;
+    UniformBuffer frameUniforms;
+    RectRenderer rects;
+    Pending pending = Pending::None;
+    bool hasFrameBlock = false;
+    int framebufferHeight = 0;
+    float scaleX = 1, scaleY = 1;  // window to framebuffer pixels
+    std::vector<Rect> clipStack;
+    unsigned int backFramebuffer = 0, backTexture = 0;
+    int backWidth = 0, backHeight = 0;
+    bool retained = false;  // drawing into the back buffer
+
+    bool CreateBackBuffer(int width, int height);
+    void Setup(int width, int height);
+    void Clear(Color clearColor);
+    void Flush();
+    void ApplyClip();
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Core/Element.h"
+#include "Core/Layout/LayoutEngine.h"
+#include "Core/Render/Damage.h"
+#include "Core/Render/DisplayList.h"
+#include "Core/Renderer.h"
+#include "Core/Style/StyleTable.h"
+#include "Core/Text/GlyphCache.h"
+#include "Core/Text/TextLayout.h"
+#include <cstdint>
+#include <string_view>
+
+class CompiledTree;
+
+// Draws UTF-8 text on one line starting at the pen position (x, baseline).
+// Returns the pen x after the last glyph.
+float DrawText(Renderer& renderer, GlyphCache& glyphs, FontId font,
+               std::string_view text, float x, float baseline,
+               uint16_t pixelSize, Color color);
+
+// Draws laid out lines with the top of the first at (x, top).
+void DrawTextBlock(Renderer& renderer, GlyphCache& glyphs, FontId font,
+                   const TextBlock& block, float x, float top,
+                   uint16_t pixelSize, Color color);
+
+// Paints a laid out tree in document order: each element's background, then
+// its text, then its children. Elements with display: none are skipped with
+// their subtree, and so is a subtree whose overflow rectangle lies outside
+// the layout's viewport or the boxes clipping it; children sorted by y, as
+// in normal flow, are narrowed to the ones in view by binary search, so a
+// long list costs what shows. The page is drawn scrolled to the viewport's
+// offset, clipping boxes clip and scroll their content. Text is left out
+// when glyphs is null, and wrapped at its laid out width when a text layout
+// is given, on one line otherwise. A damage tracker, when given, is told
+// what each element painted.
+void PaintTree(const Element& root, const LayoutEngine& layout,
+               const StyleTable& styles, Renderer& renderer,
+               GlyphCache* glyphs, FontId font,
+               DamageTracker* damage = nullptr, TextLayout* text = nullptr);
+// The same for a compiled document read in place, in its stored styles.
+void PaintTree(const CompiledTree& tree, const LayoutEngine& layout,
+               Renderer& renderer, GlyphCache* glyphs, FontId font,
+               DamageTracker* damage = nullptr, TextLayout* text = nullptr);
+
+struct PainterStats {
+    uint32_t recorded = 0;  // frames whose display list was re-recorded
+    uint32_t reused = 0;    // frames that kept the previous list
+};
+
+// Paints a tree into a DisplayList. The list is re-recorded only when the
+// tree, its layout or the glyph atlas moved on since the last Paint(), so
+// an unchanged page costs a replay and no tree walk. Damage() holds what
+// changed on screen since the previous Paint(); full on the first one.
+class Painter {
+   public:
+    explicit Painter(GlyphCache* glyphs = nullptr, FontId font = kInvalidFont,
+                     TextLayout* text = nullptr);
+
+    const DisplayList& Paint(const Element& root, const LayoutEngine& layout,
+                             const StyleTable& styles);
+    const DisplayList& Paint(const CompiledTree& tree,
+                             const LayoutEngine& layout);
+    void Invalidate() { valid = false; }  // next Paint() records
+
+    const DisplayList& List() const { return list; }
+    const DamageRegion& Damage() const { return damage; }
+    const PainterStats& Stats() const { return stats; }
+
+   private:
+    GlyphCache* glyphs;
+    FontId font;
+    TextLayout* text;
+    DisplayList list;
+    DamageTracker tracker;
+    DamageRegion damage;
+    PainterStats stats;
+
+    bool valid = false;
+    const void* root = nullptr;  // the element or compiled tree painted
+    const LayoutEngine* layout = nullptr;
+    uint64_t layoutGeneration = 0;
+    uint64_t glyphGeneration = 0;
+
+    // identity tells one tree from another
+    template <typename Tree>
+    const DisplayList& Record(const Tree& tree, typename Tree::ConstNode root,
+                              const void* identity,
+                              const LayoutEngine& layout);
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Core/Render/StreamBuffer.h"
+#include "Core/Shader.h"
+#include "Core/Style/ComputedStyle.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One rectangle of an instanced draw, uploaded as is.
+struct RectInstance {
+    float x, y, width, height;
+    float radii[4];  // top left, top right, bottom right, bottom left
+    Color color;
+    Color borderColor;
+    float borderWidth;  // drawn inside the edge, 0 for none
+};
+
+struct RectRendererStats {
+    uint32_t drawCalls = 0;
+    uint32_t rects = 0;
+};
+
+// Collects filled rectangles and submits them with a single instanced draw
+// per Flush(). Each instance carries its own color, corner radii and
+// border, so rectangles of any look share a batch and no uniform changes
+// between them. The corners use the same signed distance function and one
+// pixel edge as SoftwareRenderer.
+//
+// It has its own program, which reads the projection from the "Frame"
+// uniform block at the given binding; Flush() leaves that program bound.
+// Instance layout: location 0 is vec4(x, y, width, height), 1 the radii,
+// 2 and 3 the normalized RGBA8 fill and border colors, 4 the border width.
+class RectRenderer {
+   public:
+    explicit RectRenderer(unsigned int frameBinding);
+    ~RectRenderer();
+
+    RectRenderer(const RectRenderer&) = delete;
+    RectRenderer& operator=(const RectRenderer&) = delete;
+
+    void BeginFrame();  // resets the per-frame counters
+    void Add(const RectInstance& rect) { instances.push_back(rect); }
+    void Flush();
+
+    const RectRendererStats& Stats() const { return stats; }
+
+   private:
+    Shader shader;
+    StreamBuffer buffer;
+    std::vector<RectInstance> instances;
+    unsigned int vao = 0;
+    RectRendererStats stats;
+};
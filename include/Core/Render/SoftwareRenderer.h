@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Core/Renderer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Rasterizes into an in-memory RGBA8 framebuffer, the same primitives the
+// GL shader draws: solid and rounded rectangles and atlas-masked glyphs.
+// Pixel centers sit at +0.5 as in GL, and rounded corners use the shader's
+// signed distance function, so both backends agree to within a bit of
+// rounding. Glyphs are sampled nearest from the atlas's CPU copy.
+class SoftwareRenderer : public Renderer {
+   public:
+    explicit SoftwareRenderer(const GlyphAtlas& atlas);
+
+    RendererBackend Backend() const override {
+        return RendererBackend::Software;
+    }
+
+    void BeginFrame(int width, int height, Color clearColor) override;
+    bool BeginRetainedFrame(int width, int height, Color clearColor) override;
+    void FillRect(float x, float y, float width, float height, Color color,
+                  float radius = 0) override;
+    void DrawGlyph(float x0, float y0, float x1, float y1,
+                   const AtlasRegion& region, Color color) override;
+    void PushClip(const Rect& clip) override;
+    void PopClip() override;
+    void EndFrame() override {}
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    const uint32_t* Pixels() const { return pixels.data(); }  // RGBA8 rows
+    bool WritePPM(const std::string& path) const;  // drops alpha
+    // Pixels written this frame by clears, fills and glyphs.
+    uint64_t PixelsShaded() const { return pixelsShaded; }
+
+   private:
+    // Pixel bounds, right and bottom exclusive.
+    struct Clip {
+        int left, top, right, bottom;
+    };
+
+    const GlyphAtlas& atlas;
+    int width = 0, height = 0;
+    Clip clip = {0, 0, 0, 0};
+    std::vector<Clip> clipStack;
+    std::vector<uint32_t> pixels;
+    std::vector<uint8_t> coverage;  // one row of scratch
+    uint64_t pixelsShaded = 0;
+
+    uint32_t* Row(int y) { return pixels.data() + size_t(y) * width; }
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+// GL_ARRAY_BUFFER whose contents are replaced every frame, the vertices or
+// instances of one batched draw. Capacity only grows, doubling from the
+// initial size. Vertex arrays reference it by ID(); replacing the contents
+// keeps the ID. Needs a current GL context.
+class StreamBuffer {
+   public:
+    explicit StreamBuffer(size_t initialSize);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Leaves the buffer bound to GL_ARRAY_BUFFER.
+    void Upload(const void* data, size_t size);
+
+    unsigned int ID() const { return bufferID; }
+    size_t Capacity() const { return capacity; }  // in bytes
+
+   private:
+    unsigned int bufferID = 0;
+    size_t capacity;
+};
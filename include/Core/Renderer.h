@@ -1,6 +1,36 @@
 #pragma once
 
+#include "Core/Geometry.h"
+#include "Core/Style/ComputedStyle.h"
+#include "Core/Text/GlyphAtlas.h"
+
+enum class RendererBackend { OpenGL, Software, Recording };
+
+// Draws the primitives a page is painted with. Coordinates are pixels with a
+// top-left origin, colors are straight RGBA8 blended source-over. Backends
+// must produce the same picture; Software needs no window or GL context.
 class Renderer {
    public:
-   private:
-};
\ No newline at end of file
+    virtual ~Renderer() = default;
+
+    virtual RendererBackend Backend() const = 0;
+
+    virtual void BeginFrame(int width, int height, Color clearColor) = 0;
+    // Like BeginFrame, but keeps the previous frame's pixels when the
+    // backend can, so only damaged areas need repainting. Returns false when
+    // the frame was cleared instead and must be painted in full.
+    virtual bool BeginRetainedFrame(int width, int height, Color clearColor) {
+        BeginFrame(width, height, clearColor);
+        return false;
+    }
+    // radius > 0 rounds the corners with a one pixel antialiased edge.
+    virtual void FillRect(float x, float y, float width, float height,
+                          Color color, float radius = 0) = 0;
+    // Quad tinted with color, coverage sampled from the glyph atlas.
+    virtual void DrawGlyph(float x0, float y0, float x1, float y1,
+                           const AtlasRegion& region, Color color) = 0;
+    // Clips are intersected with the enclosing one and nest until popped.
+    virtual void PushClip(const Rect& clip) = 0;
+    virtual void PopClip() = 0;
+    virtual void EndFrame() = 0;
+};
@@ -1,7 +1,36 @@
 #pragma once
 
 #include "glm/glm.hpp"
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
+
+using UniformId = uint32_t;
+
+// FNV-1a of a uniform name; constexpr so hot paths can name uniforms by a
+// compile-time id instead of a string.
+constexpr UniformId HashUniformName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= uint8_t(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct ShaderStats {
+    uint32_t uniformSets = 0;  // SetUniform* calls
+    uint32_t uploads = 0;      // glUniform* calls actually issued
+    uint32_t skipped = 0;      // sets dropped because the value was current
+
+    // Every set used to cost a glGetUniformLocation plus an upload.
+    uint32_t GLCallsSaved() const { return uniformSets + skipped; }
+};
+
+// Linked GL program. Each constructor argument is either GLSL source or the
+// path of a file holding it; anything spanning several lines is source. The
+// program comes from ProgramCache when it has a binary for the sources.
 class Shader {
    public:
     Shader(const std::string& vertexSrc, const std::string& fragmentSrc);
@@ -10,17 +39,48 @@ class Shader {
     void Bind();
     void Unbind();
 
+    // The program must be bound. A value equal to the last one set is not
+    // sent again.
     void SetUniformMat4(const std::string& name, const glm::mat4& value);
     void SetUniformFloat(const std::string& name, float value);
+    void SetUniformFloat2(const std::string& name, const glm::vec2& value);
     void SetUniformFloat3(const std::string& name, const glm::vec3& value);
     void SetUniformInt(const std::string& name, int value);
 
+    void SetUniformMat4(UniformId id, const glm::mat4& value);
+    void SetUniformFloat(UniformId id, float value);
+    void SetUniformFloat2(UniformId id, const glm::vec2& value);
+    void SetUniformFloat3(UniformId id, const glm::vec3& value);
+    void SetUniformInt(UniformId id, int value);
+
+    bool HasUniform(UniformId id) const { return FindUniform(id) != nullptr; }
+    // Points the named uniform block at a UniformBuffer binding; false when
+    // the program has no such block.
+    bool BindUniformBlock(const std::string& name, unsigned int binding);
+
+    const ShaderStats& Stats() const { return stats; }
+    void ResetStats() { stats = ShaderStats(); }
+
    private:
+    // Active uniform, reflected once after linking. The last value sent is
+    // kept to drop redundant sets.
+    struct Uniform {
+        UniformId id;
+        int location;
+        uint8_t valueSize;  // 0 until the first set
+        alignas(4) unsigned char value[sizeof(glm::mat4)];
+    };
+
     unsigned int rendererID;
+    std::vector<Uniform> uniforms;  // sorted by id
+    ShaderStats stats;
 
-    int GetUniformLocation(const std::string& name) const;
+    void ReflectUniforms();
+    const Uniform* FindUniform(UniformId id) const;
+    // Location to upload to, or -1 when the uniform is missing or unchanged.
+    int PrepareSet(UniformId id, const void* value, size_t size);
 
     unsigned int CompileShader(unsigned int type, const std::string& source);
     unsigned int LinkProgram(unsigned int vertexShader,
                              unsigned int fragmentShader);
-};
\ No newline at end of file
+};
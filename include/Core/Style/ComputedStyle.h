@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+
+enum class Display : uint8_t { Block, Inline, Flex, None };
+enum class FlexDirection : uint8_t { Row, Column };
+enum class JustifyContent : uint8_t {
+    FlexStart,
+    FlexEnd,
+    Center,
+    SpaceBetween,
+    SpaceAround,
+    SpaceEvenly,
+};
+enum class AlignItems : uint8_t { Stretch, FlexStart, FlexEnd, Center };
+enum class LengthUnit : uint8_t { Auto, Px, Percent };
+// Hidden and Scroll clip the children to the padding box; Scroll also lets
+// the content be scrolled.
+enum class Overflow : uint8_t { Visible, Hidden, Scroll };
+// Rows lays out and paints only the children of a clipping block with a
+// definite height that are in view, taking them all to be as tall as the
+// first.
+enum class Virtualize : uint8_t { None, Rows };
+
+// 26.6 fixed point, the same format FreeType uses for glyph metrics.
+struct Length {
+    int32_t value = 0;
+    LengthUnit unit = LengthUnit::Auto;
+
+    static constexpr int32_t kOne = 64;
+
+    static constexpr Length Auto() { return {0, LengthUnit::Auto}; }
+    static constexpr Length Px(int32_t pixels) {
+        return {pixels * kOne, LengthUnit::Px};
+    }
+
+    bool IsAuto() const { return unit == LengthUnit::Auto; }
+
+    // Pixels for this length against a containing size; auto yields fallback.
+    float Resolve(float reference, float fallback) const {
+        switch (unit) {
+            case LengthUnit::Px: return float(value) / kOne;
+            case LengthUnit::Percent:
+                return reference * float(value) / (kOne * 100);
+            default: return fallback;
+        }
+    }
+
+    bool operator==(const Length& other) const {
+        return value == other.value && unit == other.unit;
+    }
+    bool operator!=(const Length& other) const { return !(*this == other); }
+};
+
+struct Color {
+    uint8_t r = 0, g = 0, b = 0, a = 0;
+
+    bool IsTransparent() const { return a == 0; }
+    bool operator==(const Color& other) const {
+        return r == other.r && g == other.g && b == other.b && a == other.a;
+    }
+    bool operator!=(const Color& other) const { return !(*this == other); }
+};
+
+enum BoxSide : uint8_t { kTop = 0, kRight, kBottom, kLeft };
+
+// Resolved style of one node. StyleTable holds each one immutable behind a
+// shared_ptr, shared by every element that resolves to it. It stays plain
+// data, so a compiled document can store the distinct styles as raw bytes.
+struct ComputedStyle {
+    Display display = Display::Block;
+    FlexDirection flexDirection = FlexDirection::Row;
+    JustifyContent justifyContent = JustifyContent::FlexStart;
+    AlignItems alignItems = AlignItems::Stretch;
+    Overflow overflow = Overflow::Visible;
+    Virtualize virtualize = Virtualize::None;
+
+    Length width;
+    Length height;
+    Length margin[4] = {Length::Px(0), Length::Px(0), Length::Px(0),
+                        Length::Px(0)};
+    Length padding[4] = {Length::Px(0), Length::Px(0), Length::Px(0),
+                         Length::Px(0)};
+    Length borderRadius = Length::Px(0);
+    Length fontSize = Length::Px(16);
+
+    Color backgroundColor;
+    Color color = {0, 0, 0, 255};
+
+    // Inherited properties take the parent's value, the rest reset.
+    void InheritFrom(const ComputedStyle& parent) {
+        color = parent.color;
+        fontSize = parent.fontSize;
+    }
+
+    bool operator==(const ComputedStyle& other) const {
+        for (int side = 0; side < 4; side++) {
+            if (margin[side] != other.margin[side] ||
+                padding[side] != other.padding[side]) {
+                return false;
+            }
+        }
+        return display == other.display &&
+               flexDirection == other.flexDirection &&
+               justifyContent == other.justifyContent &&
+               alignItems == other.alignItems && overflow == other.overflow &&
+               virtualize == other.virtualize && width == other.width &&
+               height == other.height && borderRadius == other.borderRadius &&
+               fontSize == other.fontSize &&
+               backgroundColor == other.backgroundColor &&
+               color == other.color;
+    }
+    bool operator!=(const ComputedStyle& other) const {
+        return !(*this == other);
+    }
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Core/Style/ComputedStyle.h"
+#include <cstdint>
+#include <string_view>
+
+// Hand-written CSS declaration parsing. Nothing here allocates or throws;
+// malformed input is skipped and leaves the style untouched.
+
+// Applies `a: b; c: d` in order, later declarations win.
+void ParseInlineStyle(std::string_view declarations, ComputedStyle& style);
+
+// Applies a single declaration. Returns false, leaving style unchanged, for
+// unknown properties and invalid values.
+bool ApplyDeclaration(std::string_view property, std::string_view value,
+                      ComputedStyle& style);
+
+// ComputedStyle fields a DeclarationBlock sets. Side bits follow BoxSide
+// order.
+enum StyleField : uint32_t {
+    kFieldDisplay = 1 << 0,
+    kFieldFlexDirection = 1 << 1,
+    kFieldJustifyContent = 1 << 2,
+    kFieldAlignItems = 1 << 3,
+    kFieldWidth = 1 << 4,
+    kFieldHeight = 1 << 5,
+    kFieldMarginTop = 1 << 6,
+    kFieldMarginRight = 1 << 7,
+    kFieldMarginBottom = 1 << 8,
+    kFieldMarginLeft = 1 << 9,
+    kFieldPaddingTop = 1 << 10,
+    kFieldPaddingRight = 1 << 11,
+    kFieldPaddingBottom = 1 << 12,
+    kFieldPaddingLeft = 1 << 13,
+    kFieldBorderRadius = 1 << 14,
+    kFieldFontSize = 1 << 15,
+    kFieldBackgroundColor = 1 << 16,
+    kFieldColor = 1 << 17,
+    kFieldOverflow = 1 << 18,
+    kFieldVirtualize = 1 << 19,
+};
+
+// Declarations parsed once and applied to many styles, as a stylesheet
+// rule's are: the values sit in a scratch style and fields says which of
+// them were declared.
+struct DeclarationBlock {
+    ComputedStyle values;
+    uint32_t fields = 0;  // StyleField bits
+
+    void ApplyTo(ComputedStyle& style) const;
+};
+
+// Adds `a: b; c: d` to block, later declarations win.
+void ParseDeclarationBlock(std::string_view declarations,
+                           DeclarationBlock& block);
+
+bool ParseLength(std::string_view text, Length& length);
+bool ParseColor(std::string_view text, Color& color);
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "Core/Atom.h"
+#include "Core/Element.h"
+#include "Core/Style/ComputedStyle.h"
+#include "Core/Style/StyleParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// What one element must be: an optional type, an optional id and any
+// number of classes. kInvalidAtom leaves the type or id open.
+struct CompoundSelector {
+    Atom tag = kInvalidAtom;
+    Atom id = kInvalidAtom;
+    std::vector<Atom> classes;
+};
+
+enum class Combinator : uint8_t { Descendant, Child };
+
+// Stored right to left: compounds[0] is the element the rule styles, and
+// combinators[i] says how compounds[i + 1] sits above compounds[i].
+struct Selector {
+    static constexpr size_t kAncestorHashes = 4;
+
+    std::vector<CompoundSelector> compounds;
+    std::vector<Combinator> combinators;
+    uint32_t specificity = 0;  // ids << 16 | classes << 8 | types
+    // AncestorFilter keys some ancestor must carry, 0 terminated
+    uint32_t ancestorHashes[kAncestorHashes] = {};
+};
+
+struct StyleRule {
+    Selector selector;
+    uint32_t block;  // index of its declarations in the sheet
+};
+
+// A bucket's copy of what rejects a rule early, so the filter pass over a
+// bucket reads one contiguous array.
+struct RuleEntry {
+    uint32_t rule;
+    uint32_t ancestorHashes[Selector::kAncestorHashes];
+};
+
+// Counting bloom filter over the tag, id and class keys of the elements
+// above the one being matched. A walk adds an element's keys before going
+// into its children and removes them on the way out, so a selector whose
+// ancestor keys are not all present is rejected without looking at a
+// single ancestor. False positives only cost the exact check.
+class AncestorFilter {
+   public:
+    void Add(uint32_t hash);
+    void Remove(uint32_t hash);
+    bool MayContain(uint32_t hash) const {
+        return counters[hash & kMask] && counters[(hash >> kBits) & kMask];
+    }
+
+   private:
+    static constexpr uint32_t kBits = 12;
+    static constexpr uint32_t kMask = (1u << kBits) - 1;
+
+    uint8_t counters[1 << kBits] = {};  // a saturated counter stays put
+};
+
+enum class SelectorKey : uint8_t { Tag, Id, Class };
+
+uint32_t AncestorKeyHash(SelectorKey kind, Atom atom);
+
+// Rules of the <style> blocks and linked stylesheets of a document, in
+// source order. Type, class, id, descendant and child selectors are
+// supported; a rule whose selector list uses anything else, and at-rules,
+// are dropped whole. Declarations are parsed once, when the sheet is.
+//
+// Rules are bucketed by the most selective key of their rightmost
+// compound, id before class before type, so an element only looks at the
+// rules that could match it.
+class StyleSheet {
+   public:
+    // Appends the rules of css after the ones already in the sheet.
+    void Parse(std::string_view css);
+
+    size_t RuleCount() const { return rules.size(); }
+    bool Empty() const { return rules.empty(); }
+    // Whether any selector looks above the element it styles.
+    bool UsesAncestors() const { return usesAncestors; }
+
+   private:
+    friend class SelectorMatcher;
+
+    std::vector<StyleRule> rules;
+    std::vector<DeclarationBlock> blocks;
+    // in rule order
+    std::unordered_map<Atom, std::vector<RuleEntry>> idRules;
+    std::unordered_map<Atom, std::vector<RuleEntry>> classRules;
+    std::unordered_map<Atom, std::vector<RuleEntry>> tagRules;
+    std::vector<RuleEntry> universalRules;
+    bool usesAncestors = false;
+
+    void AddRule(Selector selector, uint32_t block);
+};
+
+// The contents of root's <style> elements and the files of its
+// <link rel="stylesheet" href> elements, in document order, as one sheet.
+// hrefs are relative to the document's file, or to the working directory
+// without one; unreadable ones are skipped. Null if there are no rules.
+std::shared_ptr<const StyleSheet> CollectStyleSheets(
+    const Element& root, const std::string& documentPath = std::string());
+
+struct SelectorStats {
+    uint64_t candidates = 0;  // rules looked at
+    uint64_t filtered = 0;    // of those, rejected by the ancestor filter
+    uint64_t matched = 0;
+};
+
+// Matches a sheet during a walk from the root down. The walk brackets each
+// element's children with PushAncestor() and PopAncestor(), which keep a
+// stack of the ancestors' keys and the filter over them, so matching reads
+// neither Element::parent nor an attribute above the element. Elements are
+// described by their tag and the raw id and class attribute values, which
+// fits both Element and Document.
+class SelectorMatcher {
+   public:
+    void SetStyleSheet(std::shared_ptr<const StyleSheet> styleSheet);
+    const std::shared_ptr<const StyleSheet>& Sheet() const { return sheet; }
+    // Push and pop are no-ops without rules; change the sheet between walks.
+    bool Active() const { return sheet && !sheet->Empty(); }
+
+    void PushAncestor(Atom tag, std::string_view id, std::string_view classes);
+    void PopAncestor();
+    // Hash of the pushed ancestors' keys, as far as the sheet's selectors
+    // can see them: elements with the same one match the same rules if
+    // they are alike themselves. 0 when no selector looks at ancestors.
+    uint64_t Ancestry() const {
+        return Active() && sheet->UsesAncestors() && !ancestors.empty()
+                   ? ancestors.back().ancestry
+                   : 0;
+    }
+    // Applies the matching rules to style, by specificity then source order.
+    void Apply(Atom tag, std::string_view id, std::string_view classes,
+               ComputedStyle& style);
+
+    // For benchmarks: with either off, every rule is a candidate or no
+    // candidate is filtered.
+    void SetFastPaths(bool buckets, bool ancestorFilter) {
+        useBuckets = buckets;
+        useFilter = ancestorFilter;
+    }
+    const SelectorStats& Stats() const { return stats; }
+    void ResetStats() { stats = SelectorStats(); }
+
+   private:
+    struct Key {
+        Atom tag, id;
+        uint32_t firstClass, classCount;  // in classes
+        uint64_t ancestry;                // of this key and those above it
+    };
+
+    std::shared_ptr<const StyleSheet> sheet;
+    std::vector<Key> ancestors;  // root first
+    std::vector<Atom> classes;   // of the ancestors, then of the subject
+    AncestorFilter filter;
+    std::vector<uint32_t> matched;  // scratch
+    SelectorStats stats;
+    bool useBuckets = true, useFilter = true;
+
+    Key MakeKey(Atom tag, std::string_view id, std::string_view classList);
+    bool Matches(const CompoundSelector& compound, const Key& key) const;
+    bool MatchAncestors(const Selector& selector, size_t compound,
+                        size_t limit) const;
+    void Consider(uint32_t rule, const uint32_t* ancestorHashes,
+                  const Key& subject);
+};
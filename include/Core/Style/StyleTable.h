@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Core/Document.h"
+#include "Core/Element.h"
+#include "Core/Style/ComputedStyle.h"
+#include "Core/Style/StyleSheet.h"
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct StyleSharingStats {
+    uint64_t resolved = 0;  // cascaded from scratch
+    uint64_t shared = 0;    // taken from a sharing candidate instead
+};
+
+// Computed styles for a whole tree, one slot per node (indexed by
+// Element::index or NodeId). Declarations are parsed once here; per-frame
+// code only reads the table.
+//
+// An element's style cascades its parent's inherited properties, the
+// user-agent defaults, the stylesheet rules it matches and its inline
+// style, in that order.
+//
+// Styles are immutable and reference counted. While walking elements the
+// table keeps the last few it styled as sharing candidates: an element
+// with the same tag and attributes as one of them, under the same parent
+// style and, if the sheet looks at ancestors, the same ancestor keys,
+// would cascade to the same style, so it takes the candidate's without
+// matching. Long runs of alike siblings and cousins end up sharing one.
+class StyleTable {
+   public:
+    void Resolve(const Element& root);
+    void ResolveSubtree(const Element& element);
+    void Resolve(const Document& document);
+    // Takes styles resolved elsewhere, e.g. stored in a compiled document.
+    void Assign(std::vector<std::shared_ptr<const ComputedStyle>> resolved);
+    // Shares other's resolved styles, one reference per slot, for a reader
+    // that only calls Get(); the stylesheet and matcher state stay behind.
+    void CopyStyles(const StyleTable& other) { styles = other.styles; }
+    // Forgets the sharing candidates, which point at elements of the last
+    // walk. Every walk calling ResolveNode() starts with it.
+    void BeginWalk();
+    // Re-resolves one element against its parent's style, not its children.
+    // parent must stay put for the walk, like the styles in this table do.
+    // With a stylesheet, the walk must have pushed the element's ancestors.
+    const ComputedStyle& ResolveNode(const Element& element,
+                                     const ComputedStyle& parent);
+
+    // Takes effect on the next resolve, which must cover the whole tree.
+    void SetStyleSheet(std::shared_ptr<const StyleSheet> sheet) {
+        matcher.SetStyleSheet(std::move(sheet));
+    }
+    // A walk brackets each element's children with these, so selectors
+    // see the element as an ancestor.
+    void PushAncestor(const Element& element) {
+        if (!matcher.Active()) return;
+        matcher.PushAncestor(element.tag, element.GetAttribute(kAtomId),
+                             element.GetAttribute(kAtomClass));
+    }
+    void PopAncestor() { matcher.PopAncestor(); }
+    SelectorMatcher& Matcher() { return matcher; }
+
+    void SetStyleSharing(bool enabled) { sharing = enabled; }
+    const StyleSharingStats& SharingStats() const { return sharingStats; }
+    void ResetSharingStats() { sharingStats = StyleSharingStats(); }
+
+    // Slots never resolved read as the initial style.
+    const ComputedStyle& Get(uint32_t index) const {
+        return index < styles.size() && styles[index] ? *styles[index]
+                                                      : kInitialStyle;
+    }
+    const ComputedStyle& Get(const Element& element) const {
+        return Get(element.index);
+    }
+    size_t Size() const { return styles.size(); }
+    size_t DistinctStyles() const;
+
+   private:
+    static constexpr size_t kSharingCandidates = 8;
+    static const ComputedStyle kInitialStyle;
+
+    struct SharingCandidate {
+        const Element* element = nullptr;
+        const ComputedStyle* parent = nullptr;
+        uint64_t ancestry = 0;
+        std::shared_ptr<const ComputedStyle> style;
+    };
+
+    std::vector<std::shared_ptr<const ComputedStyle>> styles;
+    SelectorMatcher matcher;
+    bool sharing = true;
+    SharingCandidate candidates[kSharingCandidates];
+    size_t nextCandidate = 0;  // the oldest, replaced next
+    StyleSharingStats sharingStats;
+
+    void ResolveElement(const Element& element, const ComputedStyle& parent);
+    ComputedStyle Cascade(const Element& element, const ComputedStyle& parent);
+    std::shared_ptr<const ComputedStyle>& Slot(uint32_t index);
+};
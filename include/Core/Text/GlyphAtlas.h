@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct AtlasRegion {
+    uint16_t x = 0, y = 0, width = 0, height = 0;
+};
+
+// Shelf packer: rectangles fill rows left to right, a new shelf opens when a
+// rectangle fits no existing one. Glyphs of one size share a height, so
+// shelves waste little. Freed slots are kept and handed out again to any
+// rectangle that fits inside them.
+class ShelfPacker {
+   public:
+    ShelfPacker(int width, int height) : width(width), height(height) {}
+
+    bool Pack(int w, int h, AtlasRegion& region);
+    void Free(const AtlasRegion& region);
+    void Clear();
+    uint64_t PackedArea() const { return packedArea; }
+
+   private:
+    struct Shelf {
+        int y, height, x;
+    };
+
+    int width, height;
+    int nextShelfY = 0;
+    uint64_t packedArea = 0;
+    std::vector<Shelf> shelves;
+    std::vector<AtlasRegion> freeSlots;
+};
+
+// Single-channel texture holding every rasterized glyph. Pixels are kept on
+// the CPU as well, glyphs are written there and only the touched rows are
+// pushed to GL on Upload(), so packing works without a context.
+class GlyphAtlas {
+   public:
+    GlyphAtlas(int width = 1024, int height = 1024);
+    ~GlyphAtlas();
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    // Copies a glyph bitmap in; false when the atlas is full. region is the
+    // glyph itself, slot the space reserved for it, which Free() takes back.
+    bool Add(const uint8_t* bitmap, int width, int height, int pitch,
+             AtlasRegion& region, AtlasRegion* slot = nullptr);
+    void Free(const AtlasRegion& slot);
+    void Clear();
+    void Upload();  // needs a current GL context
+
+    unsigned int TextureID() const { return textureID; }
+    const uint8_t* Pixels() const { return pixels.data(); }
+    int Width() const { return width; }
+    int Height() const { return height; }
+    float Occupancy() const {
+        return float(packer.PackedArea()) / float(width * height);
+    }
+    uint32_t GlyphCount() const { return glyphCount; }
+
+   private:
+    int width, height;
+    ShelfPacker packer;
+    std::vector<uint8_t> pixels;
+    unsigned int textureID = 0;
+    int dirtyTop, dirtyBottom;  // rows not yet uploaded, empty if top >= bottom
+    uint32_t glyphCount = 0;
+};
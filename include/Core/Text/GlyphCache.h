@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Core/Text/GlyphAtlas.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_* FT_Face;
+
+using FontId = uint16_t;
+constexpr FontId kInvalidFont = 0xFFFF;
+
+struct GlyphInfo {
+    AtlasRegion region;  // empty for blank glyphs such as space
+    int16_t bearingX = 0;
+    int16_t bearingY = 0;
+    int32_t advance = 0;  // 26.6
+};
+
+struct GlyphCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t failures = 0;  // glyphs that could not be placed at all
+    size_t bytesInUse = 0;  // atlas bytes held by cached bitmaps
+    size_t entries = 0;
+};
+
+// Glyphs keyed by (font, pixel size, code point), rasterized through
+// FreeType the first time they are asked for. Lookups go through an
+// open-addressed table; entries sit on an LRU list and the least recently
+// used ones give their atlas space back when the memory budget or the atlas
+// runs out. Glyphs used in the current frame are never evicted, queued quads
+// may still point at them.
+class GlyphCache {
+   public:
+    explicit GlyphCache(GlyphAtlas& atlas, size_t memoryBudget = 4 << 20);
+    ~GlyphCache();
+
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    FontId LoadFont(const std::string& path);
+    FT_Face Face(FontId font) const { return faces[font]; }
+    // Sets the face's pixel size, skipping FreeType when it already matches.
+    void SelectSize(FontId font, uint16_t pixelSize);
+    int Ascender(FontId font, uint16_t pixelSize);  // baseline to top, px
+
+    bool GetGlyph(FontId font, uint16_t pixelSize, uint32_t codepoint,
+                  GlyphInfo& glyph);
+
+    void BeginFrame() { frame++; }
+    void SetMemoryBudget(size_t bytes);
+    const GlyphCacheStats& Stats() const { return stats; }
+    // Bumped whenever an atlas slot is given up; regions handed out before
+    // may since hold other glyphs.
+    uint64_t Generation() const { return generation; }
+    GlyphAtlas& Atlas() { return atlas; }
+
+   private:
+    static constexpr uint32_t kNone = 0xFFFFFFFF;
+
+    struct Entry {
+        uint64_t key;
+        GlyphInfo glyph;
+        AtlasRegion slot;  // atlas space reserved, empty for blank glyphs
+        uint32_t frame;    // last frame the glyph was used in
+        uint32_t prev, next;  // LRU links, most recent at head
+    };
+
+    GlyphAtlas& atlas;
+    size_t memoryBudget;
+    FT_Library library = nullptr;
+    std::vector<FT_Face> faces;
+    std::vector<uint16_t> faceSizes;
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeEntries;
+    std::vector<uint32_t> table;  // entry index + 1 per bucket, 0 is empty
+    uint32_t head = kNone, tail = kNone;
+    uint32_t frame = 1;
+    uint64_t generation = 0;
+    GlyphCacheStats stats;
+
+    uint32_t Find(uint64_t key) const;
+    void Insert(uint64_t key, uint32_t entry);
+    void Erase(uint64_t key);
+    void Grow();
+
+    void Unlink(uint32_t entry);
+    void PushFront(uint32_t entry);
+    bool EvictOne();
+    bool Rasterize(FontId font, uint16_t pixelSize, uint32_t codepoint,
+                   Entry& entry);
+};
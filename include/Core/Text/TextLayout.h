@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Core/Layout/LayoutEngine.h"
+#include "Core/Text/GlyphCache.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A run of text measured once per (font, size): code points, pen positions
+// with kerning applied, and the words lines may break between. It does not
+// depend on the width, so any wrap width reuses it.
+struct ShapedRun {
+    struct Word {
+        uint32_t start;  // first glyph
+        uint32_t end;    // one past the last glyph, spaces excluded
+    };
+
+    std::vector<uint32_t> codepoints;
+    // 26.6 pen x before glyph i, pens[size] is the end of the run
+    std::vector<int32_t> pens;
+    std::vector<Word> words;
+    float lineHeight = 0;
+    float ascender = 0;  // baseline below the line top
+
+    size_t ByteSize() const {
+        return codepoints.capacity() * sizeof(uint32_t) +
+               pens.capacity() * sizeof(int32_t) +
+               words.capacity() * sizeof(Word);
+    }
+};
+
+struct TextLine {
+    uint32_t start, end;  // glyph range, trailing spaces excluded
+    float width;
+};
+
+// A run broken into lines at one width. Glyph i of a line sits at
+// GlyphX(line, i) from the line's left edge.
+struct TextBlock {
+    std::shared_ptr<const ShapedRun> run;
+    std::vector<TextLine> lines;
+    float maxWidth = 0;
+    float width = 0, height = 0;  // widest line, lines * line height
+
+    float GlyphX(const TextLine& line, uint32_t glyph) const {
+        return float(run->pens[glyph] - run->pens[line.start]) / 64;
+    }
+};
+
+struct TextLayoutStats {
+    uint64_t runHits = 0, runMisses = 0;      // shaping
+    uint64_t blockHits = 0, blockMisses = 0;  // line breaking
+    uint64_t evictions = 0;
+    size_t bytesInUse = 0;
+    size_t entries = 0;
+};
+
+// Lays text out with the glyph metrics of a GlyphCache's fonts: advances
+// and FreeType kerning, greedy breaks at whitespace, and a word wider than
+// the line overflows it on a line of its own. Shaped runs are cached by
+// (text, font, size), and each keeps the blocks of the last few widths it
+// was broken at, so a relayout at an unchanged width costs a lookup and a
+// resize costs a pass over the words. Least recently used runs go once the
+// memory budget is spent.
+//
+// Calls are serialized on an internal mutex, so the measurer is safe for
+// parallel layout. Measuring selects sizes on the GlyphCache's faces: do not
+// measure while another thread draws text from the same cache.
+class TextLayout {
+   public:
+    explicit TextLayout(GlyphCache& glyphs, size_t memoryBudget = 8 << 20);
+
+    TextLayout(const TextLayout&) = delete;
+    TextLayout& operator=(const TextLayout&) = delete;
+
+    // Never null. A huge maxWidth keeps the text on one line.
+    std::shared_ptr<const TextBlock> Layout(std::string_view text,
+                                            FontId font, uint16_t pixelSize,
+                                            float maxWidth);
+    // For LayoutEngine::SetTextMeasurer.
+    TextMeasurer Measurer(FontId font);
+
+    void Clear();
+    TextLayoutStats Stats() const;
+
+   private:
+    static constexpr size_t kBlocksPerRun = 4;
+
+    struct Entry {
+        uint64_t key;
+        std::string text;
+        FontId font;
+        uint16_t pixelSize;
+        std::shared_ptr<const ShapedRun> run;
+        std::vector<std::shared_ptr<const TextBlock>> blocks;  // newest last
+        size_t bytes;
+    };
+
+    struct Metrics {
+        uint32_t glyphIndex;
+        int32_t advance;  // 26.6
+    };
+
+    GlyphCache& glyphs;
+    size_t memoryBudget;
+    mutable std::mutex mutex;
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    std::unordered_map<uint64_t, Metrics> metrics;  // by glyph cache key
+    std::unordered_map<uint64_t, int32_t> kerningPairs;  // 26.6
+    TextLayoutStats stats;
+
+    std::shared_ptr<const ShapedRun> Shape(std::string_view text, FontId font,
+                                           uint16_t pixelSize);
+    const Metrics& GlyphMetrics(FontId font, uint16_t pixelSize,
+                                uint32_t codepoint);
+    int32_t Kerning(FontId font, uint16_t pixelSize, uint32_t left,
+                    uint32_t right);
+    std::shared_ptr<const TextBlock> Break(
+        const std::shared_ptr<const ShapedRun>& run, float maxWidth) const;
+    void Trim();
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Core/Render/StreamBuffer.h"
+#include "Core/Style/ComputedStyle.h"
+#include "Core/Text/GlyphAtlas.h"
+#include <cstdint>
+#include <vector>
+
+struct TextVertex {
+    float x, y, u, v;
+    uint8_t r, g, b, a;
+};
+
+struct TextRendererStats {
+    uint32_t drawCalls = 0;
+    uint32_t quads = 0;
+};
+
+// Collects glyph quads sampled from one GlyphAtlas and submits them with a
+// single draw per Flush(). Colors travel per vertex, so runs of different
+// colors still share a batch. The caller binds the shader and projection.
+//
+// Vertex layout: location 0 is vec4(x, y, u, v), location 1 is a normalized
+// RGBA8 color.
+class TextRenderer {
+   public:
+    explicit TextRenderer(GlyphAtlas& atlas);
+    ~TextRenderer();
+
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer& operator=(const TextRenderer&) = delete;
+
+    void BeginFrame();  // resets the per-frame counters
+    void AddQuad(float x0, float y0, float x1, float y1,
+                 const AtlasRegion& region, Color color);
+    // Explicit texture coordinates, normalized to the atlas.
+    void AddQuad(float x0, float y0, float x1, float y1, float u0, float v0,
+                 float u1, float v1, Color color);
+    void Flush();
+
+    const TextRendererStats& Stats() const { return stats; }
+    GlyphAtlas& Atlas() { return atlas; }
+
+   private:
+    GlyphAtlas& atlas;
+    StreamBuffer buffer;
+    std::vector<TextVertex> vertices;
+    unsigned int vao = 0, ebo = 0;
+    size_t indexedQuads = 0;  // quads the index buffer covers
+    TextRendererStats stats;
+
+    void Reserve(size_t quads);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+constexpr uint32_t kReplacementCharacter = 0xFFFD;
+
+// Decodes the code point starting at text[position] and advances position
+// past it. Malformed, overlong and surrogate sequences decode to U+FFFD and
+// consume one byte, so decoding always makes progress.
+inline uint32_t DecodeUtf8(std::string_view text, size_t& position) {
+    auto byte = [&](size_t i) { return uint8_t(text[position + i]); };
+    uint8_t lead = byte(0);
+
+    if (lead < 0x80) {
+        position++;
+        return lead;
+    }
+
+    size_t length;
+    uint32_t codepoint, minimum;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint = lead & 0x1F;
+        minimum = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint = lead & 0x0F;
+        minimum = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint = lead & 0x07;
+        minimum = 0x10000;
+    } else {
+        position++;
+        return kReplacementCharacter;
+    }
+
+    if (position + length > text.size()) {
+        position++;
+        return kReplacementCharacter;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if ((byte(i) & 0xC0) != 0x80) {
+            position++;
+            return kReplacementCharacter;
+        }
+        codepoint = (codepoint << 6) | (byte(i) & 0x3F);
+    }
+
+    if (codepoint < minimum || codepoint > 0x10FFFF ||
+        (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        position++;
+        return kReplacementCharacter;
+    }
+    position += length;
+    return codepoint;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for fork-join loops. Every worker has its own deque:
+// it pushes and pops work at the back, idle workers steal from the front of
+// the others, so nested loops stay local while big outer chunks spread.
+// A thread waiting on ParallelFor() keeps running queued tasks, its own or
+// any other loop's, which makes nesting safe; it sleeps only once the rest
+// of its loop is running elsewhere, until that finishes or new work comes.
+// Threads outside the pool share one extra deque.
+class ThreadPool {
+   public:
+    // threads counts the caller, a pool of 1 runs everything inline.
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned Size() const { return unsigned(workers.size()) + 1; }
+
+    // Runs task(i) for every i in [0, count), in any order and on any
+    // thread, and returns once all of them have finished.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+   private:
+    struct Task {
+        const std::function<void(size_t)>* function;
+        size_t index;
+        std::atomic<size_t>* pending;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // queues[0] is shared by outside threads, worker i owns queues[i + 1]
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued{0};
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    size_t CurrentQueue() const;
+    bool Pop(size_t queue, Task& task);
+    bool Steal(size_t thief, Task& task);
+    void Execute(const Task& task);
+    void WorkerLoop(size_t queue);
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Core/Document.h"
+#include "Core/Element.h"
+#include "Core/Parser/CompiledDocument.h"
+#include "Core/Style/ComputedStyle.h"
+#include "Core/Style/StyleTable.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// The two trees LayoutEngine, Painter and HitTestGrid walk, behind one set
+// of calls: ElementTree over shared_ptr<Element> nodes, CompiledTree over
+// the node arrays of a mapped CompiledDocument. The walks are templates
+// over these, so either tree costs what its accessors cost and nothing is
+// converted. A Node names a node the walk may change the dirty bits of, a
+// ConstNode one it only reads; kNone is no node.
+//
+// Every node has an index, its slot in the per-node tables: Element::index
+// or the NodeId.
+
+// Styles come from the table the tree was laid out with, resolved on the
+// way by Resolve().
+class ElementTree {
+   public:
+    using Node = Element*;
+    using ConstNode = const Element*;
+    static constexpr Node kNone = nullptr;
+
+    explicit ElementTree(const StyleTable& styles) : styles(styles) {}
+
+    uint32_t Index(ConstNode node) const { return node->index; }
+    size_t ChildCount(ConstNode node) const { return node->children.size(); }
+    Node Child(ConstNode node, size_t i) const {
+        return node->children[i].get();
+    }
+    Node Parent(ConstNode node) const { return node->parent.lock().get(); }
+    std::string_view Text(ConstNode node) const { return node->innerText; }
+    const ComputedStyle& Style(ConstNode node) const {
+        return styles.Get(*node);
+    }
+
+    uint8_t& Dirty(Node node) const { return node->dirty; }
+    void MarkDirty(Node node, uint8_t flags) const { node->MarkDirty(flags); }
+
+    // table is the one the tree's styles are read from.
+    const ComputedStyle& Resolve(StyleTable& table, Node node,
+                                 const ComputedStyle& parent) const {
+        return table.ResolveNode(*node, parent);
+    }
+    void PushAncestor(StyleTable& table, ConstNode node) const {
+        table.PushAncestor(*node);
+    }
+    void PopAncestor(StyleTable& table) const { table.PopAncestor(); }
+
+   private:
+    const StyleTable& styles;
+};
+
+// Reads the document's mapping in place: children, text and the stored
+// styles, which never change, so nothing is ever resolved. The only state
+// of its own is a dirty byte per node, as layout keeps its bits on the
+// tree; it starts out as a whole tree to lay out. The document must
+// outlive it.
+class CompiledTree {
+   public:
+    using Node = NodeId;
+    using ConstNode = NodeId;
+    static constexpr Node kNone = kInvalidNode;
+
+    explicit CompiledTree(const CompiledDocument& document)
+        : document(&document),
+          dirty(document.NodeCount(), kDirtyLayout | kDirtyDescendants) {}
+
+    const CompiledDocument& Document() const { return *document; }
+    NodeId Root() const { return document->Root(); }
+
+    uint32_t Index(NodeId node) const { return node; }
+    size_t ChildCount(NodeId node) const { return document->ChildCount(node); }
+    NodeId Child(NodeId node, size_t i) const {
+        return document->Child(node, i);
+    }
+    NodeId Parent(NodeId node) const { return document->Parent(node); }
+    std::string_view Text(NodeId node) const { return document->Text(node); }
+    const ComputedStyle& Style(NodeId node) const {
+        return document->Style(node);
+    }
+
+    uint8_t& Dirty(NodeId node) { return dirty[node]; }
+    // Like Element::MarkDirty(); there are no snapshot copies to outdate.
+    void MarkDirty(NodeId node, uint8_t flags) {
+        dirty[node] |= flags;
+        for (NodeId ancestor = Parent(node);
+             ancestor != kNone && !(dirty[ancestor] & kDirtyDescendants);
+             ancestor = Parent(ancestor)) {
+            dirty[ancestor] |= kDirtyDescendants;
+        }
+    }
+
+    const ComputedStyle& Resolve(StyleTable&, NodeId node,
+                                 const ComputedStyle&) const {
+        return Style(node);
+    }
+    void PushAncestor(StyleTable&, NodeId) const {}
+    void PopAncestor(StyleTable&) const {}
+
+   private:
+    const CompiledDocument* document;
+    std::vector<uint8_t> dirty;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GL_UNIFORM_BUFFER attached to one binding point, for data every draw of a
+// frame shares (the projection, for one). Shaders reach it through
+// Shader::BindUniformBlock. A CPU copy of the contents lets Update() skip
+// uploads that would not change anything. Needs a current GL context.
+class UniformBuffer {
+   public:
+    UniformBuffer(unsigned int binding, size_t size);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // std140 layout is the caller's job. Returns whether anything was sent.
+    bool Update(const void* data, size_t size, size_t offset = 0);
+
+    unsigned int Binding() const { return binding; }
+    uint32_t Uploads() const { return uploads; }
+    uint32_t Skipped() const { return skipped; }
+
+   private:
+    unsigned int bufferID = 0;
+    unsigned int binding;
+    std::vector<uint8_t> contents;
+    uint32_t uploads = 0, skipped = 0;
+};
@@ -1,13 +1,34 @@
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <GLFW/glfw3.h>
+#include "Core/Input/InputEvent.h"
 class Window {
    public:
     Window(int width, int height, const std::string& name);
     ~Window();
     bool ShouldClose() const;
     void PollEvents();
+    // Blocks until an event arrives or timeout seconds pass.
+    void WaitEvents(double timeout);
+    void SwapBuffers();
+    void SetSwapInterval(int interval);  // 1 locks presents to vsync
+    // Counts input and window events (keys, pointer, scroll, resize,
+    // refresh, focus), so a loop can tell whether anything happened.
+    uint64_t EventCount() const { return eventCount; }
+    // Input queued since the last call, in arrival order. Consecutive pointer
+    // moves collapse into the last one, so a frame sees at most one move
+    // between two other events however fast the mouse reports.
+    std::vector<InputEvent> TakeEvents();
     GLFWwindow* GetGLFWWindow() { return window; }
 
    private:
     GLFWwindow* window;
-};
\ No newline at end of file
+    uint64_t eventCount = 0;
+    std::vector<InputEvent> events;
+    double cursorX = 0, cursorY = 0;
+
+    void InstallEventCounters();
+    static void CountEvent(GLFWwindow* handle);
+    static void QueueEvent(GLFWwindow* handle, InputEvent event);
+};
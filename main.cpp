@@ -343,7 +343,125 @@
 // }
 
 #include "application/App.h"
-int main() {
-    Example *e = new Example(1024, 768, "example");
+#include "application/Headless.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// vision [--backend=gl|software] [--pacing vsync|ondemand|unlocked|FPS]
+//        [--frames N] [--steady] [--damage-bench] [--pipeline-stress]
+//        [--layout-bench] [--stream-bench] [--parse-bench] [--load-bench]
+//        [--text-bench] [--style-bench] [--sharing-bench] [--hit-bench]
+//        [--scroll-bench] [--token-bench] [--whitespace-check] [--dom-bench]
+//        [--declaration-bench] [--relayout-bench] [--compile out.vdoc]
+//        [--size WxH] [--font path] [--scroll Y] [--layout-threads N]
+//        [--out frame.ppm] [document.html]
+int main(int argc, char** argv) {
+    RendererBackend backend = RendererBackend::OpenGL;
+    HeadlessOptions options;
+    FrameMode frameMode = FrameMode::OnDemand;  // the demo page is static
+    double targetFps = 60;
+    bool damageBench = false, pipelineStress = false, layoutBench = false;
+    bool streamBench = false, parseBench = false, loadBench = false;
+    bool textBench = false, styleBench = false, sharingBench = false;
+    bool hitBench = false, scrollBench = false, tokenBench = false;
+    bool whitespaceCheck = false, domBench = false, declarationBench = false;
+    bool relayoutBench = false;
+    std::string compileOutput;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--backend=software") {
+            backend = RendererBackend::Software;
+        } else if (arg == "--backend=gl") {
+            backend = RendererBackend::OpenGL;
+        } else if (arg == "--pacing" && hasValue) {
+            std::string pacing = argv[++i];
+            if (pacing == "vsync") {
+                frameMode = FrameMode::VSync;
+            } else if (pacing == "ondemand") {
+                frameMode = FrameMode::OnDemand;
+            } else if (pacing == "unlocked") {
+                frameMode = FrameMode::Unlocked;
+            } else {
+                frameMode = FrameMode::FixedRate;
+                targetFps = std::atof(pacing.c_str());
+            }
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::atoi(argv[++i]);
+        } else if (arg == "--steady") {
+            options.steady = true;
+        } else if (arg == "--damage-bench") {
+            damageBench = true;
+        } else if (arg == "--pipeline-stress") {
+            pipelineStress = true;
+        } else if (arg == "--layout-bench") {
+            layoutBench = true;
+        } else if (arg == "--stream-bench") {
+            streamBench = true;
+        } else if (arg == "--parse-bench") {
+            parseBench = true;
+        } else if (arg == "--load-bench") {
+            loadBench = true;
+        } else if (arg == "--text-bench") {
+            textBench = true;
+        } else if (arg == "--style-bench") {
+            styleBench = true;
+        } else if (arg == "--sharing-bench") {
+            sharingBench = true;
+        } else if (arg == "--hit-bench") {
+            hitBench = true;
+        } else if (arg == "--scroll-bench") {
+            scrollBench = true;
+        } else if (arg == "--token-bench") {
+            tokenBench = true;
+        } else if (arg == "--whitespace-check") {
+            whitespaceCheck = true;
+        } else if (arg == "--dom-bench") {
+            domBench = true;
+        } else if (arg == "--declaration-bench") {
+            declarationBench = true;
+        } else if (arg == "--relayout-bench") {
+            relayoutBench = true;
+        } else if (arg == "--compile" && hasValue) {
+            compileOutput = argv[++i];
+        } else if (arg == "--size" && hasValue) {
+            std::sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+        } else if (arg == "--font" && hasValue) {
+            options.font = argv[++i];
+        } else if (arg == "--scroll" && hasValue) {
+            options.scrollY = float(std::atof(argv[++i]));
+        } else if (arg == "--layout-threads" && hasValue) {
+            options.layoutThreads = unsigned(std::atoi(argv[++i]));
+        } else if (arg == "--out" && hasValue) {
+            options.output = argv[++i];
+        } else {
+            options.document = arg;
+        }
+    }
+
+    // the software backend never opens a window or touches GL
+    if (damageBench) return RunDamageBenchmark(options);
+    if (pipelineStress) return RunPipelineStress(options);
+    if (layoutBench) return RunLayoutBenchmark(options);
+    if (streamBench) return RunStreamBenchmark(options);
+    if (parseBench) return RunParseBenchmark(options);
+    if (loadBench) return RunLoadBenchmark(options);
+    if (textBench) return RunTextBenchmark(options);
+    if (styleBench) return RunStyleBenchmark(options);
+    if (sharingBench) return RunStyleSharingBenchmark(options);
+    if (hitBench) return RunHitTestBenchmark(options);
+    if (scrollBench) return RunScrollBenchmark(options);
+    if (tokenBench) return RunTokenBenchmark(options);
+    if (whitespaceCheck) return RunWhitespaceCheck(options);
+    if (domBench) return RunDomBenchmark(options);
+    if (declarationBench) return RunDeclarationBenchmark(options);
+    if (relayoutBench) return RunRelayoutBenchmark(options);
+    if (!compileOutput.empty()) return RunCompiler(options, compileOutput);
+    if (backend == RendererBackend::Software) return RunHeadless(options);
+
+    Example *e = new Example(1024, 768, "example", options.document);
+    e->SetLayoutThreads(options.layoutThreads);
+    e->SetFrameMode(frameMode, targetFps);
     e->Run();
-}
\ No newline at end of file
+}
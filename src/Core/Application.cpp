@@ -1,7 +1,23 @@
 #include <GL/glew.h>
 #include "Core/Application.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// An idle OnDemand loop still wakes this often to ask NeedsRedraw().
+constexpr double kIdleWaitSeconds = 0.25;
+
+double Milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}  // namespace
 
 Application::Application(int width, int height, const std::string& title) {
     window = new Window(width, height, title);
@@ -11,12 +27,91 @@ Application::Application(int width, int height, const std::string& title) {
     }
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    SetFrameMode(FrameMode::VSync);
+}
+
+Application::~Application() { delete window; }
+
+void Application::SetFrameMode(FrameMode mode, double targetFps) {
+    frameMode = mode;
+    framePeriod = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / std::max(targetFps, 1.0)));
+    window->SetSwapInterval(mode == FrameMode::VSync ? 1 : 0);
+}
+
+void Application::RequestRedraw() {
+    redrawRequested = true;
+    glfwPostEmptyEvent();
 }
 
 void Application::Run() {
     OnInit();
+    Clock::time_point nextFrame = Clock::now();
     while (!window->ShouldClose()) {
-        OnUpdate();
-        OnRender();
+        if (frameMode == FrameMode::OnDemand) {
+            uint64_t events = window->EventCount();
+            if (!redrawRequested) window->WaitEvents(kIdleWaitSeconds);
+            double update = TimeUpdate();
+            bool redraw = redrawRequested.exchange(false) ||
+                          window->EventCount() != events || NeedsRedraw();
+            if (redraw) RenderFrame(update);
+            continue;
+        }
+
+        window->PollEvents();
+        RenderFrame(TimeUpdate());
+        if (frameMode == FrameMode::FixedRate) {
+            // a late frame starts the schedule over instead of bursting
+            nextFrame = std::max(nextFrame + framePeriod, Clock::now());
+            std::this_thread::sleep_until(nextFrame);
+        }
     }
-}
\ No newline at end of file
+}
+
+double Application::TimeUpdate() {
+    Clock::time_point start = Clock::now();
+    std::vector<InputEvent> events = window->TakeEvents();
+    if (!events.empty()) OnInput(events);
+    OnUpdate();
+    return Milliseconds(Clock::now() - start);
+}
+
+void Application::RenderFrame(double update) {
+    Clock::time_point updated = Clock::now();
+    OnLayout();
+    Clock::time_point laidOut = Clock::now();
+    OnRender();
+    Clock::time_point painted = Clock::now();
+    window->SwapBuffers();
+    Clock::time_point presented = Clock::now();
+
+    FrameTiming timing;
+    timing.update = update;
+    timing.layout = Milliseconds(laidOut - updated);
+    timing.paint = Milliseconds(painted - laidOut);
+    timing.present = Milliseconds(presented - painted);
+    timing.total = update + Milliseconds(presented - updated);
+    lastTiming = timing;
+    timings[framesRendered % kTimingWindow] = timing;
+    framesRendered++;
+}
+
+FrameTiming Application::AverageFrameTiming() const {
+    FrameTiming average;
+    size_t count = std::min<uint64_t>(framesRendered, kTimingWindow);
+    for (size_t i = 0; i < count; i++) {
+        average.update += timings[i].update;
+        average.layout += timings[i].layout;
+        average.paint += timings[i].paint;
+        average.present += timings[i].present;
+        average.total += timings[i].total;
+    }
+    if (count > 0) {
+        average.update /= count;
+        average.layout /= count;
+        average.paint /= count;
+        average.present /= count;
+        average.total /= count;
+    }
+    return average;
+}
@@ -0,0 +1,49 @@
+#include "Core/Arena.h"
+#include <cstdint>
+#include <cstdlib>
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize) {}
+
+Arena::~Arena() { Reset(); }
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+    uintptr_t aligned =
+        (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) &
+        ~(uintptr_t(alignment) - 1);
+    if (cursor == nullptr ||
+        aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+        Grow(size + alignment);
+        aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) &
+                  ~(uintptr_t(alignment) - 1);
+    }
+
+    cursor = reinterpret_cast<char*>(aligned + size);
+    bytesAllocated += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::Grow(size_t minimum) {
+    // blocks double so a document of any size ends up in a handful of them
+    size_t size = blockSize;
+    if (!blocks.empty()) size = blocks.back().size * 2;
+    if (size < minimum) size = minimum;
+
+    char* data = static_cast<char*>(std::malloc(size));
+    if (data == nullptr) throw std::bad_alloc();
+
+    blocks.push_back({data, size});
+    cursor = data;
+    limit = data + size;
+    bytesReserved += size;
+}
+
+void Arena::Reset() {
+    for (Block& block : blocks) {
+        std::free(block.data);
+    }
+    blocks.clear();
+    cursor = nullptr;
+    limit = nullptr;
+    bytesAllocated = 0;
+    bytesReserved = 0;
+}
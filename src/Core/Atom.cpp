@@ -0,0 +1,50 @@
+#include "Core/Atom.h"
+#include <mutex>
+
+AtomTable& AtomTable::Global() {
+    static AtomTable table;
+    return table;
+}
+
+AtomTable::AtomTable() {
+    names.reserve(256);
+    ids.reserve(256);
+    for (std::string_view name : kWellKnownAtomNames) {
+        ids.emplace(name, static_cast<Atom>(names.size()));
+        names.push_back(name);
+    }
+}
+
+Atom AtomTable::Intern(std::string_view name) {
+    {
+        std::shared_lock lock(mutex);
+        auto iter = ids.find(name);
+        if (iter != ids.end()) return iter->second;
+    }
+
+    std::unique_lock lock(mutex);
+    auto iter = ids.find(name);
+    if (iter != ids.end()) return iter->second;
+
+    std::string_view stored = storage.emplace_back(name);
+    Atom atom = static_cast<Atom>(names.size());
+    names.push_back(stored);
+    ids.emplace(stored, atom);
+    return atom;
+}
+
+Atom AtomTable::Find(std::string_view name) const {
+    std::shared_lock lock(mutex);
+    auto iter = ids.find(name);
+    return iter != ids.end() ? iter->second : kInvalidAtom;
+}
+
+std::string_view AtomTable::Name(Atom atom) const {
+    std::shared_lock lock(mutex);
+    return atom < names.size() ? names[atom] : std::string_view();
+}
+
+size_t AtomTable::Size() const {
+    std::shared_lock lock(mutex);
+    return names.size();
+}
@@ -0,0 +1,90 @@
+#include "Core/Document.h"
+#include <cstring>
+
+// rough node density of typical markup, used to presize the node array
+static constexpr size_t kBytesPerNode = 48;
+
+Document::Document(size_t sourceSizeHint)
+    : arena(sourceSizeHint > 4096 ? sourceSizeHint : 4096) {
+    nodes.reserve(sourceSizeHint / kBytesPerNode);
+}
+
+NodeId Document::CreateNode(Atom tag) {
+    NodeId id = static_cast<NodeId>(nodes.size());
+    nodes.emplace_back();
+    nodes.back().tag = tag;
+    return id;
+}
+
+void Document::AppendChild(NodeId parent, NodeId child) {
+    Node& parentNode = nodes[parent];
+    nodes[child].parent = parent;
+    if (parentNode.lastChild == kInvalidNode) {
+        parentNode.firstChild = child;
+    } else {
+        nodes[parentNode.lastChild].nextSibling = child;
+    }
+    parentNode.lastChild = child;
+}
+
+void Document::SetAttribute(NodeId id, Atom name, std::string_view value) {
+    std::string_view stored = arena.CopyString(value);
+
+    Node& node = nodes[id];
+    NodeAttribute* attributes = const_cast<NodeAttribute*>(node.Attributes());
+    for (uint32_t i = 0; i < node.attributeCount; i++) {
+        if (attributes[i].name == name) {
+            attributes[i].value = stored;
+            return;
+        }
+    }
+
+    if (node.attributeCount == node.attributeCapacity) {
+        uint32_t capacity = node.attributeCapacity * 2;
+        NodeAttribute* spilled = arena.NewArray<NodeAttribute>(capacity);
+        std::memcpy(spilled, attributes,
+                    sizeof(NodeAttribute) * node.attributeCount);
+        node.spilledAttributes = spilled;
+        node.attributeCapacity = capacity;
+        attributes = spilled;
+    }
+    attributes[node.attributeCount++] = {name, stored};
+}
+
+void Document::AppendText(NodeId id, std::string_view text) {
+    if (text.empty()) return;
+
+    Node& node = nodes[id];
+    if (node.innerText.empty()) {
+        node.innerText = arena.CopyString(text);
+        return;
+    }
+
+    size_t length = node.innerText.size() + text.size();
+    char* joined = static_cast<char*>(arena.Allocate(length, 1));
+    std::memcpy(joined, node.innerText.data(), node.innerText.size());
+    std::memcpy(joined + node.innerText.size(), text.data(), text.size());
+    node.innerText = std::string_view(joined, length);
+}
+
+const NodeAttribute* Document::FindAttribute(NodeId id, Atom name) const {
+    const Node& node = nodes[id];
+    const NodeAttribute* attributes = node.Attributes();
+    for (uint32_t i = 0; i < node.attributeCount; i++) {
+        if (attributes[i].name == name) return &attributes[i];
+    }
+    return nullptr;
+}
+
+std::string_view Document::GetAttribute(NodeId id, Atom name) const {
+    const NodeAttribute* attribute = FindAttribute(id, name);
+    return attribute ? attribute->value : std::string_view();
+}
+
+bool Document::HasAttribute(NodeId id, Atom name) const {
+    return FindAttribute(id, name) != nullptr;
+}
+
+size_t Document::MemoryUsage() const {
+    return arena.BytesReserved() + nodes.capacity() * sizeof(Node);
+}
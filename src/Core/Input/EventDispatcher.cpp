@@ -0,0 +1,224 @@
+#include "Core/Input/EventDispatcher.h"
+#include <algorithm>
+
+namespace {
+
+// GLFW_MOUSE_BUTTON_LEFT, a click is a press and release of it
+constexpr int kPrimaryButton = 0;
+// pixels a wheel notch scrolls
+constexpr float kWheelStep = 40;
+
+// The deepest element that contains both, null if they are in different
+// trees.
+std::shared_ptr<Element> CommonAncestor(const std::shared_ptr<Element>& a,
+                                        const std::shared_ptr<Element>& b) {
+    std::vector<Element*> above;
+    for (Element* element = a.get(); element;
+         element = element->parent.lock().get()) {
+        above.push_back(element);
+    }
+    for (std::shared_ptr<Element> element = b; element;
+         element = element->parent.lock()) {
+        if (std::find(above.begin(), above.end(), element.get()) !=
+            above.end()) {
+            return element;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+ListenerId EventDispatcher::AddEventListener(const Element& element,
+                                             EventType type,
+                                             EventListener listener,
+                                             bool capture) {
+    if (element.index >= listeners.size()) {
+        listeners.resize(element.index + 1);
+    }
+    ListenerId id = nextId++;
+    listeners[element.index].push_back(
+        {id, type, capture, std::move(listener)});
+    owners[id] = element.index;
+    return id;
+}
+
+void EventDispatcher::RemoveEventListener(ListenerId id) {
+    auto owner = owners.find(id);
+    if (owner == owners.end()) return;
+    std::vector<Listener>& list = listeners[owner->second];
+    list.erase(std::find_if(list.begin(), list.end(),
+                            [id](const Listener& l) { return l.id == id; }));
+    owners.erase(owner);
+}
+
+void EventDispatcher::Dispatch(const std::vector<InputEvent>& events,
+                               const HitTestGrid& grid,
+                               const std::shared_ptr<Element>& root,
+                               LayoutEngine* layout) {
+    stats.inputEvents += events.size();
+    size_t lastMove = events.size();
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].type == InputEventType::MouseMove) lastMove = i;
+    }
+
+    for (size_t i = 0; i < events.size(); i++) {
+        const InputEvent& input = events[i];
+        switch (input.type) {
+            case InputEventType::MouseMove: {
+                if (i != lastMove) break;
+                stats.moves++;
+                stats.hitTests++;
+                std::shared_ptr<Element> target =
+                    grid.HitTest(input.x, input.y);
+                MoveHover(target, input);
+                if (target) Fire(EventType::MouseMove, target, input);
+                break;
+            }
+            case InputEventType::MouseDown:
+            case InputEventType::MouseUp: {
+                stats.hitTests++;
+                std::shared_ptr<Element> target =
+                    grid.HitTest(input.x, input.y);
+                MoveHover(target, input);
+                if (!target) {
+                    if (input.type == InputEventType::MouseUp) pressed.reset();
+                    break;
+                }
+                if (input.type == InputEventType::MouseDown) {
+                    if (input.button == kPrimaryButton) pressed = target;
+                    focused = target;
+                    Fire(EventType::MouseDown, target, input);
+                    break;
+                }
+                Fire(EventType::MouseUp, target, input);
+                if (input.button != kPrimaryButton) break;
+                std::shared_ptr<Element> down = pressed.lock();
+                pressed.reset();
+                if (!down) break;
+                std::shared_ptr<Element> clicked = CommonAncestor(down, target);
+                if (clicked) Fire(EventType::Click, clicked, input);
+                break;
+            }
+            case InputEventType::Scroll: {
+                stats.hitTests++;
+                std::shared_ptr<Element> target =
+                    grid.HitTest(input.x, input.y);
+                if (target && !Fire(EventType::Wheel, target, input)) break;
+                if (layout) Scroll(target, input, *layout);
+                break;
+            }
+            case InputEventType::KeyDown:
+            case InputEventType::KeyUp:
+            case InputEventType::Char: {
+                std::shared_ptr<Element> target = focused.lock();
+                if (!target) target = root;
+                if (!target) break;
+                EventType type = input.type == InputEventType::KeyDown
+                                     ? EventType::KeyDown
+                                 : input.type == InputEventType::KeyUp
+                                     ? EventType::KeyUp
+                                     : EventType::Char;
+                Fire(type, target, input);
+                break;
+            }
+        }
+    }
+}
+
+void EventDispatcher::MoveHover(const std::shared_ptr<Element>& target,
+                                const InputEvent& input) {
+    std::shared_ptr<Element> previous = hovered.lock();
+    if (previous == target) return;
+    hovered = target;
+    if (previous) {
+        Event out;
+        out.type = EventType::MouseOut;
+        out.target = previous;
+        out.relatedTarget = target;
+        out.x = input.x;
+        out.y = input.y;
+        DispatchEvent(out);
+    }
+    if (target) {
+        Event over;
+        over.type = EventType::MouseOver;
+        over.target = target;
+        over.relatedTarget = previous;
+        over.x = input.x;
+        over.y = input.y;
+        DispatchEvent(over);
+    }
+}
+
+void EventDispatcher::Scroll(const std::shared_ptr<Element>& target,
+                             const InputEvent& input, LayoutEngine& layout) {
+    float dx = -input.scrollX * kWheelStep, dy = -input.scrollY * kWheelStep;
+    for (std::shared_ptr<Element> element = target; element;
+         element = element->parent.lock()) {
+        const LayoutBox& box = layout.GetBox(*element);
+        if (layout.ScrollTo(*element, box.scrollX + dx, box.scrollY + dy)) {
+            return;
+        }
+    }
+    const Rect& viewport = layout.Viewport();
+    layout.ScrollViewportTo(viewport.x + dx, viewport.y + dy);
+}
+
+bool EventDispatcher::Fire(EventType type,
+                           const std::shared_ptr<Element>& target,
+                           const InputEvent& input) {
+    Event event;
+    event.type = type;
+    event.target = target;
+    event.x = input.x;
+    event.y = input.y;
+    event.button = input.button;
+    event.key = input.key;
+    event.mods = input.mods;
+    event.codepoint = input.codepoint;
+    event.scrollX = input.scrollX;
+    event.scrollY = input.scrollY;
+    DispatchEvent(event);
+    return !event.DefaultPrevented();
+}
+
+void EventDispatcher::DispatchEvent(Event& event) {
+    if (!event.target) return;
+    stats.events++;
+    // a listener may move elements around, the path is fixed up front
+    std::vector<std::shared_ptr<Element>> path;
+    for (std::shared_ptr<Element> element = event.target; element;
+         element = element->parent.lock()) {
+        path.push_back(element);
+    }
+
+    event.phase = EventPhase::Capture;
+    for (size_t i = path.size(); i-- > 1 && !event.PropagationStopped();) {
+        Notify(event, *(event.currentTarget = path[i]));
+    }
+    if (!event.PropagationStopped()) {
+        event.phase = EventPhase::Target;
+        Notify(event, *(event.currentTarget = path[0]));
+    }
+    event.phase = EventPhase::Bubble;
+    for (size_t i = 1; i < path.size() && !event.PropagationStopped(); i++) {
+        Notify(event, *(event.currentTarget = path[i]));
+    }
+    event.currentTarget.reset();
+}
+
+void EventDispatcher::Notify(Event& event, Element& element) {
+    // indices, not iterators: a listener may add or remove listeners
+    for (size_t i = 0; element.index < listeners.size() &&
+                       i < listeners[element.index].size();
+         i++) {
+        const Listener& listener = listeners[element.index][i];
+        if (listener.type != event.type) continue;
+        if (event.phase == EventPhase::Capture && !listener.capture) continue;
+        if (event.phase == EventPhase::Bubble && listener.capture) continue;
+        EventListener callback = listener.callback;
+        stats.listeners++;
+        callback(event);
+    }
+}
@@ -0,0 +1,367 @@
+#include "Core/Input/HitTestGrid.h"
+#include "Core/TreeAccess.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Cells are numbered from -kCellBias on each axis, 24 bits each in a key.
+constexpr int kCellBias = 1 << 23;
+// a few float ulps, relative
+constexpr float kRounding = 1.f / (1 << 21);
+
+bool SameRect(const Rect& a, const Rect& b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width &&
+           a.height == b.height;
+}
+
+uint64_t CellKey(uint32_t layer, int column, int row) {
+    return uint64_t(layer) << 48 | uint64_t(row + kCellBias) << 24 |
+           uint64_t(column + kCellBias);
+}
+
+void EraseValue(std::vector<uint32_t>& list, uint32_t value) {
+    auto found = std::find(list.begin(), list.end(), value);
+    if (found == list.end()) return;
+    *found = list.back();
+    list.pop_back();
+}
+
+// What an entry keeps to tell its node from another one later put under
+// the same index. An element is its address, as long as it lives; the
+// indices of a compiled document never change hands, so its nodes are
+// told apart by the document alone.
+const void* Identity(const ElementTree&, const Element* element) {
+    return element;
+}
+const void* Identity(const CompiledTree& tree, NodeId) {
+    return &tree.Document();
+}
+std::weak_ptr<Element> Handle(const ElementTree&, Element* element) {
+    return element->weak_from_this();
+}
+std::weak_ptr<Element> Handle(const CompiledTree&, NodeId) { return {}; }
+bool Gone(const ElementTree&, const std::weak_ptr<Element>& handle) {
+    return handle.expired();
+}
+bool Gone(const CompiledTree&, const std::weak_ptr<Element>&) {
+    return false;
+}
+
+}  // namespace
+
+HitTestGrid::HitTestGrid(float cellSize) : cellSize(cellSize) {
+    layers.emplace_back();
+}
+
+void HitTestGrid::Clear() {
+    entries.clear();
+    cells.clear();
+    layers.assign(1, Layer());
+    freeLayers.clear();
+    indexed.clear();
+    built = false;
+    stats = HitTestStats();
+}
+
+void HitTestGrid::Update(Element& root, const LayoutEngine& layout,
+                         const StyleTable& styles) {
+    UpdateTree(ElementTree(styles), &root, layout);
+}
+
+void HitTestGrid::Update(const CompiledTree& tree,
+                         const LayoutEngine& layout) {
+    if (tree.Root() == kInvalidNode) return;
+    UpdateTree(tree, tree.Root(), layout);
+}
+
+template <typename Tree>
+void HitTestGrid::UpdateTree(const Tree& tree, typename Tree::Node root,
+                             const LayoutEngine& layout) {
+    if (built && layout.Generation() == generation) return;
+    uint64_t seen = generation;
+    generation = layout.Generation();
+    built = true;
+    stats.moved = 0;
+
+    // rows of a virtualized list are met far apart, growing the table once
+    // saves copying it at every jump
+    uint32_t nodes = layout.SubtreeSize(tree.Index(root));
+    if (entries.size() < nodes) entries.resize(nodes);
+
+    stamp++;
+    skipped.clear();
+    sweep = false;
+    uint32_t order = 0;
+    if (!Visit(tree, root, layout, seen, 0, 0, 0, order)) sweep = true;
+
+    if (sweep) {
+        // whatever the walk neither reached nor skipped is gone or hidden
+        size_t kept = 0;
+        for (uint32_t index : indexed) {
+            Entry& entry = entries[index];
+            if (entry.stamp == stamp || Skipped(entry.order)) {
+                indexed[kept++] = index;
+                continue;
+            }
+            Remove(index);
+            ReleaseLayer(entry);
+            entry.stamp = 0;
+            entry.element.reset();
+            entry.raw = nullptr;
+            stats.moved++;
+        }
+        indexed.resize(kept);
+    }
+
+    // scrolling moves no boxes, only the layers they are in
+    const Rect& viewport = layout.Viewport();
+    layers[0].scrollX = viewport.x;
+    layers[0].scrollY = viewport.y;
+    stats.large = uint32_t(layers[0].largeBoxes.size());
+    for (size_t i = 1; i < layers.size(); i++) {
+        Layer& layer = layers[i];
+        stats.large += uint32_t(layer.largeBoxes.size());
+        if (layer.owner == kNoOwner) continue;
+        const LayoutBox& box = layout.GetBox(layer.owner);
+        layer.scrollX = box.scrollX;
+        layer.scrollY = box.scrollY;
+    }
+    stats.boxes = uint32_t(indexed.size());
+    stats.layers = uint32_t(layers.size() - 1 - freeLayers.size());
+}
+
+bool HitTestGrid::Skipped(uint32_t order) const {
+    // the ranges come in tree order
+    auto after = std::upper_bound(
+        skipped.begin(), skipped.end(), order,
+        [](uint32_t value, const std::pair<uint32_t, uint32_t>& range) {
+            return value < range.first;
+        });
+    return after != skipped.begin() && order < std::prev(after)->second;
+}
+
+template <typename Tree>
+bool HitTestGrid::Visit(const Tree& tree, typename Tree::Node node,
+                        const LayoutEngine& layout, uint64_t seen,
+                        uint32_t layer, float parentX, float parentY,
+                        uint32_t& order) {
+    uint32_t index = tree.Index(node);
+    const ComputedStyle& style = tree.Style(node);
+    if (style.display == Display::None) {
+        order += layout.SubtreeSize(index);
+        return false;
+    }
+    const LayoutBox& box = layout.GetBox(index);
+    Rect bounds = {parentX + box.x, parentY + box.y, box.width, box.height};
+    uint32_t end = order + layout.SubtreeSize(index);
+
+    if (index >= entries.size()) entries.resize(index + 1);
+    Entry& entry = entries[index];
+    const void* identity = Identity(tree, node);
+    // laid out before the last update, at the same place and position in
+    // the tree: every box below is indexed where it still is
+    if (entry.stamp != 0 && entry.raw == identity && entry.order == order &&
+        entry.layer == layer && layout.BoxGeneration(index) <= seen &&
+        SameRect(entry.bounds, bounds)) {
+        skipped.push_back({order, end});
+        order = end;
+        return true;
+    }
+    if (entry.raw != identity || Gone(tree, entry.element)) {
+        // another element under a reused index, the old one is gone
+        if (entry.stamp != 0) sweep = true;
+        ReleaseLayer(entry);
+        entry.raw = identity;
+        entry.element = Handle(tree, node);
+    }
+    // the order lives in the entry only, a new one moves no cells
+    entry.order = order++;
+    if (entry.stamp == 0) {
+        indexed.push_back(index);
+        entry.bounds = bounds;
+        entry.layer = layer;
+        Insert(index);
+        stats.moved++;
+    } else if (entry.layer != layer || !SameRect(entry.bounds, bounds)) {
+        Remove(index);
+        entry.bounds = bounds;
+        entry.layer = layer;
+        Insert(index);
+        stats.moved++;
+    }
+    entry.stamp = stamp;
+
+    // the content of a clipping box goes in a layer of its own
+    bool clips = style.overflow != Overflow::Visible;
+    if (!clips) {
+        ReleaseLayer(entry);
+    } else if (entry.inner == 0) {
+        uint32_t inner = AddLayer(index);
+        entries[index].inner = inner;
+    }
+    uint32_t inner = clips ? entries[index].inner : layer;
+    float originX = clips ? 0 : bounds.x, originY = clips ? 0 : bounds.y;
+
+    // a child that was indexed under this element last time and is not
+    // now went away or was hidden, and only then is the index swept; rows
+    // a virtualized block left out are not visited either
+    auto [first, last] = layout.LaidOutChildren(tree, node);
+    order += uint32_t(first);  // below their real orders, still in sequence
+    uint32_t kept = 0, children = 0;
+    for (size_t i = first; i < last; i++) {
+        typename Tree::Node child = tree.Child(node, i);
+        uint32_t childIndex = tree.Index(child);
+        bool known = false;
+        if (childIndex < entries.size()) {
+            const Entry& previous = entries[childIndex];
+            known = previous.stamp != 0 &&
+                    previous.raw == Identity(tree, child) &&
+                    previous.parent == index;
+        }
+        if (Visit(tree, child, layout, seen, inner, originX, originY,
+                  order)) {
+            entries[childIndex].parent = index;
+            kept += known;
+            children++;
+        }
+    }
+    order = end;
+    Entry& self = entries[index];  // the visits may have grown it
+    if (kept != self.children) sweep = true;
+    self.children = children;
+    return true;
+}
+
+uint32_t HitTestGrid::AddLayer(uint32_t owner) {
+    uint32_t layer;
+    if (freeLayers.empty()) {
+        layer = uint32_t(layers.size());
+        layers.emplace_back();
+    } else {
+        layer = freeLayers.back();
+        freeLayers.pop_back();
+    }
+    layers[layer].owner = owner;
+    return layer;
+}
+
+void HitTestGrid::ReleaseLayer(Entry& entry) {
+    if (entry.inner == 0) return;
+    // what is still in it is moved out or swept by this Update()
+    Layer& layer = layers[entry.inner];
+    layer.owner = kNoOwner;
+    layer.scrollX = layer.scrollY = 0;
+    freeLayers.push_back(entry.inner);
+    entry.inner = 0;
+}
+
+int HitTestGrid::Cell(float position) const {
+    return std::clamp(int(std::floor(position / cellSize)), -kCellBias,
+                      kCellBias - 1);
+}
+
+void HitTestGrid::Insert(uint32_t index) {
+    Entry& entry = entries[index];
+    entry.large = false;
+    entry.inCells = false;
+    if (entry.bounds.IsEmpty()) return;  // nothing to hit
+
+    const Rect& bounds = entry.bounds;
+    int left = Cell(bounds.x);
+    int top = Cell(bounds.y);
+    // the far edges are exclusive
+    int right = Cell(std::nextafter(bounds.x + bounds.width, bounds.x));
+    int bottom = Cell(std::nextafter(bounds.y + bounds.height, bounds.y));
+    if (uint64_t(right - left + 1) * (bottom - top + 1) > kMaxCellsPerBox) {
+        entry.large = true;
+        layers[entry.layer].largeBoxes.push_back(index);
+        return;
+    }
+    entry.inCells = true;
+    entry.left = left;
+    entry.top = top;
+    entry.right = right;
+    entry.bottom = bottom;
+    for (int y = top; y <= bottom; y++) {
+        for (int x = left; x <= right; x++) {
+            cells[CellKey(entry.layer, x, y)].push_back(index);
+        }
+    }
+    stats.cellEntries += size_t(right - left + 1) * (bottom - top + 1);
+}
+
+void HitTestGrid::Remove(uint32_t index) {
+    Entry& entry = entries[index];
+    if (entry.large) {
+        EraseValue(layers[entry.layer].largeBoxes, index);
+        entry.large = false;
+        return;
+    }
+    if (!entry.inCells) return;
+    for (int y = entry.top; y <= entry.bottom; y++) {
+        for (int x = entry.left; x <= entry.right; x++) {
+            auto cell = cells.find(CellKey(entry.layer, x, y));
+            if (cell == cells.end()) continue;
+            EraseValue(cell->second, index);
+            if (cell->second.empty()) cells.erase(cell);
+        }
+    }
+    stats.cellEntries -= size_t(entry.right - entry.left + 1) *
+                         (entry.bottom - entry.top + 1);
+    entry.inCells = false;
+}
+
+const HitTestGrid::Entry* HitTestGrid::Find(uint32_t layer, float x, float y,
+                                            float originX, float originY,
+                                            const Entry* best) const {
+    // boxes are placed from the origin the way paint places them, so a far
+    // scrolled layer rounds like the picture does
+    auto consider = [&](uint32_t index) {
+        const Entry& entry = entries[index];
+        float left = originX + entry.bounds.x, top = originY + entry.bounds.y;
+        if (x < left || y < top || x >= left + entry.bounds.width ||
+            y >= top + entry.bounds.height) {
+            return;
+        }
+        if (!best || entry.order > best->order) best = &entry;
+        // what it clips is only there inside it
+        if (entry.inner != 0) {
+            const Layer& inner = layers[entry.inner];
+            best = Find(entry.inner, x, y, left - inner.scrollX,
+                        top - inner.scrollY, best);
+        }
+    };
+    // far from the origin the point in the layer may round across a cell
+    // edge the box test does not, both cells are looked at then
+    float layerX = x - originX, layerY = y - originY;
+    float slackX = (std::abs(originX) + std::abs(layerX)) * kRounding;
+    float slackY = (std::abs(originY) + std::abs(layerY)) * kRounding;
+    for (int row = Cell(layerY - slackY); row <= Cell(layerY + slackY);
+         row++) {
+        for (int column = Cell(layerX - slackX);
+             column <= Cell(layerX + slackX); column++) {
+            auto cell = cells.find(CellKey(layer, column, row));
+            if (cell == cells.end()) continue;
+            for (uint32_t index : cell->second) consider(index);
+        }
+    }
+    for (uint32_t index : layers[layer].largeBoxes) consider(index);
+    return best;
+}
+
+const HitTestGrid::Entry* HitTestGrid::Top(float x, float y) const {
+    if (!built) return nullptr;
+    const Layer& page = layers[0];
+    return Find(0, x, y, -page.scrollX, -page.scrollY, nullptr);
+}
+
+std::shared_ptr<Element> HitTestGrid::HitTest(float x, float y) const {
+    const Entry* best = Top(x, y);
+    return best ? best->element.lock() : nullptr;
+}
+
+NodeId HitTestGrid::HitTestNode(float x, float y) const {
+    const Entry* best = Top(x, y);
+    return best ? NodeId(best - entries.data()) : kInvalidNode;
+}
@@ -0,0 +1,695 @@
+#include "Core/Layout/LayoutEngine.h"
+#include "Core/ThreadPool.h"
+#include "Core/TreeAccess.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace {
+
+constexpr float kUnboundedWidth = 1e9f;
+
+float Horizontal(const Length (&sides)[4], float reference) {
+    return sides[kLeft].Resolve(reference, 0) +
+           sides[kRight].Resolve(reference, 0);
+}
+
+float Vertical(const Length (&sides)[4], float reference) {
+    return sides[kTop].Resolve(reference, 0) +
+           sides[kBottom].Resolve(reference, 0);
+}
+
+// Used until a font-backed measurer is installed: fixed half-em advances,
+// wrapped into as many lines as the width needs.
+TextSize EstimateText(std::string_view text, float fontSize, float maxWidth) {
+    float width = float(text.size()) * fontSize * 0.5f;
+    float lines = 1;
+    if (maxWidth > 0 && width > maxWidth) {
+        lines = std::ceil(width / maxWidth);
+        width = maxWidth;
+    }
+    return {width, lines * fontSize * 1.2f};
+}
+
+// Union that ignores empty rectangles.
+Rect Cover(const Rect& a, const Rect& b) {
+    if (a.IsEmpty()) return b;
+    if (b.IsEmpty()) return a;
+    return a.Union(b);
+}
+
+// Rows [first, end) of a virtualized block in view when its content is
+// scrolled to scrollY, with overscan times the view height more on each
+// side.
+std::pair<size_t, size_t> RowWindow(float rowsTop, float rowHeight,
+                                    size_t count, float scrollY,
+                                    float viewHeight, float overscan) {
+    float margin = viewHeight * overscan;
+    float begin = std::floor((scrollY - margin - rowsTop) / rowHeight);
+    float end =
+        std::ceil((scrollY + viewHeight + margin - rowsTop) / rowHeight);
+    auto clamp = [count](float row) {
+        return size_t(std::clamp(row, 0.f, float(count)));
+    };
+    return {clamp(begin), clamp(end)};
+}
+
+constexpr float kOverscan = 0.5f;
+
+}  // namespace
+
+LayoutEngine::LayoutEngine(StyleTable& styles)
+    : styles(styles), measureText(EstimateText) {}
+
+void LayoutEngine::SetTextMeasurer(TextMeasurer measurer) {
+    measureText = std::move(measurer);
+    Invalidate();
+}
+
+void LayoutEngine::SetThreadPool(ThreadPool* pool, uint32_t grainSize) {
+    this->pool = pool;
+    this->grainSize = std::max(grainSize, 1u);
+}
+
+void LayoutEngine::Invalidate() {
+    invalidated = true;
+    for (NodeLayout& node : nodes) {
+        node.valid = false;
+        node.intrinsicPass = 0;
+    }
+}
+
+void LayoutEngine::AdoptStyles() {
+    Invalidate();
+    invalidated = false;
+}
+
+LayoutEngine::NodeLayout& LayoutEngine::Slot(uint32_t index) {
+    if (index >= nodes.size()) nodes.resize(index + 1);
+    return nodes[index];
+}
+
+void LayoutEngine::Layout(Element& root, float viewportWidth,
+                          float viewportHeight) {
+    // dirty bits live on the tree, an engine that has not seen it yet
+    // restyles everything
+    ElementTree tree(styles);
+    LayoutRoot(tree, &root, viewportWidth, viewportHeight, invalidated);
+    invalidated = false;
+}
+
+void LayoutEngine::Layout(CompiledTree& tree, float viewportWidth,
+                          float viewportHeight) {
+    if (tree.Root() == kInvalidNode) return;
+    LayoutRoot(tree, tree.Root(), viewportWidth, viewportHeight, false);
+}
+
+template <typename Tree>
+void LayoutEngine::LayoutRoot(Tree& tree, typename Tree::Node root,
+                              float viewportWidth, float viewportHeight,
+                              bool restyle) {
+    pass++;
+    stats = LayoutStats();
+
+    // new nodes are always style- or layout-dirty, so this walk also sizes
+    // the box array before layout starts taking references into it
+    styles.BeginWalk();
+    UpdateStyles(tree, root, ComputedStyle(), restyle);
+
+    LayoutNode(tree, root, {viewportWidth, viewportHeight, -1, -1}, stats);
+    rootIndex = tree.Index(root);
+    LayoutBox& page = nodes[rootIndex].box;
+    page.x = 0;
+    page.y = 0;
+
+    Rect previous = viewport;
+    viewport.width = viewportWidth;
+    viewport.height = viewportHeight;
+    ScrollViewportTo(previous.x, previous.y);  // clamps to the new page
+    if (stats.stylesResolved || stats.nodesLaidOut ||
+        viewport.width != previous.width ||
+        viewport.height != previous.height) {
+        generation++;
+    }
+}
+
+bool LayoutEngine::ScrollViewportTo(float x, float y) {
+    if (rootIndex >= nodes.size()) return false;
+    const Rect& page = nodes[rootIndex].box.overflow;
+    x = std::clamp(x, 0.f, std::max(0.f, page.x + page.width - viewport.width));
+    y = std::clamp(y, 0.f,
+                   std::max(0.f, page.y + page.height - viewport.height));
+    if (x == viewport.x && y == viewport.y) return false;
+    viewport.x = x;
+    viewport.y = y;
+    generation++;
+    return true;
+}
+
+bool LayoutEngine::ScrollTo(Element& element, float x, float y) {
+    ElementTree tree(styles);
+    return ScrollNode(tree, &element, x, y);
+}
+
+bool LayoutEngine::ScrollTo(CompiledTree& tree, NodeId id, float x, float y) {
+    return ScrollNode(tree, id, x, y);
+}
+
+template <typename Tree>
+bool LayoutEngine::ScrollNode(Tree& tree, typename Tree::Node node, float x,
+                              float y) {
+    uint32_t index = tree.Index(node);
+    if (index >= nodes.size()) return false;
+    const ComputedStyle& style = tree.Style(node);
+    if (style.display == Display::None ||
+        style.overflow == Overflow::Visible) {
+        return false;
+    }
+    NodeLayout& layout = nodes[index];
+    LayoutBox& box = layout.box;
+    x = std::clamp(x, 0.f, std::max(0.f, box.scrollWidth - box.width));
+    y = std::clamp(y, 0.f, std::max(0.f, box.scrollHeight - box.height));
+    if (x == box.scrollX && y == box.scrollY) return false;
+    box.scrollX = x;
+    box.scrollY = y;
+    generation++;
+
+    // the rows laid out cover half a view more, small steps stay inside
+    if (layout.rowHeight > 0) {
+        auto [first, end] =
+            RowWindow(layout.rowsTop, layout.rowHeight, tree.ChildCount(node),
+                      y, box.height, 0);
+        if (first < layout.firstChild || end > layout.endChild) {
+            tree.MarkDirty(node, kDirtyLayout);
+        }
+    }
+    return true;
+}
+
+template <typename Tree>
+uint32_t LayoutEngine::UpdateStyles(Tree& tree, typename Tree::Node node,
+                                    const ComputedStyle& parent,
+                                    bool parentChanged) {
+    uint32_t index = tree.Index(node);
+    Slot(index);
+
+    // subtree sizes are counted on the way, a skipped subtree keeps its size
+    uint32_t size = 1;
+    if (parentChanged || (tree.Dirty(node) & kDirtyStyle)) {
+        // a reference into the table: sharing compares parents by address
+        const ComputedStyle& style = tree.Resolve(styles, node, parent);
+        stats.stylesResolved++;
+        tree.Dirty(node) = (tree.Dirty(node) & ~kDirtyStyle) | kDirtyLayout;
+        tree.PushAncestor(styles, node);
+        for (size_t i = 0; i < tree.ChildCount(node); i++) {
+            size += UpdateStyles(tree, tree.Child(node, i), style, true);
+        }
+        tree.PopAncestor(styles);
+    } else if (tree.Dirty(node) & kDirtyDescendants) {
+        const ComputedStyle& style = tree.Style(node);
+        tree.PushAncestor(styles, node);
+        for (size_t i = 0; i < tree.ChildCount(node); i++) {
+            size += UpdateStyles(tree, tree.Child(node, i), style, false);
+        }
+        tree.PopAncestor(styles);
+    } else {
+        return nodes[index].subtreeSize;
+    }
+    nodes[index].subtreeSize = size;
+    return size;
+}
+
+template <typename Tree>
+const LayoutBox& LayoutEngine::LayoutNode(Tree& tree, typename Tree::Node node,
+                                          const Constraint& constraint,
+                                          LayoutStats& counts) {
+    NodeLayout& layout = nodes[tree.Index(node)];
+    if (!(tree.Dirty(node) & (kDirtyLayout | kDirtyDescendants)) &&
+        layout.valid && layout.constraint == constraint) {
+        counts.nodesReused++;
+        return layout.box;
+    }
+    counts.nodesLaidOut++;
+    layout.boxGeneration = generation + 1;  // Layout() bumps it on the way out
+    if (layout.intrinsicPass != pass) layout.intrinsicPass = 0;
+
+    const ComputedStyle& style = tree.Style(node);
+    LayoutBox& box = layout.box;
+    box.text = Rect();
+
+    float width = 0, height = 0, naturalHeight = 0, contentBottom = 0;
+    if (style.display != Display::None) {
+        float reference = constraint.availableWidth;
+        float paddingX = Horizontal(style.padding, reference);
+        float paddingY = Vertical(style.padding, reference);
+
+        if (constraint.forcedWidth >= 0) {
+            width = constraint.forcedWidth;
+        } else if (!style.width.IsAuto()) {
+            width = style.width.Resolve(reference, 0) + paddingX;
+        } else {
+            width = reference - Horizontal(style.margin, reference);
+        }
+        width = std::max(width, paddingX);
+
+        float specifiedHeight = -1;
+        if (style.height.unit == LengthUnit::Px ||
+            (style.height.unit == LengthUnit::Percent &&
+             constraint.availableHeight >= 0)) {
+            specifiedHeight =
+                style.height.Resolve(constraint.availableHeight, 0) + paddingY;
+        }
+        height = constraint.forcedHeight >= 0 ? constraint.forcedHeight
+                                              : specifiedHeight;
+
+        float contentWidth = width - paddingX;
+        float contentHeight = height >= 0 ? std::max(0.f, height - paddingY)
+                                          : -1;
+        float left = style.padding[kLeft].Resolve(reference, 0);
+        float top = style.padding[kTop].Resolve(reference, 0);
+
+        layout.firstChild = 0;
+        layout.endChild = kAllChildren;
+        layout.rowHeight = 0;
+        float used = style.display == Display::Flex
+                         ? LayoutFlex(tree, node, style, contentWidth,
+                                      contentHeight, left, top, counts)
+                         : LayoutBlock(tree, node, style, contentWidth,
+                                       contentHeight, left, top, counts);
+        naturalHeight =
+            specifiedHeight >= 0 ? specifiedHeight : used + paddingY;
+        if (height < 0) height = naturalHeight;
+        contentBottom = top + used;
+    }
+
+    box.width = width;
+    box.height = height;
+    if (style.display != Display::None) {
+        FinishOverflow(tree, node, style, contentBottom);
+    } else {
+        box.overflow = Rect();
+    }
+    layout.naturalHeight = naturalHeight;
+    layout.constraint = constraint;
+    layout.valid = true;
+    tree.Dirty(node) &= ~(kDirtyLayout | kDirtyDescendants);
+    return box;
+}
+
+template <typename Tree>
+float LayoutEngine::LayoutBlock(Tree& tree, typename Tree::Node node,
+                                const ComputedStyle& style,
+                                float contentWidth, float contentHeight,
+                                float left, float top, LayoutStats& counts) {
+    uint32_t index = tree.Index(node);
+    size_t count = tree.ChildCount(node);
+    float y = 0;
+    std::string_view text = tree.Text(node);
+    if (!text.empty()) {
+        TextSize size =
+            measureText(text, style.fontSize.Resolve(0, 16), contentWidth);
+        nodes[index].box.text = {left, top, size.width, size.height};
+        y += size.height;
+    }
+    if (style.virtualize == Virtualize::Rows &&
+        style.overflow != Overflow::Visible && contentHeight >= 0 &&
+        count > 0) {
+        return LayoutRows(tree, node, contentWidth, contentHeight, left, top,
+                          y, counts);
+    }
+
+    // block children are sized independently of each other and only placed
+    // in order, so big child lists are laid out in parallel first
+    Constraint constraint = {contentWidth, contentHeight, -1, -1};
+    if (pool && count > 1 && nodes[index].subtreeSize >= 2 * grainSize) {
+        LayoutChildren(tree, node, constraint, counts);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            LayoutNode(tree, tree.Child(node, i), constraint, counts);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        typename Tree::Node child = tree.Child(node, i);
+        const ComputedStyle& childStyle = tree.Style(child);
+        LayoutBox& childBox = nodes[tree.Index(child)].box;
+        if (childStyle.display == Display::None) {
+            childBox.x = left;
+            childBox.y = top + y;
+            continue;
+        }
+
+        float marginTop = childStyle.margin[kTop].Resolve(contentWidth, 0);
+        float marginBottom =
+            childStyle.margin[kBottom].Resolve(contentWidth, 0);
+        childBox.x = left + childStyle.margin[kLeft].Resolve(contentWidth, 0);
+        childBox.y = top + y + marginTop;
+        y += marginTop + childBox.height + marginBottom;
+    }
+    return y;
+}
+
+template <typename Tree>
+float LayoutEngine::LayoutRows(Tree& tree, typename Tree::Node node,
+                               float contentWidth, float contentHeight,
+                               float left, float top, float y,
+                               LayoutStats& counts) {
+    NodeLayout& layout = nodes[tree.Index(node)];
+    Constraint constraint = {contentWidth, contentHeight, -1, -1};
+    size_t count = tree.ChildCount(node);
+
+    // the first row measures them all
+    typename Tree::Node sample = tree.Child(node, 0);
+    const ComputedStyle& sampleStyle = tree.Style(sample);
+    float sampleHeight = LayoutNode(tree, sample, constraint, counts).height;
+    if (sampleStyle.display != Display::None) {
+        sampleHeight += sampleStyle.margin[kTop].Resolve(contentWidth, 0) +
+                        sampleStyle.margin[kBottom].Resolve(contentWidth, 0);
+    }
+    layout.rowHeight = std::max(sampleHeight, 1.f);
+    layout.rowsTop = top + y;
+
+    // the offset is clamped once the content size is known, clamp it here
+    // too so the rows match it
+    float rowsHeight = float(count) * layout.rowHeight;
+    float viewHeight = contentHeight + top;
+    float scrollY = std::clamp(layout.box.scrollY, 0.f,
+                               std::max(0.f, y + rowsHeight - contentHeight));
+    auto [first, end] = RowWindow(layout.rowsTop, layout.rowHeight, count,
+                                  scrollY, viewHeight, kOverscan);
+    layout.firstChild = uint32_t(first);
+    layout.endChild = uint32_t(end);
+
+    for (size_t i = first; i < end; i++) {
+        typename Tree::Node child = tree.Child(node, i);
+        if (i > 0) LayoutNode(tree, child, constraint, counts);
+        const ComputedStyle& childStyle = tree.Style(child);
+        LayoutBox& childBox = nodes[tree.Index(child)].box;
+        childBox.x = left + childStyle.margin[kLeft].Resolve(contentWidth, 0);
+        childBox.y = layout.rowsTop + float(i) * layout.rowHeight;
+        if (childStyle.display != Display::None) {
+            childBox.y += childStyle.margin[kTop].Resolve(contentWidth, 0);
+        }
+    }
+    return y + rowsHeight;
+}
+
+template <typename Tree>
+void LayoutEngine::FinishOverflow(Tree& tree, typename Tree::Node node,
+                                  const ComputedStyle& style,
+                                  float contentBottom) {
+    NodeLayout& layout = nodes[tree.Index(node)];
+    LayoutBox& box = layout.box;
+    Rect content = box.text;
+    auto [first, end] = LaidOutChildren(tree, node);
+    // hidden children have an empty overflow where they would have gone
+    float lastTop = -std::numeric_limits<float>::infinity();
+    float lastBottom = lastTop;
+    layout.childrenSorted = true;
+    for (size_t i = first; i < end; i++) {
+        typename Tree::Node child = tree.Child(node, i);
+        const LayoutBox& childBox = nodes[tree.Index(child)].box;
+        float childTop = childBox.y + childBox.overflow.y;
+        float childBottom = childTop + childBox.overflow.height;
+        layout.childrenSorted = layout.childrenSorted &&
+                                childTop >= lastTop &&
+                                childBottom >= lastBottom;
+        lastTop = childTop;
+        lastBottom = childBottom;
+        if (tree.Style(child).display == Display::None) continue;
+        content = Cover(content, {childBox.x + childBox.overflow.x,
+                                  childBox.y + childBox.overflow.y,
+                                  childBox.overflow.width,
+                                  childBox.overflow.height});
+    }
+
+    box.overflow = {0, 0, box.width, box.height};
+    if (style.overflow == Overflow::Visible) {
+        box.overflow = Cover(box.overflow, content);
+        box.scrollX = box.scrollY = 0;
+        box.scrollWidth = box.width;
+        box.scrollHeight = box.height;
+        return;
+    }
+    // the content of a clipping box is what scrolls
+    float paddingRight = style.padding[kRight].Resolve(box.width, 0);
+    float paddingBottom = style.padding[kBottom].Resolve(box.width, 0);
+    float right = content.IsEmpty() ? 0 : content.x + content.width;
+    float bottom = std::max(contentBottom,
+                            content.IsEmpty() ? 0 : content.y + content.height);
+    box.scrollWidth = std::max(box.width, right + paddingRight);
+    box.scrollHeight = std::max(box.height, bottom + paddingBottom);
+    box.scrollX = std::clamp(box.scrollX, 0.f, box.scrollWidth - box.width);
+    box.scrollY = std::clamp(box.scrollY, 0.f, box.scrollHeight - box.height);
+}
+
+template <typename Tree>
+void LayoutEngine::LayoutChildren(Tree& tree, typename Tree::Node node,
+                                  const Constraint& constraint,
+                                  LayoutStats& counts) {
+    // consecutive children are grouped into tasks of at least grainSize
+    // nodes, small subtrees are not worth a task each
+    size_t count = tree.ChildCount(node);
+    std::vector<std::pair<size_t, size_t>> chunks;
+    size_t begin = 0;
+    uint32_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        size += nodes[tree.Index(tree.Child(node, i))].subtreeSize;
+        if (size >= grainSize) {
+            chunks.push_back({begin, i + 1});
+            begin = i + 1;
+            size = 0;
+        }
+    }
+    if (begin < count) chunks.push_back({begin, count});
+
+    std::vector<LayoutStats> chunkCounts(chunks.size());
+    pool->ParallelFor(chunks.size(), [&](size_t chunk) {
+        for (size_t i = chunks[chunk].first; i < chunks[chunk].second; i++) {
+            LayoutNode(tree, tree.Child(node, i), constraint,
+                       chunkCounts[chunk]);
+        }
+    });
+    for (const LayoutStats& chunk : chunkCounts) {
+        counts.nodesLaidOut += chunk.nodesLaidOut;
+        counts.nodesReused += chunk.nodesReused;
+    }
+}
+
+template <typename Tree>
+float LayoutEngine::LayoutFlex(Tree& tree, typename Tree::Node node,
+                               const ComputedStyle& style, float contentWidth,
+                               float contentHeight, float left, float top,
+                               LayoutStats& counts) {
+    using Node = typename Tree::Node;
+    struct FlexItem {
+        Node node;  // kNone for the element's own text run
+        Constraint constraint;
+        float main, cross;
+        float mainBefore, mainAfter, crossBefore, crossAfter;
+    };
+
+    bool row = style.flexDirection == FlexDirection::Row;
+    size_t children = tree.ChildCount(node);
+    std::vector<FlexItem> items;
+    items.reserve(children + 1);
+
+    std::string_view text = tree.Text(node);
+    if (!text.empty()) {
+        TextSize size =
+            measureText(text, style.fontSize.Resolve(0, 16), contentWidth);
+        items.push_back({Tree::kNone, {}, row ? size.width : size.height,
+                         row ? size.height : size.width, 0, 0, 0, 0});
+    }
+
+    for (size_t i = 0; i < children; i++) {
+        Node child = tree.Child(node, i);
+        const ComputedStyle& childStyle = tree.Style(child);
+        Constraint constraint = {contentWidth, contentHeight, -1, -1};
+        if (childStyle.display == Display::None) {
+            LayoutNode(tree, child, constraint, counts);
+            continue;
+        }
+
+        const Length* margin = childStyle.margin;
+        float marginLeft = margin[kLeft].Resolve(contentWidth, 0);
+        float marginRight = margin[kRight].Resolve(contentWidth, 0);
+        float marginTop = margin[kTop].Resolve(contentWidth, 0);
+        float marginBottom = margin[kBottom].Resolve(contentWidth, 0);
+        bool stretch = style.alignItems == AlignItems::Stretch;
+
+        if (childStyle.width.IsAuto()) {
+            float available =
+                std::max(0.f, contentWidth - marginLeft - marginRight);
+            constraint.forcedWidth =
+                !row && stretch
+                    ? available
+                    : std::min(IntrinsicWidth(tree, child), available);
+        }
+
+        if (row) {
+            bool stretchHeight = stretch && childStyle.height.IsAuto();
+            if (stretchHeight && contentHeight >= 0) {
+                constraint.forcedHeight = std::max(
+                    0.f, contentHeight - marginTop - marginBottom);
+            }
+
+            // Stretched items need their natural height before the line is
+            // sized; a clean item answers from cache instead of being laid
+            // out unstretched and then stretched again.
+            float width, naturalHeight;
+            NodeLayout& cached = nodes[tree.Index(child)];
+            if (stretchHeight && constraint.forcedHeight < 0 && cached.valid &&
+                !(tree.Dirty(child) & (kDirtyLayout | kDirtyDescendants)) &&
+                cached.constraint.availableWidth == constraint.availableWidth &&
+                cached.constraint.availableHeight ==
+                    constraint.availableHeight &&
+                cached.constraint.forcedWidth == constraint.forcedWidth) {
+                counts.nodesReused++;
+                width = cached.box.width;
+                naturalHeight = cached.naturalHeight;
+            } else {
+                const LayoutBox& box =
+                    LayoutNode(tree, child, constraint, counts);
+                width = box.width;
+                naturalHeight = box.height;
+            }
+            items.push_back({child, constraint, width, naturalHeight,
+                             marginLeft, marginRight, marginTop,
+                             marginBottom});
+        } else {
+            const LayoutBox& box = LayoutNode(tree, child, constraint, counts);
+            items.push_back({child, constraint, box.height, box.width,
+                             marginTop, marginBottom, marginLeft,
+                             marginRight});
+        }
+    }
+
+    float crossSize = row ? contentHeight : contentWidth;
+    if (crossSize < 0) {
+        crossSize = 0;
+        for (const FlexItem& item : items) {
+            crossSize = std::max(crossSize, item.crossBefore + item.cross +
+                                                item.crossAfter);
+        }
+    }
+
+    // row items with auto height stretch to the line once it is known
+    if (row && style.alignItems == AlignItems::Stretch) {
+        for (FlexItem& item : items) {
+            if (item.node == Tree::kNone || item.constraint.forcedHeight >= 0 ||
+                !tree.Style(item.node).height.IsAuto())
+                continue;
+            item.constraint.forcedHeight =
+                std::max(0.f, crossSize - item.crossBefore - item.crossAfter);
+            item.cross =
+                LayoutNode(tree, item.node, item.constraint, counts).height;
+        }
+    }
+
+    float used = 0;
+    for (const FlexItem& item : items) {
+        used += item.mainBefore + item.main + item.mainAfter;
+    }
+    float containerMain =
+        row ? contentWidth : (contentHeight >= 0 ? contentHeight : used);
+    float freeSpace = containerMain - used;
+    float count = float(items.size());
+
+    float cursor = 0, gap = 0;
+    switch (style.justifyContent) {
+        case JustifyContent::FlexStart: break;
+        case JustifyContent::FlexEnd: cursor = freeSpace; break;
+        case JustifyContent::Center: cursor = freeSpace / 2; break;
+        case JustifyContent::SpaceBetween:
+            if (items.size() > 1) gap = std::max(0.f, freeSpace) / (count - 1);
+            break;
+        case JustifyContent::SpaceAround:
+            if (!items.empty()) gap = std::max(0.f, freeSpace) / count;
+            cursor = gap / 2;
+            break;
+        case JustifyContent::SpaceEvenly:
+            gap = std::max(0.f, freeSpace) / (count + 1);
+            cursor = gap;
+            break;
+    }
+
+    for (const FlexItem& item : items) {
+        cursor += item.mainBefore;
+
+        float outerCross = item.crossBefore + item.cross + item.crossAfter;
+        float crossOffset = item.crossBefore;
+        if (style.alignItems == AlignItems::Center) {
+            crossOffset += (crossSize - outerCross) / 2;
+        } else if (style.alignItems == AlignItems::FlexEnd) {
+            crossOffset += crossSize - outerCross;
+        }
+
+        float x = left + (row ? cursor : crossOffset);
+        float y = top + (row ? crossOffset : cursor);
+        if (item.node != Tree::kNone) {
+            LayoutBox& childBox = nodes[tree.Index(item.node)].box;
+            childBox.x = x;
+            childBox.y = y;
+        } else {
+            nodes[tree.Index(node)].box.text = {
+                x, y, row ? item.main : item.cross,
+                row ? item.cross : item.main};
+        }
+
+        cursor += item.main + item.mainAfter + gap;
+    }
+
+    return row ? crossSize : used;
+}
+
+template <typename Tree>
+float LayoutEngine::IntrinsicWidth(Tree& tree, typename Tree::Node node) {
+    NodeLayout& layout = nodes[tree.Index(node)];
+    bool clean = !(tree.Dirty(node) & (kDirtyLayout | kDirtyDescendants));
+    if (layout.intrinsicPass == pass || (layout.intrinsicPass != 0 && clean)) {
+        return layout.intrinsicWidth;
+    }
+
+    const ComputedStyle& style = tree.Style(node);
+    float width = 0;
+    if (style.display == Display::None) {
+        width = 0;
+    } else if (style.width.unit == LengthUnit::Px) {
+        width = style.width.Resolve(0, 0) + Horizontal(style.padding, 0);
+    } else {
+        bool row = style.display == Display::Flex &&
+                   style.flexDirection == FlexDirection::Row;
+        float content = 0;
+        std::string_view text = tree.Text(node);
+        if (!text.empty()) {
+            content = measureText(text, style.fontSize.Resolve(0, 16),
+                                  kUnboundedWidth)
+                          .width;
+        }
+        for (size_t i = 0; i < tree.ChildCount(node); i++) {
+            typename Tree::Node child = tree.Child(node, i);
+            float outer = IntrinsicWidth(tree, child) +
+                          Horizontal(tree.Style(child).margin, 0);
+            content = row ? content + outer : std::max(content, outer);
+        }
+        width = content + Horizontal(style.padding, 0);
+    }
+
+    layout.intrinsicWidth = width;
+    layout.intrinsicPass = pass;
+    return width;
+}
+
+Rect LayoutEngine::GetAbsoluteBox(const Element& element) const {
+    const LayoutBox& box = nodes[element.index].box;
+    Rect rect = {box.x, box.y, box.width, box.height};
+    for (auto ancestor = element.parent.lock(); ancestor;
+         ancestor = ancestor->parent.lock()) {
+        const LayoutBox& above = nodes[ancestor->index].box;
+        rect.x += above.x - above.scrollX;
+        rect.y += above.y - above.scrollY;
+    }
+    return rect;
+}
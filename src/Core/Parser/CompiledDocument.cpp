@@ -0,0 +1,364 @@
+#include "Core/Parser/CompiledDocument.h"
+#include "Core/Hash.h"
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr size_t kSectionAlignment = 8;
+
+size_t Align(size_t offset) {
+    return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+// Deduplicated string bytes. Keys point into the tree being written, which
+// outlives the writer.
+class StringTable {
+   public:
+    CompiledString Add(std::string_view text) {
+        if (text.empty()) return {0, 0};
+        auto found = offsets.find(text);
+        if (found != offsets.end()) {
+            return {found->second, uint32_t(text.size())};
+        }
+        uint32_t offset = uint32_t(bytes.size());
+        bytes.append(text);
+        offsets.emplace(text, offset);
+        return {offset, uint32_t(text.size())};
+    }
+
+    const std::string& Bytes() const { return bytes; }
+
+   private:
+    std::string bytes;
+    std::unordered_map<std::string_view, uint32_t> offsets;
+};
+
+// FNV-1a over the fields, padding bytes are never read
+struct StyleHash {
+    size_t operator()(const ComputedStyle& style) const {
+        uint64_t hash = kHashSeed;
+        auto mix = [&hash](uint32_t value) { hash = HashWord(hash, value); };
+        auto mixLength = [&mix](const Length& length) {
+            mix(uint32_t(length.value));
+            mix(uint32_t(length.unit));
+        };
+        auto mixColor = [&mix](const Color& color) {
+            mix(uint32_t(color.r) | uint32_t(color.g) << 8 |
+                uint32_t(color.b) << 16 | uint32_t(color.a) << 24);
+        };
+        mix(uint32_t(style.display) | uint32_t(style.flexDirection) << 8 |
+            uint32_t(style.justifyContent) << 16 |
+            uint32_t(style.alignItems) << 24);
+        mix(uint32_t(style.overflow) | uint32_t(style.virtualize) << 8);
+        mixLength(style.width);
+        mixLength(style.height);
+        for (int side = 0; side < 4; side++) {
+            mixLength(style.margin[side]);
+            mixLength(style.padding[side]);
+        }
+        mixLength(style.borderRadius);
+        mixLength(style.fontSize);
+        mixColor(style.backgroundColor);
+        mixColor(style.color);
+        return size_t(hash);
+    }
+};
+
+bool WriteSection(FILE* file, size_t& written, size_t offset, const void* data,
+                  size_t size) {
+    static const char zeros[kSectionAlignment] = {};
+    if (std::fwrite(zeros, 1, offset - written, file) != offset - written) {
+        return false;
+    }
+    written = offset + size;
+    return size == 0 || std::fwrite(data, 1, size, file) == size;
+}
+
+// count elements of type T at offset lie inside the file, aligned for T
+template <typename T>
+bool FitsSection(uint64_t offset, uint64_t count, uint64_t fileSize) {
+    return offset % alignof(T) == 0 && offset <= fileSize &&
+           count <= (fileSize - offset) / sizeof(T);
+}
+
+bool FitsString(CompiledString string, uint64_t stringsSize) {
+    return uint64_t(string.offset) + string.length <= stringsSize;
+}
+
+// every node but the root is one child
+uint64_t ChildSlots(const CompiledHeader& header) {
+    return header.nodeCount ? header.nodeCount - 1 : 0;
+}
+
+}  // namespace
+
+bool WriteCompiledDocument(const Element& root, const StyleTable& styles,
+                           const std::string& path) {
+    // document order, with an explicit stack as trees may be deep
+    std::vector<const Element*> order;
+    std::vector<CompiledNode> nodes;
+    std::vector<std::pair<const Element*, uint32_t>> stack = {
+        {&root, kInvalidNode}};
+    while (!stack.empty()) {
+        auto [element, parent] = stack.back();
+        stack.pop_back();
+        CompiledNode node = {};
+        node.parent = parent;
+        node.childCount = uint32_t(element->children.size());
+        order.push_back(element);
+        nodes.push_back(node);
+        uint32_t id = uint32_t(order.size() - 1);
+        for (size_t i = element->children.size(); i-- > 0;) {
+            stack.push_back({element->children[i].get(), id});
+        }
+    }
+    if (order.size() >= kInvalidNode) return false;
+
+    StringTable strings;
+    std::vector<CompiledAttribute> attributes;
+    std::vector<CompiledString> names;
+    std::unordered_map<Atom, uint32_t> nameIndices;
+    auto nameIndex = [&](Atom atom) {
+        auto [it, inserted] = nameIndices.emplace(atom, uint32_t(names.size()));
+        if (inserted) names.push_back(strings.Add(AtomName(atom)));
+        return it->second;
+    };
+
+    // each node's children get a run of the child list, filled in order as
+    // children come after their parent
+    std::vector<uint32_t> children(order.size() - 1);
+    std::vector<uint32_t> filled(order.size());
+    uint32_t runs = 0;
+    for (CompiledNode& node : nodes) {
+        node.firstChild = runs;
+        runs += node.childCount;
+    }
+
+    std::vector<ComputedStyle> distinctStyles;
+    std::unordered_map<ComputedStyle, uint32_t, StyleHash> styleIndices;
+    for (uint32_t id = 0; id < order.size(); id++) {
+        const Element& element = *order[id];
+        CompiledNode& node = nodes[id];
+        node.name = nameIndex(element.tag);
+        node.firstAttribute = uint32_t(attributes.size());
+        node.attributeCount = uint32_t(element.attributes.size());
+        for (const ElementAttribute& attribute : element.attributes) {
+            attributes.push_back(
+                {nameIndex(attribute.name), strings.Add(attribute.value)});
+        }
+        node.text = strings.Add(element.innerText);
+        const ComputedStyle& style = styles.Get(element.index);
+        auto [found, inserted] =
+            styleIndices.emplace(style, uint32_t(distinctStyles.size()));
+        if (inserted) distinctStyles.push_back(style);
+        node.style = found->second;
+
+        if (node.parent != kInvalidNode) {
+            const CompiledNode& parent = nodes[node.parent];
+            children[parent.firstChild + filled[node.parent]++] = id;
+        }
+    }
+    if (strings.Bytes().size() > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    CompiledHeader header = {};
+    std::memcpy(header.magic, kCompiledMagic, sizeof(header.magic));
+    header.version = kCompiledVersion;
+    header.styleSize = sizeof(ComputedStyle);
+    header.nodeCount = uint32_t(nodes.size());
+    header.attributeCount = uint32_t(attributes.size());
+    header.styleCount = uint32_t(distinctStyles.size());
+    header.nameCount = uint32_t(names.size());
+    header.nodesOffset = Align(sizeof(CompiledHeader));
+    header.childrenOffset =
+        Align(header.nodesOffset + nodes.size() * sizeof(CompiledNode));
+    header.attributesOffset =
+        Align(header.childrenOffset + children.size() * sizeof(uint32_t));
+    header.stylesOffset = Align(header.attributesOffset +
+                                attributes.size() * sizeof(CompiledAttribute));
+    header.namesOffset =
+        Align(header.stylesOffset +
+              distinctStyles.size() * sizeof(ComputedStyle));
+    header.stringsOffset =
+        Align(header.namesOffset + names.size() * sizeof(CompiledString));
+    header.stringsSize = strings.Bytes().size();
+    header.fileSize = header.stringsOffset + header.stringsSize;
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    size_t written = 0;
+    bool ok =
+        WriteSection(file, written, 0, &header, sizeof(header)) &&
+        WriteSection(file, written, header.nodesOffset, nodes.data(),
+                     nodes.size() * sizeof(CompiledNode)) &&
+        WriteSection(file, written, header.childrenOffset, children.data(),
+                     children.size() * sizeof(uint32_t)) &&
+        WriteSection(file, written, header.attributesOffset, attributes.data(),
+                     attributes.size() * sizeof(CompiledAttribute)) &&
+        WriteSection(file, written, header.stylesOffset, distinctStyles.data(),
+                     distinctStyles.size() * sizeof(ComputedStyle)) &&
+        WriteSection(file, written, header.namesOffset, names.data(),
+                     names.size() * sizeof(CompiledString)) &&
+        WriteSection(file, written, header.stringsOffset,
+                     strings.Bytes().data(), strings.Bytes().size());
+    return std::fclose(file) == 0 && ok;
+}
+
+bool CompiledDocument::IsCompiled(std::string_view bytes) {
+    return bytes.size() >= sizeof(kCompiledMagic) &&
+           std::memcmp(bytes.data(), kCompiledMagic, sizeof(kCompiledMagic)) ==
+               0;
+}
+
+CompiledDocument CompiledDocument::Open(SourceBuffer source) {
+    CompiledDocument document;
+    std::string_view bytes = source.View();
+    if (!IsCompiled(bytes) || !FitsSection<CompiledHeader>(0, 1, bytes.size()) ||
+        reinterpret_cast<uintptr_t>(bytes.data()) % kSectionAlignment != 0) {
+        return document;
+    }
+
+    const char* base = bytes.data();
+    auto* header = reinterpret_cast<const CompiledHeader*>(base);
+    uint64_t size = header->fileSize;
+    if (header->version != kCompiledVersion ||
+        header->styleSize != sizeof(ComputedStyle) || size != bytes.size() ||
+        header->nodeCount >= kInvalidNode ||
+        !FitsSection<CompiledNode>(header->nodesOffset, header->nodeCount,
+                                   size) ||
+        !FitsSection<uint32_t>(header->childrenOffset, ChildSlots(*header),
+                               size) ||
+        !FitsSection<CompiledAttribute>(header->attributesOffset,
+                                        header->attributeCount, size) ||
+        !FitsSection<ComputedStyle>(header->stylesOffset, header->styleCount,
+                                    size) ||
+        !FitsSection<CompiledString>(header->namesOffset, header->nameCount,
+                                     size) ||
+        !FitsSection<char>(header->stringsOffset, header->stringsSize, size)) {
+        return document;
+    }
+
+    auto* nodes =
+        reinterpret_cast<const CompiledNode*>(base + header->nodesOffset);
+    auto* children =
+        reinterpret_cast<const uint32_t*>(base + header->childrenOffset);
+    auto* attributes = reinterpret_cast<const CompiledAttribute*>(
+        base + header->attributesOffset);
+    auto* names =
+        reinterpret_cast<const CompiledString*>(base + header->namesOffset);
+
+    // every later access is then unchecked. Children only come after their
+    // node and in increasing order, so walks always end and meet each node
+    // at most once.
+    for (uint32_t i = 0; i < header->nameCount; i++) {
+        if (!FitsString(names[i], header->stringsSize)) return document;
+    }
+    for (uint32_t i = 0; i < header->attributeCount; i++) {
+        if (attributes[i].name >= header->nameCount ||
+            !FitsString(attributes[i].value, header->stringsSize)) {
+            return document;
+        }
+    }
+    uint32_t count = header->nodeCount;
+    for (uint32_t id = 0; id < count; id++) {
+        const CompiledNode& node = nodes[id];
+        bool parentValid = id == 0 ? node.parent == kInvalidNode
+                                   : node.parent < id;
+        if (node.name >= header->nameCount ||
+            node.style >= header->styleCount || !parentValid ||
+            uint64_t(node.firstChild) + node.childCount >
+                ChildSlots(*header) ||
+            uint64_t(node.firstAttribute) + node.attributeCount >
+                header->attributeCount ||
+            !FitsString(node.text, header->stringsSize)) {
+            return document;
+        }
+        uint32_t previous = id;
+        for (uint32_t i = 0; i < node.childCount; i++) {
+            uint32_t child = children[node.firstChild + i];
+            if (child <= previous || child >= count ||
+                nodes[child].parent != id) {
+                return document;
+            }
+            previous = child;
+        }
+    }
+
+    document.strings = base + header->stringsOffset;
+    document.atoms.reserve(header->nameCount);
+    for (uint32_t i = 0; i < header->nameCount; i++) {
+        document.atoms.push_back(InternAtom(document.View(names[i])));
+    }
+    document.header = header;
+    document.nodes = nodes;
+    document.children = children;
+    document.attributes = attributes;
+    document.styles =
+        reinterpret_cast<const ComputedStyle*>(base + header->stylesOffset);
+    document.source = std::move(source);
+    return document;
+}
+
+std::string_view CompiledDocument::GetAttribute(NodeId id, Atom name) const {
+    const CompiledNode& node = nodes[id];
+    for (uint32_t i = 0; i < node.attributeCount; i++) {
+        const CompiledAttribute& attribute =
+            attributes[node.firstAttribute + i];
+        if (atoms[attribute.name] == name) return View(attribute.value);
+    }
+    return std::string_view();
+}
+
+void CompiledDocument::LoadStyles(StyleTable& table) const {
+    // stored styles are distinct, the nodes using one share it
+    std::vector<std::shared_ptr<const ComputedStyle>> distinct(
+        header ? header->styleCount : 0);
+    std::vector<std::shared_ptr<const ComputedStyle>> resolved;
+    resolved.reserve(NodeCount());
+    for (NodeId id = 0; id < NodeCount(); id++) {
+        std::shared_ptr<const ComputedStyle>& style =
+            distinct[nodes[id].style];
+        if (!style) {
+            style = std::make_shared<const ComputedStyle>(
+                styles[nodes[id].style]);
+        }
+        resolved.push_back(style);
+    }
+    table.Assign(std::move(resolved));
+}
+
+std::shared_ptr<Element> CompiledDocument::BuildElementTree(
+    bool cleanStyles) const {
+    size_t count = NodeCount();
+    if (count == 0) return nullptr;
+
+    // parents come first, so each element's parent already exists
+    std::vector<std::shared_ptr<Element>> elements(count);
+    for (NodeId id = 0; id < count; id++) {
+        const CompiledNode& node = nodes[id];
+        auto element = std::make_shared<Element>(atoms[node.name]);
+        element->index = id;
+        if (cleanStyles) {
+            element->dirty = kDirtyLayout | kDirtyDescendants | kDirtyCopy;
+        }
+        element->attributes.reserve(node.attributeCount);
+        for (uint32_t i = 0; i < node.attributeCount; i++) {
+            const CompiledAttribute& attribute =
+                attributes[node.firstAttribute + i];
+            element->attributes.push_back(
+                {atoms[attribute.name], std::string(View(attribute.value))});
+        }
+        element->innerText = View(node.text);
+        if (node.parent != kInvalidNode) {
+            element->parent = elements[node.parent];
+            elements[node.parent]->children.push_back(element);
+        }
+        elements[id] = std::move(element);
+    }
+    return elements[0];
+}
@@ -1,85 +1,117 @@
+#include "Core/Atom.h"
+#include "Core/Document.h"
 #include "Core/Element.h"
+#include "Core/Parser/MarkupGrammar.h"
 #include "Core/Parser/Parser.h"
 #include "Core/Parser/Tokenizer.h"
+#include "Core/Parser/Whitespace.h"
+#include <algorithm>
 #include <memory>
-#include <stdexcept>
+#include <string>
+#include <utility>
 
-std::shared_ptr<Element> Parser::Parse() { return ParseElement(); }
+namespace {
 
-std::shared_ptr<Element> Parser::ParseElement() {
-    Expect(TokenType::OpenTagStart, "Expected Opening tag");
-    std::string tag_name = m_CurrentToken.value;
-    Advance();  // consume tag name
+class DocumentBuilder {
+   public:
+    using Node = NodeId;
 
-    std::shared_ptr<Element> element = std::make_shared<Element>(tag_name);
-    ParseAttributes(element);
+    explicit DocumentBuilder(Document& document) : document(document) {}
 
-    if (Match(TokenType::SelfTagEnd)) {
+    Node Create(Atom tag) { return document.CreateNode(tag); }
+    void SetAttribute(Node& node, Atom key, std::string_view value) {
+        document.SetAttribute(node, key, value);
     }
-
-    if (Match(TokenType::TagEnd)) {
-        ParseChildren(element);
-
-        Expect(TokenType::CloseTagStart, "Expected closing tag");
-        std::string close_name = m_CurrentToken.value;
-        Advance();
-        if (close_name != tag_name)
-            throw std::runtime_error("Tag mismatch: " + tag_name + " vs " +
-                                     close_name);
-        Expect(TokenType::TagEnd, "Expected '>' after closing tag");
+    void AppendText(Node& node, std::string_view text) {
+        scratch.clear();
+        CollapseWhitespace(text, scratch);
+        document.AppendText(node, scratch);
+    }
+    void AppendRawText(Node& node, std::string_view text) {
+        document.AppendText(node, text);
+    }
+    void AppendChild(Node& parent, Node child) {
+        document.AppendChild(parent, child);
     }
 
-    return element;
-}
+   private:
+    Document& document;
+    std::string scratch;  // reused so text normalization does not allocate
+};
 
-void Parser::ParseAttributes(std::shared_ptr<Element>& element) {
-    while (m_CurrentToken.type == TokenType::Identifier) {
-        std::string key = m_CurrentToken.value;
+}  // namespace
 
-        // consume the key
-        Advance();
+std::shared_ptr<Element> Parser::Parse() {
+    ElementBuilder builder;
+    return ParseRoot(builder);
+}
 
-        Expect(TokenType::Equals, "Expected \"=\" after attribute name");
+std::unique_ptr<Document> Parser::ParseDocument() {
+    auto document =
+        std::make_unique<Document>(m_Tokenizer.Source().size());
+    DocumentBuilder builder(*document);
+    ParseRoot(builder);
+    return document;
+}
 
-        if (m_CurrentToken.type == TokenType::QuotedString) {
-            std::string value = m_CurrentToken.value;
-            element->attributes[key] = value;
-            Advance();
-        } else {
-            throw std::runtime_error("Expected quoted attribute value");
+template <typename Builder>
+typename Builder::Node Parser::ParseRoot(Builder& builder) {
+    if (!m_Tokenizer.IsOpen()) Report(0, "Could not open the source");
+    MarkupGrammar<Builder> grammar(
+        builder, [this](size_t offset, std::string message) {
+            Report(offset, std::move(message));
+        });
+    SkipMarkupDeclarations();
+    // a local token stays in registers across the grammar's calls
+    Token token = m_CurrentToken;
+    while (token.type != TokenType::EndOfFile) {
+        // one token after the root is reported, the rest is not read
+        bool complete = grammar.IsComplete();
+        grammar.Feed(token);
+        if (complete) break;
+        token = m_Tokenizer.Next();
+        // comments and declarations are skipped here, not by the grammar
+        if (token.type == TokenType::Comment ||
+            token.type == TokenType::Declaration) {
+            m_CurrentToken = token;
+            SkipMarkupDeclarations();
+            token = m_CurrentToken;
         }
     }
+    m_CurrentToken = token;
+    return grammar.Finish(token.offset);
 }
 
-void Parser::ParseChildren(std::shared_ptr<Element>& parent) {
-    while (true) {
-        if (m_CurrentToken.type == TokenType::CloseTagStart) {
-            break;
-        }
-
-        if (m_CurrentToken.type == TokenType::OpenTagStart) {
-            parent->AddChild(ParseElement());
-        }
-
-        else if (m_CurrentToken.type == TokenType::TextContent) {
-            parent->innerText += m_CurrentToken.value;
-            Advance();
-        } else {
-            break;
+void Parser::SkipMarkupDeclarations() {
+    while (m_CurrentToken.type == TokenType::Comment ||
+           m_CurrentToken.type == TokenType::Declaration) {
+        std::string_view value = m_CurrentToken.value;
+        if (m_CurrentToken.type == TokenType::Comment) {
+            if (value.size() < 7 || value.substr(value.size() - 3) != "-->") {
+                Report(m_CurrentToken.offset, "Unterminated comment");
+            }
+        } else if (value.back() != '>') {
+            Report(m_CurrentToken.offset, "Unterminated declaration");
         }
+        m_CurrentToken = m_Tokenizer.Next();
     }
 }
 
-void Parser::Advance() { m_CurrentToken = m_Tokenizer.Next(); }
+void Parser::Report(size_t offset, std::string message) {
+    if (m_Diagnostics.size() >= kMaxDiagnostics) return;
 
-bool Parser::Match(TokenType type) {
-    if (m_CurrentToken.type == type) {
-        Advance();
-        return true;
+    std::string_view source = m_Tokenizer.Source();
+    offset = std::min(offset, source.size());
+    if (offset < m_LineCursor) {
+        m_LineCursor = m_LineStart = 0;
+        m_Line = 1;
     }
-    return false;
+    for (; m_LineCursor < offset; m_LineCursor++) {
+        if (source[m_LineCursor] == '\n') {
+            m_Line++;
+            m_LineStart = m_LineCursor + 1;
+        }
+    }
+    m_Diagnostics.push_back(
+        {m_Line, uint32_t(offset - m_LineStart + 1), std::move(message)});
 }
-
-void Parser::Expect(TokenType type, const std::string& errorMessage) {
-    if (!Match(type)) throw std::runtime_error(errorMessage);
-}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "Core/Parser/SourceBuffer.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+SourceBuffer::~SourceBuffer() { Release(); }
+
+SourceBuffer::SourceBuffer(SourceBuffer&& other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      size(std::exchange(other.size, 0)),
+      mappedSize(std::exchange(other.mappedSize, 0)),
+      isOpen(std::exchange(other.isOpen, false)) {}
+
+SourceBuffer& SourceBuffer::operator=(SourceBuffer&& other) noexcept {
+    if (this != &other) {
+        Release();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+        mappedSize = std::exchange(other.mappedSize, 0);
+        isOpen = std::exchange(other.isOpen, false);
+    }
+    return *this;
+}
+
+SourceBuffer SourceBuffer::Map(const std::string& filename) {
+    SourceBuffer buffer;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return buffer;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return buffer;
+    }
+
+    buffer.isOpen = true;
+    if (info.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            buffer.isOpen = false;
+        } else {
+            // the tokenizer walks the file front to back exactly once
+            madvise(mapped, static_cast<size_t>(info.st_size),
+                    MADV_SEQUENTIAL);
+            buffer.data = static_cast<const char*>(mapped);
+            buffer.size = static_cast<size_t>(info.st_size);
+            buffer.mappedSize = buffer.size;
+        }
+    }
+
+    close(fd);
+    return buffer;
+}
+
+SourceBuffer SourceBuffer::Borrow(std::string_view source) {
+    SourceBuffer buffer;
+    buffer.data = source.data();
+    buffer.size = source.size();
+    buffer.isOpen = true;
+    return buffer;
+}
+
+void SourceBuffer::Release() {
+    if (mappedSize > 0) {
+        munmap(const_cast<char*>(data), mappedSize);
+    }
+    data = nullptr;
+    size = 0;
+    mappedSize = 0;
+    isOpen = false;
+}
@@ -0,0 +1,364 @@
+#include "Core/Parser/StreamingParser.h"
+#include "Core/Parser/Whitespace.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// Ends an identifier, as does a '/' right before '>'.
+bool EndsIdentifier(char c) {
+    return IsSpace(c) || c == '=' || c == '>' || c == '<' || c == '"' ||
+           c == '\'';
+}
+
+}  // namespace
+
+StreamingParser::StreamingParser()
+    : grammar(builder, [this](size_t offset, std::string message) {
+          Report(offset, std::move(message));
+      }) {}
+
+void StreamingParser::Feed(std::string_view data) {
+    if (finished) return;
+    chunk = data;
+    chunkStart = bytesFed;
+    bytesFed += data.size();
+    tokenBegin = 0;
+    size_t position = 0;
+    while (position < chunk.size() && !done) position = Scan(position);
+
+    // a token cut by the end keeps its part of this chunk
+    bool value = state == State::Text || state == State::Identifier ||
+                 state == State::IdentifierSlash ||
+                 state == State::QuotedString || state == State::RawText;
+    if (value && !done) partial.append(chunk.substr(tokenBegin));
+    Locate(bytesFed);
+    chunk = {};
+}
+
+void StreamingParser::Finish() {
+    if (finished) return;
+    finished = true;
+    chunkStart = bytesFed;
+    tokenBegin = 0;
+    if (!done) EndToken();
+    tokenMark = Locate(bytesFed);
+    grammar.Finish(bytesFed);
+}
+
+size_t StreamingParser::Scan(size_t position) {
+    char c = chunk[position];
+    switch (state) {
+        case State::Markup:
+            return ScanMarkup(position);
+
+        case State::Text: {
+            bool blank = true;
+            position += ScanTextContent(chunk.substr(position), blank);
+            textBlank = textBlank && blank;
+            if (position == chunk.size()) return position;
+            // whitespace-only runs between tags are not content
+            state = State::Markup;
+            if (!textBlank) {
+                Emit(TokenType::TextContent, Value(position), tokenMark);
+            }
+            return position;
+        }
+
+        case State::LessThan:
+            if (c == '!' || c == '?') {
+                state = c == '!' ? State::DeclarationOpen : State::Declaration;
+                dashes = 0;
+                rawTextStart.Feed(TokenType::Declaration, {});
+                return position + 1;
+            }
+            state = State::Markup;
+            if (c == '/') {
+                Emit(TokenType::CloseTagStart, "</", tokenMark);
+                return position + 1;
+            }
+            Emit(TokenType::OpenTagStart, "<", tokenMark);
+            return position;
+
+        case State::Slash:
+            // a '/' not followed by '>' is skipped, as Tokenizer does
+            if (c != '>') {
+                state = State::Markup;
+                return position;
+            }
+            Emit(TokenType::SelfTagEnd, "/>", tokenMark);
+            BeginText(position + 1);
+            return position + 1;
+
+        case State::Identifier:
+            return ScanIdentifier(position);
+
+        case State::IdentifierSlash:
+            if (c != '>') {
+                state = State::Identifier;
+                return position;
+            }
+            partial.pop_back();  // the '/' is part of "/>"
+            state = State::Markup;
+            Emit(TokenType::Identifier, Value(position), tokenMark);
+            Emit(TokenType::SelfTagEnd, "/>", slashMark);
+            BeginText(position + 1);
+            return position + 1;
+
+        case State::QuotedString: {
+            const void* found = std::memchr(chunk.data() + position, quote,
+                                            chunk.size() - position);
+            if (!found) return chunk.size();
+            size_t end = static_cast<const char*>(found) - chunk.data();
+            state = State::Markup;
+            Emit(TokenType::QuotedString, Value(end), tokenMark);
+            return end + 1;
+        }
+
+        case State::DeclarationOpen:
+            // "<!--" starts a comment, anything else a declaration
+            if (c == '-' && ++dashes < 2) return position + 1;
+            if (c == '-') {
+                state = State::Comment;
+                dashes = 0;
+                return position + 1;
+            }
+            state = State::Declaration;
+            return position;
+
+        case State::Declaration: {
+            const void* found = std::memchr(chunk.data() + position, '>',
+                                            chunk.size() - position);
+            if (!found) return chunk.size();
+            size_t end = static_cast<const char*>(found) - chunk.data();
+            BeginText(end + 1);
+            return end + 1;
+        }
+
+        case State::Comment:
+            return ScanComment(position);
+
+        case State::RawText:
+            return ScanRawText(position);
+    }
+    return position + 1;
+}
+
+size_t StreamingParser::ScanMarkup(size_t position) {
+    char c = chunk[position];
+    switch (c) {
+        case '<':
+            Begin(position);
+            state = State::LessThan;
+            return position + 1;
+
+        case '>':
+            Begin(position);
+            Emit(TokenType::TagEnd, ">", tokenMark);
+            BeginText(position + 1);
+            return position + 1;
+
+        case '/':
+            Begin(position);
+            state = State::Slash;
+            return position + 1;
+
+        case '=':
+            Begin(position);
+            Emit(TokenType::Equals, "=", tokenMark);
+            return position + 1;
+
+        case '"':
+        case '\'':
+            quote = c;
+            Begin(position + 1);
+            state = State::QuotedString;
+            return position + 1;
+
+        case ' ':
+        case '\n':
+        case '\t':
+        case '\r':
+            return position + 1;
+
+        default:
+            Begin(position);
+            state = State::Identifier;
+            return position;
+    }
+}
+
+size_t StreamingParser::ScanIdentifier(size_t position) {
+    size_t end = position;
+    for (; end < chunk.size(); end++) {
+        char c = chunk[end];
+        if (EndsIdentifier(c)) break;
+        if (c != '/') continue;
+        if (end + 1 == chunk.size()) {
+            // the next chunk decides between "/>" and a '/' in the name
+            slashMark = Locate(chunkStart + end);
+            state = State::IdentifierSlash;
+            return chunk.size();
+        }
+        if (chunk[end + 1] == '>') break;
+    }
+    if (end == chunk.size()) return end;
+    state = State::Markup;
+    Emit(TokenType::Identifier, Value(end), tokenMark);
+    return end;
+}
+
+size_t StreamingParser::ScanComment(size_t position) {
+    // ends at "-->" whose dashes come after the opening "<!--"
+    for (; position < chunk.size(); position++) {
+        char c = chunk[position];
+        if (c == '>' && dashes >= 2) {
+            BeginText(position + 1);
+            return position + 1;
+        }
+        dashes = c == '-' ? uint8_t(std::min(dashes + 1, 2)) : 0;
+    }
+    return position;
+}
+
+size_t StreamingParser::ScanRawText(size_t position) {
+    // the end may be cut by a chunk boundary, so it is matched a byte at a
+    // time; only '<' restarts it
+    for (; position < chunk.size(); position++) {
+        char c = chunk[position];
+        if (endMatched == 0) {
+            const void* found = std::memchr(chunk.data() + position, '<',
+                                            chunk.size() - position);
+            if (!found) return chunk.size();
+            position = static_cast<const char*>(found) - chunk.data();
+            c = '<';
+        }
+        if (c == kRawTextEnd[endMatched]) {
+            if (endMatched == 0) endMark = Locate(chunkStart + position);
+            if (++endMatched == kRawTextEnd.size()) {
+                return EndRawText(position + 1);
+            }
+        } else if (c == '<') {
+            endMark = Locate(chunkStart + position);
+            endMatched = 1;
+        } else {
+            endMatched = 0;
+        }
+    }
+    return position;
+}
+
+size_t StreamingParser::EndRawText(size_t end) {
+    std::string_view text = Value(end);
+    text.remove_suffix(kRawTextEnd.size());
+    if (!text.empty()) Emit(TokenType::RawText, text, tokenMark);
+    Mark close = endMark;
+    Emit(TokenType::CloseTagStart, "</", close);
+
+    // the end tag name is scanned on as an identifier, as Tokenizer does
+    Begin(end);
+    partial.assign(kRawTextEnd.substr(2));
+    tokenMark = {close.offset + 2, close.line, close.column + 2};
+    state = State::Identifier;
+    return end;
+}
+
+void StreamingParser::Begin(size_t position) {
+    tokenMark = Locate(chunkStart + position);
+    tokenBegin = position;
+    partial.clear();
+}
+
+void StreamingParser::BeginText(size_t position) {
+    Begin(position);
+    state = rawTextNext ? State::RawText : State::Text;
+    rawTextNext = false;
+    textBlank = true;
+    endMatched = 0;
+}
+
+std::string_view StreamingParser::Value(size_t end) {
+    std::string_view piece = chunk.substr(tokenBegin, end - tokenBegin);
+    if (partial.empty()) return piece;
+    partial.append(piece);
+    return partial;
+}
+
+void StreamingParser::Emit(TokenType type, std::string_view value,
+                           Mark mark) {
+    tokenMark = mark;
+    rawTextNext = rawTextStart.Feed(type, value);
+    // one token after the root is reported, the rest is not read
+    bool complete = grammar.IsComplete();
+    grammar.Feed(Token(type, value, mark.offset));
+    if (complete) done = true;
+    // kept after the feed, which may still report about the previous tag
+    if (type == TokenType::OpenTagStart) tagMark = mark;
+    if (type == TokenType::CloseTagStart) closeMark = mark;
+}
+
+void StreamingParser::EndToken() {
+    switch (state) {
+        case State::Markup:
+        case State::Slash:
+            break;
+        case State::Text:
+            if (!textBlank) {
+                Emit(TokenType::TextContent, Value(0), tokenMark);
+            }
+            break;
+        case State::LessThan:
+            Emit(TokenType::OpenTagStart, "<", tokenMark);
+            break;
+        case State::Identifier:
+        case State::IdentifierSlash:
+            Emit(TokenType::Identifier, Value(0), tokenMark);
+            break;
+        case State::QuotedString:
+            Emit(TokenType::QuotedString, Value(0), tokenMark);
+            break;
+        case State::DeclarationOpen:
+        case State::Declaration:
+            Report(tokenMark.offset, "Unterminated declaration");
+            break;
+        case State::Comment:
+            Report(tokenMark.offset, "Unterminated comment");
+            break;
+        case State::RawText: {
+            std::string_view text = Value(0);
+            if (!text.empty()) Emit(TokenType::RawText, text, tokenMark);
+            break;
+        }
+    }
+    state = State::Markup;
+}
+
+StreamingParser::Mark StreamingParser::Locate(uint64_t offset) {
+    // the newlines since the last count, which are all in this chunk
+    if (offset > lineCursor) {
+        const char* data = chunk.data();
+        const char* end = data + (offset - chunkStart);
+        for (const char* p = data + (lineCursor - chunkStart);
+             (p = static_cast<const char*>(std::memchr(p, '\n', end - p)));
+             p++) {
+            line++;
+            lineStart = chunkStart + (p - data) + 1;
+        }
+        lineCursor = offset;
+    }
+    return {size_t(offset), line, uint32_t(offset - lineStart + 1)};
+}
+
+void StreamingParser::Report(size_t offset, std::string message) {
+    if (diagnostics.size() >= Parser::kMaxDiagnostics) return;
+    Mark mark = tokenMark;
+    if (offset == tagMark.offset) mark = tagMark;
+    if (offset == closeMark.offset) mark = closeMark;
+    if (offset == tokenMark.offset) mark = tokenMark;
+    diagnostics.push_back({mark.line, mark.column, std::move(message)});
+}
@@ -1,134 +1,201 @@
 #include "Core/Parser/Tokenizer.h"
-#include <fstream>
+#include "Core/Parser/Whitespace.h"
 #include <iostream>
-#include <iterator>
-#include <regex>
-#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
-Tokenizer::Tokenizer(const std::string& filename) {
-    std::ifstream file(filename);
+namespace {
 
-    if (!file) {
-        std::cerr << "Failed to open source file. Exiting" << std::endl;
-        exit(1);
-    }
+bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+}  // namespace
+
+Tokenizer::Tokenizer(const std::string& filename)
+    : source(SourceBuffer::Map(filename)) {}
+
+Tokenizer::Tokenizer(SourceBuffer source) : source(std::move(source)) {}
 
-    source.assign((std::istreambuf_iterator<char>(file)),
-                  std::istreambuf_iterator<char>());
+void Tokenizer::Reset() {
+    position = 0;
+    started = false;
+    inText = false;
+    inRawText = false;
+    rawTextStart = RawTextStart();
+}
+
+Token Tokenizer::CurrentToken() {
+    if (!started) {
+        started = true;
+        current = Scan();
+    }
+    return current;
 }
 
-Token Tokenizer::CurrentToken() { return tokens[token_position]; }
 Token Tokenizer::Next() {
-    token_position++;
-    return tokens[token_position];
+    if (!started) CurrentToken();
+    current = Scan();
+    return current;
 }
 
-char Tokenizer::Current() { return source.at(position); }
+char Tokenizer::Peek() const {
+    return position + 1 < source.Size() ? source.Data()[position + 1] : '\0';
+}
 
-char Tokenizer::Peek() { return source.at(position + 1); }
-char Tokenizer::PeekPrevious() { return source.at(position - 1); }
-void Tokenizer::Move(unsigned int step) { position += step; }
+Token Tokenizer::Slice(TokenType type, size_t start, size_t length) const {
+    return Token(type, std::string_view(source.Data() + start, length), start);
+}
 
-void Tokenizer::ProcessString() {
-    std::string value;
+Token Tokenizer::ProcessString(char quote) {
+    size_t start = position;
 
-    while (Current() != '"') {
-        value.push_back(Current());
+    while (!AtEnd() && Current() != quote) {
         Move(1);
     }
 
-    tokens.push_back(Token(TokenType::QuotedString, value));
+    return Slice(TokenType::QuotedString, start, position - start);
 }
 
-void Tokenizer::ProcessIdentifier() {
-    std::string value;
+Token Tokenizer::ProcessIdentifier() {
+    size_t start = position;
 
-    while (Current() != ' ' && Current() != '=' && Current() != '>' &&
-           Current() != '\n') {
-        value.push_back(Current());
+    // also ends unquoted attribute values, so `a=b/>` leaves `/>` alone
+    while (!AtEnd() && !IsSpace(Current()) && Current() != '=' &&
+           Current() != '>' && Current() != '<' && Current() != '"' &&
+           Current() != '\'' && !(Current() == '/' && Peek() == '>')) {
         Move(1);
     }
 
-    tokens.push_back(Token(TokenType::Identifier, value));
+    return Slice(TokenType::Identifier, start, position - start);
 }
 
-void Tokenizer::ProcessTextContent() {
-    std::string value;
+Token Tokenizer::ProcessMarkupDeclaration() {
+    size_t start = position;
+    std::string_view rest = source.View().substr(start);
+    bool comment = rest.substr(0, 4) == "<!--";
+    size_t end = comment ? rest.find("-->", 4) : rest.find('>', 2);
+    size_t length =
+        end == std::string_view::npos ? rest.size()
+                                      : end + (comment ? 3 : 1);
+    Move(length);
+    inText = true;  // content continues after it
+    return Slice(comment ? TokenType::Comment : TokenType::Declaration, start,
+                 length);
+}
 
-    while (Current() != '<' && position < source.length() - 1) {
-        if (Current() != '\n') {
-            value.push_back(Current());
-        }
-        Move(1);
-    }
+bool Tokenizer::ProcessTextContent(Token& token) {
+    size_t start = position;
+    bool blank = true;
+
+    Move(ScanTextContent(source.View().substr(start), blank));
 
-    // trim the leading and trailing whitspaces
-    value = std::regex_replace(value, std::regex("^ +| +$|( ) +"), "$1");
-    if (value.length() > 0) {
-        tokens.push_back(Token(TokenType::TextContent, value));
+    // whitespace-only runs between tags are not content
+    if (blank) return false;
+    token = Slice(TokenType::TextContent, start, position - start);
+    return true;
+}
+
+Token Tokenizer::ProcessRawText() {
+    size_t start = position;
+    size_t end = source.View().find(kRawTextEnd, start);
+    if (end == std::string_view::npos) end = source.Size();
+    position = end;
+    return Slice(TokenType::RawText, start, end - start);
+}
+
+Token Tokenizer::Scan() {
+    Token token = ScanToken();
+    if (rawTextStart.Feed(token.type, token.value)) {
+        inText = false;
+        inRawText = true;
     }
+    return token;
 }
 
-Token Tokenizer::Last() { return tokens[tokens.size() - 1]; }
+Token Tokenizer::ScanToken() {
+    if (inRawText) {
+        inRawText = false;
+        Token text = ProcessRawText();
+        if (!text.value.empty()) return text;
+    }
+    if (inText) {
+        inText = false;
+        Token text(TokenType::TextContent, {}, position);
+        if (ProcessTextContent(text)) return text;
+    }
 
-std::vector<Token> Tokenizer::Tokenize() {
-    while (position < source.length()) {
-        char c = source.at(position);
-        switch (c) {
+    while (!AtEnd()) {
+        size_t start = position;
+        switch (Current()) {
             case '<':
+                if (Peek() == '!' || Peek() == '?') {
+                    return ProcessMarkupDeclaration();
+                }
                 if (Peek() == '/') {
                     Move(2);
-                    tokens.push_back(Token(TokenType::CloseTagStart, "</"));
-                } else {
-                    Move(1);
-                    tokens.push_back(Token(TokenType::OpenTagStart, "<"));
+                    return Slice(TokenType::CloseTagStart, start, 2);
                 }
-                break;
+                Move(1);
+                return Slice(TokenType::OpenTagStart, start, 1);
 
             case '>':
                 Move(1);  // consume the >
-                tokens.push_back(Token(TokenType::TagEnd, ">"));
-                ProcessTextContent();
-                break;
+                inText = true;
+                return Slice(TokenType::TagEnd, start, 1);
+
             case '/':
                 if (Peek() == '>') {
                     Move(2);
-                    tokens.push_back(Token(TokenType::SelfTagEnd, "/>"));
+                    inText = true;
+                    return Slice(TokenType::SelfTagEnd, start, 2);
                 }
+                Move(1);
                 break;
+
             case '=':
                 Move(1);
-                tokens.push_back(Token(TokenType::Equals, "="));
-                break;
+                return Slice(TokenType::Equals, start, 1);
 
             case '"':
-                Move(1);  // consume start "
-                ProcessString();
-                Move(1);  // consume end "
-                break;
+            case '\'': {
+                char quote = Current();
+                Move(1);  // consume the opening quote
+                Token token = ProcessString(quote);
+                if (!AtEnd()) Move(1);  // consume the closing quote
+                return token;
+            }
 
             case ' ':
-                Move(1);
-                break;
-
             case '\n':
+            case '\t':
+            case '\r':
                 Move(1);
                 break;
 
             default:
-                ProcessIdentifier();
+                return ProcessIdentifier();
         }
     }
 
+    return Slice(TokenType::EndOfFile, source.Size(), 0);
+}
+
+std::vector<Token> Tokenizer::Tokenize() {
+    std::vector<Token> tokens;
+    for (Token token = CurrentToken(); token.type != TokenType::EndOfFile;
+         token = Next()) {
+        tokens.push_back(token);
+    }
     return tokens;
 }
 
 void Tokenizer::Show() {
-    for (auto& token : tokens) {
+    for (auto& token : Tokenize()) {
         std::cout << "Type: " << static_cast<int>(token.type)
+                  << " Offset: " << token.offset
                   << " Length: " << token.value.length()
                   << " Token: " << token.value << std::endl;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,161 @@
+#include "Core/Parser/Whitespace.h"
+#include <cstdint>
+#include <string>
+
+#if !defined(VISION_DISABLE_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VISION_WHITESPACE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VISION_WHITESPACE_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VISION_WHITESPACE_NEON
+#endif
+#endif
+
+namespace {
+
+inline bool IsSpace(char c) { return c == ' ' || c == '\n'; }
+
+inline unsigned CountTrailingZeros(uint64_t mask) {
+    return static_cast<unsigned>(__builtin_ctzll(mask));
+}
+
+// Per-block lane masks: bit i * kLaneBits is set when byte i matches.
+struct BlockMasks {
+    uint64_t tag;    // '<'
+    uint64_t space;  // ' ' or '\n'
+};
+
+#if defined(VISION_WHITESPACE_AVX2)
+constexpr size_t kBlockSize = 32;
+constexpr unsigned kLaneBits = 1;
+constexpr uint64_t kFullMask = 0xFFFFFFFFull;
+
+inline BlockMasks Classify(const char* p) {
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i tag = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('<'));
+    __m256i space =
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+    return {static_cast<uint32_t>(_mm256_movemask_epi8(tag)),
+            static_cast<uint32_t>(_mm256_movemask_epi8(space))};
+}
+#elif defined(VISION_WHITESPACE_SSE2)
+constexpr size_t kBlockSize = 16;
+constexpr unsigned kLaneBits = 1;
+constexpr uint64_t kFullMask = 0xFFFFull;
+
+inline BlockMasks Classify(const char* p) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i tag = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('<'));
+    __m128i space = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                 _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+    return {static_cast<uint32_t>(_mm_movemask_epi8(tag)),
+            static_cast<uint32_t>(_mm_movemask_epi8(space))};
+}
+#elif defined(VISION_WHITESPACE_NEON)
+constexpr size_t kBlockSize = 16;
+constexpr unsigned kLaneBits = 4;
+constexpr uint64_t kFullMask = ~0ull;
+
+// NEON has no movemask; narrowing by 4 bits leaves one nibble per lane.
+inline uint64_t NibbleMask(uint8x16_t lanes) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(lanes), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+inline BlockMasks Classify(const char* p) {
+    uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t tag = vceqq_u8(bytes, vdupq_n_u8('<'));
+    uint8x16_t space = vorrq_u8(vceqq_u8(bytes, vdupq_n_u8(' ')),
+                                vceqq_u8(bytes, vdupq_n_u8('\n')));
+    return {NibbleMask(tag), NibbleMask(space)};
+}
+#endif
+
+#if defined(VISION_WHITESPACE_AVX2) || defined(VISION_WHITESPACE_SSE2) || \
+    defined(VISION_WHITESPACE_NEON)
+#define VISION_WHITESPACE_SIMD
+
+// mask covering the first `lanes` lanes of a block
+inline uint64_t LowLanes(unsigned lanes) {
+    unsigned bits = lanes * kLaneBits;
+    return bits >= 64 ? ~0ull : (1ull << bits) - 1;
+}
+#endif
+
+// Index of the first byte at or after i that is (or is not) a space.
+inline size_t FindSpace(const char* data, size_t i, size_t size, bool space) {
+#if defined(VISION_WHITESPACE_SIMD)
+    for (; i + kBlockSize <= size; i += kBlockSize) {
+        uint64_t mask = Classify(data + i).space;
+        if (!space) mask = ~mask & kFullMask;
+        if (mask) return i + CountTrailingZeros(mask) / kLaneBits;
+    }
+#endif
+    while (i < size && IsSpace(data[i]) != space) i++;
+    return i;
+}
+
+}  // namespace
+
+size_t ScanTextContent(std::string_view text, bool& blank) {
+    const char* data = text.data();
+    size_t size = text.size();
+    size_t i = 0;
+    blank = true;
+
+#if defined(VISION_WHITESPACE_SIMD)
+    for (; i + kBlockSize <= size; i += kBlockSize) {
+        BlockMasks masks = Classify(data + i);
+        uint64_t content = ~masks.space & kFullMask;
+        if (masks.tag) {
+            unsigned lane = CountTrailingZeros(masks.tag) / kLaneBits;
+            if (content & LowLanes(lane)) blank = false;
+            return i + lane;
+        }
+        if (content) blank = false;
+    }
+#endif
+
+    for (; i < size; i++) {
+        if (data[i] == '<') return i;
+        if (!IsSpace(data[i])) blank = false;
+    }
+    return size;
+}
+
+void CollapseWhitespace(std::string_view text, std::string& out) {
+    const char* data = text.data();
+    size_t size = text.size();
+    bool emitted = false;  // a word has been written, spaces are not leading
+    bool pendingSpace = false;
+    size_t i = 0;
+
+    out.reserve(out.size() + size);
+    while (i < size) {
+        size_t wordEnd = FindSpace(data, i, size, true);
+        if (wordEnd > i) {
+            if (pendingSpace) out.push_back(' ');
+            out.append(data + i, wordEnd - i);
+            emitted = true;
+            pendingSpace = false;
+        }
+
+        size_t spaceEnd = FindSpace(data, wordEnd, size, false);
+        // newlines vanish rather than becoming separators
+        for (size_t j = wordEnd; j < spaceEnd && !pendingSpace; j++) {
+            if (data[j] == ' ' && emitted) pendingSpace = true;
+        }
+        i = spaceEnd;
+    }
+}
+
+std::string CollapseWhitespace(std::string_view text) {
+    std::string out;
+    CollapseWhitespace(text, out);
+    return out;
+}
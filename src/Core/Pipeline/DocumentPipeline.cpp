@@ -0,0 +1,293 @@
+#include "Core/Pipeline/DocumentPipeline.h"
+#include "Core/Parser/CompiledDocument.h"
+#include "Core/Parser/Parser.h"
+#include "Core/Parser/Tokenizer.h"
+#include "Core/Render/Painter.h"
+#include "Core/Style/StyleSheet.h"
+#include "Core/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void CollectBoxes(const Element& element, const LayoutEngine& layout,
+                  float parentX, float parentY, std::vector<Rect>& boxes) {
+    const LayoutBox& box = layout.GetBox(element);
+    float x = parentX + box.x, y = parentY + box.y;
+    if (element.index >= boxes.size()) boxes.resize(element.index + 1);
+    boxes[element.index] = {x, y, box.width, box.height};
+    auto [first, end] = layout.LaidOutChildren(element);
+    for (size_t i = first; i < end; i++) {
+        CollectBoxes(*element.children[i], layout, x - box.scrollX,
+                     y - box.scrollY, boxes);
+    }
+}
+
+}  // namespace
+
+DocumentPipeline::DocumentPipeline(GlyphCache* glyphs, FontId font)
+    : glyphs(font == kInvalidFont ? nullptr : glyphs), font(font) {
+    // measuring only reads font metrics, so layout needs no glyph lock
+    if (this->glyphs) {
+        text = std::make_unique<TextLayout>(*this->glyphs);
+        layout.SetTextMeasurer(text->Measurer(font));
+    }
+    worker = std::thread(&DocumentPipeline::Run, this);
+}
+
+DocumentPipeline::~DocumentPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void DocumentPipeline::Load(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex);
+    pendingPath = path;
+    pendingRoot.reset();
+    pendingMutations.clear();  // they were meant for the old document
+    pendingInput.clear();
+    Submit(lock);
+}
+
+void DocumentPipeline::SetDocument(std::shared_ptr<Element> root) {
+    std::unique_lock<std::mutex> lock(mutex);
+    pendingPath.clear();
+    pendingRoot = std::move(root);
+    pendingMutations.clear();
+    pendingInput.clear();
+    Submit(lock);
+}
+
+void DocumentPipeline::Mutate(DocumentMutation mutation) {
+    std::unique_lock<std::mutex> lock(mutex);
+    pendingMutations.push_back(std::move(mutation));
+    Submit(lock);
+}
+
+void DocumentPipeline::Input(std::vector<InputEvent> events) {
+    if (events.empty()) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    pendingInput.insert(pendingInput.end(), events.begin(), events.end());
+    Submit(lock);
+}
+
+void DocumentPipeline::SetViewport(float width, float height) {
+    std::unique_lock<std::mutex> lock(mutex);
+    pendingWidth = width;
+    pendingHeight = height;
+    Submit(lock);
+}
+
+void DocumentPipeline::SetLayoutThreads(unsigned threads) {
+    std::unique_lock<std::mutex> lock(mutex);
+    pendingThreads = std::max(threads, 1u);
+    Submit(lock);
+}
+
+void DocumentPipeline::SetPublishCallback(std::function<void()> callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    publishCallback = std::move(callback);
+}
+
+void DocumentPipeline::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return completed == submitted; });
+}
+
+PipelineStats DocumentPipeline::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void DocumentPipeline::Submit(std::unique_lock<std::mutex>& lock) {
+    submitted++;
+    lock.unlock();
+    wake.notify_one();
+}
+
+void DocumentPipeline::Run() {
+    std::string path;
+    std::shared_ptr<Element> newRoot;
+    std::vector<DocumentMutation> mutations;
+    std::vector<InputEvent> input;
+    std::function<void()> published;
+    for (;;) {
+        float newWidth, newHeight;
+        unsigned threads;
+        uint64_t target;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock,
+                      [this] { return stopping || completed != submitted; });
+            if (stopping) return;
+            path.swap(pendingPath);
+            newRoot = std::move(pendingRoot);
+            mutations.swap(pendingMutations);
+            input.swap(pendingInput);
+            newWidth = pendingWidth;
+            newHeight = pendingHeight;
+            threads = pendingThreads;
+            published = publishCallback;
+            target = submitted;
+        }
+
+        if (threads != layoutThreads) {
+            // the boxes come out the same, so nothing needs a relayout
+            layoutThreads = threads;
+            layout.SetThreadPool(nullptr);
+            pool.reset();
+            if (threads > 1) {
+                pool = std::make_unique<ThreadPool>(threads);
+                layout.SetThreadPool(pool.get());
+            }
+        }
+
+        // input hits the last layout, which is what is on screen
+        Clock::time_point start = Clock::now();
+        uint64_t generation = layout.Generation();
+        size_t dispatched = root ? input.size() : 0;
+        if (root && !input.empty()) {
+            grid.Update(*root, layout, styles);
+            dispatcher.Dispatch(input, grid, root, &layout);
+        }
+        input.clear();
+
+        size_t diagnostics = 0;
+        bool stylesLoaded = false;
+        if (!path.empty()) {
+            SourceBuffer source = SourceBuffer::Map(path);
+            if (CompiledDocument::IsCompiled(source.View())) {
+                CompiledDocument compiled =
+                    CompiledDocument::Open(std::move(source));
+                if (compiled.IsOpen()) {
+                    newRoot = compiled.BuildElementTree(true);
+                    compiled.LoadStyles(styles);
+                    stylesLoaded = true;
+                } else {
+                    std::cerr << path << ": unreadable compiled document"
+                              << std::endl;
+                    diagnostics = 1;
+                }
+            } else {
+                Tokenizer tokenizer(std::move(source));
+                Parser parser(tokenizer);
+                newRoot = parser.Parse();
+                for (const ParseDiagnostic& diagnostic :
+                     parser.Diagnostics()) {
+                    std::cerr << path << ":" << diagnostic.line << ":"
+                              << diagnostic.column << ": "
+                              << diagnostic.message << std::endl;
+                }
+                diagnostics = parser.Diagnostics().size();
+            }
+        }
+
+        bool changed = newRoot != nullptr || newWidth != width ||
+                       newHeight != height;
+        if (newRoot) {
+            root = std::move(newRoot);
+            copies.clear();
+            grid.Clear();
+            tracker.Reset();
+            dispatcher = EventDispatcher();
+            styles.SetStyleSheet(CollectStyleSheets(*root, path));
+            if (stylesLoaded) {
+                layout.AdoptStyles();
+            } else {
+                layout.Invalidate();
+            }
+        }
+        path.clear();
+        width = newWidth;
+        height = newHeight;
+        size_t applied = root ? mutations.size() : 0;
+        if (root) {
+            for (DocumentMutation& mutation : mutations) mutation(*root);
+        }
+        mutations.clear();
+
+        bool built = false;
+        if (root) {
+            layout.Layout(*root, width, height);
+            // input and mutations that moved nothing need no new snapshot
+            if (changed || layout.Generation() != generation) {
+                Build(start, changed);
+                built = true;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed = target;
+            stats.mutations += applied;
+            stats.builds += built;
+            stats.parseErrors += diagnostics;
+            stats.inputEvents += dispatched;
+        }
+        idle.notify_all();
+        if (built && published) published();
+    }
+}
+
+void DocumentPipeline::Build(Clock::time_point start, bool full) {
+    DocumentSnapshot& snapshot = snapshots.Back();
+    snapshot.sequence = ++sequence;
+    snapshot.root = Copy(*root);
+    snapshot.styles.CopyStyles(styles);
+    snapshot.boxes.clear();
+    CollectBoxes(*root, layout, 0, 0, snapshot.boxes);
+    snapshot.width = width;
+    snapshot.height = height;
+    {
+        std::lock_guard<std::mutex> lock(glyphLock);
+        if (glyphs) glyphs->BeginFrame();
+        snapshot.list.Clear();
+        tracker.BeginRecord(layout.SubtreeSize(*root));
+        PaintTree(*root, layout, styles, snapshot.list, glyphs, font, &tracker,
+                  text.get());
+        snapshot.glyphGeneration = glyphs ? glyphs->Generation() : 0;
+    }
+    snapshot.damage.Clear();
+    tracker.EndRecord(snapshot.damage);
+    if (full) snapshot.damage.SetFull(width, height);
+    // the last snapshot is about to be replaced unread, so what it changed
+    // is still to be drawn; taken meanwhile, this repaints a little more
+    if (snapshots.HasFresh()) snapshot.damage.Add(lastDamage);
+    lastDamage = snapshot.damage;
+    snapshot.buildMs =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count();
+    snapshots.Publish();
+}
+
+std::shared_ptr<Element> DocumentPipeline::Copy(Element& element) {
+    if (element.index >= copies.size()) copies.resize(element.index + 1);
+    constexpr uint8_t changed = kDirtyCopy | kDirtyCopyDescendants;
+    const ElementCopy& previous = copies[element.index];
+    if (previous.source == &element && !(element.dirty & changed)) {
+        return previous.copy;
+    }
+
+    // copies already published are shared, so a change makes a new one
+    auto copy = std::make_shared<Element>(element.tag);
+    copy->index = element.index;
+    copy->dirty = 0;
+    copy->attributes = element.attributes;
+    copy->innerText = element.innerText;
+    copy->children.reserve(element.children.size());
+    for (const auto& child : element.children) {
+        copy->children.push_back(Copy(*child));
+    }
+    element.dirty &= ~changed;
+    // the children may have grown the table, so no reference is kept
+    copies[element.index] = {&element, copy};
+    return copy;
+}
@@ -0,0 +1,170 @@
+#include <GL/glew.h>
+#include "Core/ProgramCache.h"
+#include "Core/Hash.h"
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = {'V', 'S', 'P', 'B'};
+constexpr uint32_t kVersion = 1;
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;  // driver's binary format enum
+    uint32_t length;
+    uint64_t key;
+    double compileMs;  // what compiling this program cost
+};
+
+uint64_t HashString(uint64_t hash, const char* text) {
+    // the terminator keeps "ab" + "c" apart from "a" + "bc"
+    return HashBytes(hash, text ? text : "", text ? std::strlen(text) + 1 : 1);
+}
+
+uint64_t ProgramKey(const std::string& vertexCode,
+                    const std::string& fragmentCode) {
+    uint64_t hash = kHashSeed;
+    hash = HashString(hash, vertexCode.c_str());
+    hash = HashString(hash, fragmentCode.c_str());
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        hash = HashString(
+            hash, reinterpret_cast<const char*>(glGetString(name)));
+    }
+    return hash;
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+}  // namespace
+
+ProgramCache& ProgramCache::Global() {
+    static ProgramCache cache;
+    return cache;
+}
+
+void ProgramCache::SetDirectory(const std::string& directory) {
+    this->directory = directory;
+    if (!directory.empty()) mkdir(directory.c_str(), 0755);
+}
+
+bool ProgramCache::Enabled() {
+    if (directory.empty()) return false;
+    if (supported < 0) {
+        GLint formats = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        supported = formats > 0;
+    }
+    return supported;
+}
+
+std::string ProgramCache::PathFor(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/%016llx.bin",
+                  static_cast<unsigned long long>(key));
+    return directory + name;
+}
+
+unsigned int ProgramCache::Load(const std::string& vertexCode,
+                                const std::string& fragmentCode) {
+    if (!Enabled()) return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t key = ProgramKey(vertexCode, fragmentCode);
+    FILE* file = std::fopen(PathFor(key).c_str(), "rb");
+    if (!file) {
+        stats.misses++;
+        return 0;
+    }
+
+    BinaryHeader header;
+    std::vector<uint8_t> binary;
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                 std::memcmp(header.magic, kMagic, 4) == 0 &&
+                 header.version == kVersion && header.key == key;
+    if (valid) {
+        binary.resize(header.length);
+        valid = std::fread(binary.data(), 1, binary.size(), file) ==
+                binary.size();
+    }
+    std::fclose(file);
+
+    GLint linked = 0;
+    unsigned int program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(),
+                        GLsizei(binary.size()));
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+    if (!linked) {
+        // stale or corrupt; the caller compiles and Store() replaces it
+        if (program) glDeleteProgram(program);
+        stats.rejected++;
+        stats.misses++;
+        return 0;
+    }
+
+    double loadMs = MillisecondsSince(start);
+    stats.hits++;
+    stats.loadMs += loadMs;
+    stats.savedMs += header.compileMs - loadMs;
+    return program;
+}
+
+void ProgramCache::MarkRetrievable(unsigned int program) {
+    if (Enabled()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                            GL_TRUE);
+    }
+}
+
+void ProgramCache::Store(unsigned int program, const std::string& vertexCode,
+                         const std::string& fragmentCode, double compileMs) {
+    stats.compileMs += compileMs;
+    if (!Enabled()) return;
+
+    GLint linked = 0, length = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0) return;
+
+    BinaryHeader header;
+    std::memcpy(header.magic, kMagic, 4);
+    header.version = kVersion;
+    header.key = ProgramKey(vertexCode, fragmentCode);
+    header.compileMs = compileMs;
+
+    std::vector<uint8_t> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    header.format = format;
+    header.length = uint32_t(length);
+
+    // written aside and renamed, so a concurrent launch never reads half
+    std::string path = PathFor(header.key);
+    std::string temporary = path + "." + std::to_string(getpid()) + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return;
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(binary.data(), 1, header.length, file) ==
+                       header.length;
+    if (std::fclose(file) == 0 && written &&
+        std::rename(temporary.c_str(), path.c_str()) == 0) {
+        stats.stored++;
+    } else {
+        std::remove(temporary.c_str());
+    }
+}
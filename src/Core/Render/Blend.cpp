@@ -0,0 +1,188 @@
+#include "Core/Render/Blend.h"
+#include <cstring>
+
+#if !defined(VISION_DISABLE_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VISION_BLEND_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VISION_BLEND_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VISION_BLEND_NEON
+#endif
+#endif
+
+namespace {
+
+// x / 255 rounded, exact for every product of two bytes.
+inline uint32_t Div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+inline void BlendPixel(uint8_t* pixel, const uint8_t* source, uint32_t alpha) {
+    uint32_t inverse = 255 - alpha;
+    for (int channel = 0; channel < 4; channel++) {
+        pixel[channel] = uint8_t(
+            Div255(source[channel] * alpha + pixel[channel] * inverse));
+    }
+}
+
+#if defined(VISION_BLEND_AVX2) || defined(VISION_BLEND_SSE2)
+// 16-bit lanes; products of two bytes never overflow them.
+inline __m128i Div255(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Per-pixel alpha for four pixels in the low lanes of 8 x u16.
+inline __m128i SpanAlpha(const uint8_t* coverage, __m128i alpha) {
+    uint32_t bytes;
+    std::memcpy(&bytes, coverage, 4);
+    __m128i lanes =
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(bytes)), _mm_setzero_si128());
+    return Div255(_mm_mullo_epi16(lanes, alpha));
+}
+
+// Two pixels of 16-bit channels: source * alpha + dst * (255 - alpha).
+inline __m128i Mix(__m128i source, __m128i dst, __m128i alpha) {
+    __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return Div255(_mm_add_epi16(_mm_mullo_epi16(source, alpha),
+                                _mm_mullo_epi16(dst, inverse)));
+}
+#endif
+
+#if defined(VISION_BLEND_AVX2)
+inline __m256i Div255(__m256i x) {
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+inline __m256i Combine(__m128i low, __m128i high) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+inline __m256i Mix(__m256i source, __m256i dst, __m256i alpha) {
+    __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+    return Div255(_mm256_add_epi16(_mm256_mullo_epi16(source, alpha),
+                                   _mm256_mullo_epi16(dst, inverse)));
+}
+#endif
+
+#if defined(VISION_BLEND_NEON)
+inline uint8x8_t Div255(uint16x8_t x) {
+    return vraddhn_u16(x, vrshrq_n_u16(x, 8));
+}
+#endif
+
+}  // namespace
+
+uint32_t PackPixel(Color color) {
+    uint8_t bytes[4] = {color.r, color.g, color.b, color.a};
+    uint32_t pixel;
+    std::memcpy(&pixel, bytes, 4);
+    return pixel;
+}
+
+void FillSpan(uint32_t* dst, size_t count, Color color) {
+    uint32_t pixel = PackPixel(color);
+    size_t i = 0;
+#if defined(VISION_BLEND_AVX2)
+    __m256i fill = _mm256_set1_epi32(int(pixel));
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), fill);
+    }
+#elif defined(VISION_BLEND_SSE2)
+    __m128i fill = _mm_set1_epi32(int(pixel));
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), fill);
+    }
+#elif defined(VISION_BLEND_NEON)
+    uint32x4_t fill = vdupq_n_u32(pixel);
+    for (; i + 4 <= count; i += 4) vst1q_u32(dst + i, fill);
+#endif
+    for (; i < count; i++) dst[i] = pixel;
+}
+
+void BlendSpan(uint32_t* dst, size_t count, Color color,
+               const uint8_t* coverage) {
+    if (!coverage) {
+        if (color.a == 255) return FillSpan(dst, count, color);
+        if (color.a == 0) return;
+    }
+
+    uint8_t source[4] = {color.r, color.g, color.b, color.a};
+    size_t i = 0;
+#if defined(VISION_BLEND_AVX2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i source2 = _mm_unpacklo_epi8(_mm_set1_epi32(int(PackPixel(color))),
+                                        zero);
+    __m256i source4 = Combine(source2, source2);
+    __m128i alpha = _mm_set1_epi16(color.a);
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = alpha;
+        if (coverage) {
+            __m128i lanes = _mm_unpacklo_epi8(
+                _mm_loadl_epi64(
+                    reinterpret_cast<const __m128i*>(coverage + i)),
+                zero);
+            a = Div255(_mm_mullo_epi16(lanes, alpha));
+        }
+        // spread each pixel's alpha over its four channels, in the lane
+        // order the in-lane byte unpacks below produce
+        __m128i low = _mm_unpacklo_epi16(a, a);
+        __m128i high = _mm_unpackhi_epi16(a, a);
+        __m256i alphaLow = Combine(_mm_unpacklo_epi32(low, low),
+                                   _mm_unpacklo_epi32(high, high));
+        __m256i alphaHigh = Combine(_mm_unpackhi_epi32(low, low),
+                                    _mm_unpackhi_epi32(high, high));
+
+        __m256i* p = reinterpret_cast<__m256i*>(dst + i);
+        __m256i pixels = _mm256_loadu_si256(p);
+        __m256i zero4 = _mm256_setzero_si256();
+        __m256i mixedLow = Mix(source4, _mm256_unpacklo_epi8(pixels, zero4),
+                               alphaLow);
+        __m256i mixedHigh = Mix(
+            source4, _mm256_unpackhi_epi8(pixels, zero4), alphaHigh);
+        _mm256_storeu_si256(p, _mm256_packus_epi16(mixedLow, mixedHigh));
+    }
+#elif defined(VISION_BLEND_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    __m128i source2 = _mm_unpacklo_epi8(_mm_set1_epi32(int(PackPixel(color))),
+                                        zero);
+    __m128i alpha = _mm_set1_epi16(color.a);
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = coverage ? SpanAlpha(coverage + i, alpha) : alpha;
+        __m128i spread = _mm_unpacklo_epi16(a, a);
+        __m128i* p = reinterpret_cast<__m128i*>(dst + i);
+        __m128i pixels = _mm_loadu_si128(p);
+        __m128i mixedLow = Mix(source2, _mm_unpacklo_epi8(pixels, zero),
+                               _mm_unpacklo_epi32(spread, spread));
+        __m128i mixedHigh = Mix(source2, _mm_unpackhi_epi8(pixels, zero),
+                                _mm_unpackhi_epi32(spread, spread));
+        _mm_storeu_si128(p, _mm_packus_epi16(mixedLow, mixedHigh));
+    }
+#elif defined(VISION_BLEND_NEON)
+    uint8x8_t alpha = vdup_n_u8(color.a);
+    for (; i + 8 <= count; i += 8) {
+        uint8x8_t a = coverage ? Div255(vmull_u8(vld1_u8(coverage + i), alpha))
+                               : alpha;
+        uint8x8_t inverse = vmvn_u8(a);
+        uint8_t* p = reinterpret_cast<uint8_t*>(dst + i);
+        // deinterleaved load, one register per channel
+        uint8x8x4_t pixels = vld4_u8(p);
+        for (int channel = 0; channel < 4; channel++) {
+            pixels.val[channel] =
+                Div255(vmlal_u8(vmull_u8(vdup_n_u8(source[channel]), a),
+                                pixels.val[channel], inverse));
+        }
+        vst4_u8(p, pixels);
+    }
+#endif
+    for (; i < count; i++) {
+        uint32_t a = coverage ? Div255(coverage[i] * color.a) : color.a;
+        BlendPixel(reinterpret_cast<uint8_t*>(dst + i), source, a);
+    }
+}
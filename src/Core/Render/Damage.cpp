@@ -0,0 +1,127 @@
+#include "Core/Render/Damage.h"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+float RectArea(const Rect& rect) { return rect.width * rect.height; }
+
+bool Contains(const Rect& outer, const Rect& inner) {
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.width <= outer.x + outer.width &&
+           inner.y + inner.height <= outer.y + outer.height;
+}
+
+// Out to whole pixels, so edges drawn at fractional positions are redrawn
+// in full.
+Rect Snap(const Rect& rect) {
+    float left = std::floor(rect.x), top = std::floor(rect.y);
+    return {left, top, std::ceil(rect.x + rect.width) - left,
+            std::ceil(rect.y + rect.height) - top};
+}
+
+}  // namespace
+
+void DamageRegion::Add(const Rect& rect) {
+    if (full || rect.IsEmpty()) return;
+
+    Rect merged = Snap(rect);
+    // absorbing a rectangle can make the union reach others, so repeat
+    for (bool grew = true; grew;) {
+        grew = false;
+        for (size_t i = 0; i < rects.size(); i++) {
+            if (Contains(rects[i], merged)) return;
+            if (rects[i].Intersects(merged)) {
+                merged = merged.Union(rects[i]);
+                rects[i] = rects.back();
+                rects.pop_back();
+                grew = true;
+                break;
+            }
+        }
+    }
+    rects.push_back(merged);
+
+    while (rects.size() > kMaxRects) {
+        size_t first = 0, second = 1;
+        float best = std::numeric_limits<float>::max();
+        for (size_t i = 0; i < rects.size(); i++) {
+            for (size_t j = i + 1; j < rects.size(); j++) {
+                float waste = RectArea(rects[i].Union(rects[j])) -
+                              RectArea(rects[i]) - RectArea(rects[j]);
+                if (waste < best) {
+                    best = waste;
+                    first = i;
+                    second = j;
+                }
+            }
+        }
+        Rect combined = rects[first].Union(rects[second]);
+        rects[second] = rects.back();
+        rects.pop_back();
+        rects[first] = combined;
+    }
+}
+
+void DamageRegion::Add(const DamageRegion& other) {
+    if (other.full) {
+        Rect area = other.rects[0];
+        if (full) area = area.Union(rects[0]);
+        SetFull(area.width, area.height);
+        return;
+    }
+    for (const Rect& rect : other.rects) Add(rect);
+}
+
+void DamageRegion::SetFull(float width, float height) {
+    rects.assign(1, Rect{0, 0, width, height});
+    full = true;
+}
+
+void DamageRegion::Clear() {
+    rects.clear();
+    full = false;
+}
+
+float DamageRegion::Area() const {
+    float area = 0;
+    for (const Rect& rect : rects) area += RectArea(rect);
+    return area;
+}
+
+void DamageTracker::BeginRecord(uint32_t nodes) {
+    if (entries.size() < nodes) entries.resize(nodes);
+    stamp++;
+    changed.clear();
+}
+
+void DamageTracker::Paint(uint32_t index, const Rect& bounds,
+                          uint64_t signature) {
+    if (index >= entries.size()) entries.resize(index + 1);
+    Entry& entry = entries[index];
+    if (entry.stamp == 0) {
+        changed.push_back(bounds);
+        painted.push_back(index);
+    } else if (entry.signature != signature) {
+        changed.push_back(entry.bounds);
+        changed.push_back(bounds);
+    }
+    entry = {bounds, signature, stamp};
+}
+
+void DamageTracker::EndRecord(DamageRegion& damage) {
+    // painted before but not this time: removed, hidden or culled; only
+    // what was painted is looked at, however long the page
+    size_t kept = 0;
+    for (uint32_t index : painted) {
+        Entry& entry = entries[index];
+        if (entry.stamp == stamp) {
+            painted[kept++] = index;
+            continue;
+        }
+        changed.push_back(entry.bounds);
+        entry.stamp = 0;
+    }
+    painted.resize(kept);
+    for (const Rect& rect : changed) damage.Add(rect);
+}
@@ -0,0 +1,217 @@
+#include "Core/Render/DisplayList.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+enum BatchState : uint8_t { kStateSolid, kStateGlyph, kStateClip };
+
+// How many batches back a command may move; bounds the batching cost on
+// long lists.
+constexpr size_t kMaxLookback = 16;
+
+struct Batch {
+    BatchState state;
+    Rect bounds;
+};
+
+}  // namespace
+
+template <typename T>
+size_t DisplayList::Append(DisplayOp op, const T& payload) {
+    size_t offset = bytes.size();
+    bytes.resize(offset + 1 + sizeof(T));
+    bytes[offset] = uint8_t(op);
+    std::memcpy(&bytes[offset + 1], &payload, sizeof(T));
+    return offset + 1;
+}
+
+template <typename T>
+T DisplayList::Read(size_t offset) const {
+    T payload;
+    std::memcpy(&payload, &bytes[offset], sizeof(T));
+    return payload;
+}
+
+void DisplayList::BeginFrame(int, int, Color) { Clear(); }
+
+void DisplayList::Clear() {
+    bytes.clear();
+    runOffset = kNoRun;
+    stats = DisplayListStats();
+}
+
+void DisplayList::FillRect(float x, float y, float width, float height,
+                           Color color, float radius) {
+    if (color.IsTransparent() || width <= 0 || height <= 0) return;
+
+    runOffset = kNoRun;
+    RectPayload payload = {{x, y, width, height}, color, radius};
+    Append(radius > 0 ? DisplayOp::RoundedRect : DisplayOp::Rect, payload);
+    stats.commands++;
+}
+
+void DisplayList::DrawGlyph(float x0, float y0, float x1, float y1,
+                            const AtlasRegion& region, Color color) {
+    GlyphQuad quad = {x0, y0, x1, y1, region};
+    Rect bounds = {x0, y0, x1 - x0, y1 - y0};
+
+    // the open run keeps growing while the color stays the same
+    bool extend = false;
+    GlyphRunHeader header;
+    if (runOffset != kNoRun) {
+        header = Read<GlyphRunHeader>(runOffset);
+        extend = header.color == color;
+    }
+
+    if (extend) {
+        header.count++;
+        header.bounds = header.bounds.Union(bounds);
+        std::memcpy(&bytes[runOffset], &header, sizeof(header));
+    } else {
+        runOffset =
+            Append(DisplayOp::GlyphRun, GlyphRunHeader{color, 1, bounds});
+        stats.commands++;
+    }
+
+    size_t offset = bytes.size();
+    bytes.resize(offset + sizeof(quad));
+    std::memcpy(&bytes[offset], &quad, sizeof(quad));
+}
+
+void DisplayList::PushClip(const Rect& clip) {
+    runOffset = kNoRun;
+    Append(DisplayOp::PushClip, clip);
+    stats.commands++;
+}
+
+void DisplayList::PopClip() {
+    runOffset = kNoRun;
+    bytes.push_back(uint8_t(DisplayOp::PopClip));
+    stats.commands++;
+}
+
+uint32_t DisplayList::AssignBatches() const {
+    commands.clear();
+    std::vector<Batch> batches;
+    size_t floor = 0;  // batches before a clip are closed
+
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        DisplayOp op = DisplayOp(bytes[offset++]);
+        Command command = {uint32_t(offset), 0, op, Rect()};
+
+        BatchState state;
+        Rect bounds;
+        switch (op) {
+            case DisplayOp::Rect:
+            case DisplayOp::RoundedRect:
+                state = kStateSolid;
+                bounds = Read<RectPayload>(offset).rect;
+                offset += sizeof(RectPayload);
+                break;
+            case DisplayOp::GlyphRun: {
+                GlyphRunHeader header = Read<GlyphRunHeader>(offset);
+                state = kStateGlyph;
+                bounds = header.bounds;
+                offset += sizeof(header) + header.count * sizeof(GlyphQuad);
+                break;
+            }
+            case DisplayOp::PushClip:
+                state = kStateClip;
+                offset += sizeof(Rect);
+                break;
+            default:
+                state = kStateClip;
+                break;
+        }
+
+        if (state == kStateClip) {
+            command.batch = uint32_t(batches.size());
+            batches.push_back({state, Rect()});
+            floor = batches.size();
+            commands.push_back(command);
+            continue;
+        }
+
+        // walk back to the earliest batch of the same state that no
+        // overlapping batch separates from this command
+        size_t target = batches.size();
+        size_t limit = batches.size() - std::min(batches.size() - floor,
+                                                 kMaxLookback);
+        for (size_t i = batches.size(); i > limit; i--) {
+            Batch& batch = batches[i - 1];
+            bool overlaps = batch.bounds.Intersects(bounds);
+            if (batch.state == state) target = i - 1;
+            if (overlaps) break;
+        }
+        if (target == batches.size()) {
+            batches.push_back({state, bounds});
+        } else {
+            batches[target].bounds = batches[target].bounds.Union(bounds);
+        }
+        command.batch = uint32_t(target);
+        command.bounds = bounds;
+        commands.push_back(command);
+    }
+
+    std::stable_sort(commands.begin(), commands.end(),
+                     [](const Command& a, const Command& b) {
+                         return a.batch < b.batch;
+                     });
+    return uint32_t(batches.size());
+}
+
+void DisplayList::Replay(Renderer& renderer) const {
+    stats.batches = AssignBatches();
+    for (const Command& command : commands) Execute(renderer, command);
+}
+
+void DisplayList::Replay(Renderer& renderer, const DamageRegion& damage,
+                         Color clearColor) const {
+    stats.batches = AssignBatches();
+    for (const Rect& rect : damage.Rects()) {
+        renderer.PushClip(rect);
+        renderer.FillRect(rect.x, rect.y, rect.width, rect.height, clearColor);
+        for (const Command& command : commands) {
+            // clips always run so pushes and pops stay paired
+            bool clip = command.op == DisplayOp::PushClip ||
+                        command.op == DisplayOp::PopClip;
+            if (clip || command.bounds.Intersects(rect)) {
+                Execute(renderer, command);
+            }
+        }
+        renderer.PopClip();
+    }
+}
+
+void DisplayList::Execute(Renderer& renderer, const Command& command) const {
+    size_t offset = command.offset;
+    switch (command.op) {
+        case DisplayOp::Rect:
+        case DisplayOp::RoundedRect: {
+            RectPayload payload = Read<RectPayload>(offset);
+            renderer.FillRect(payload.rect.x, payload.rect.y,
+                              payload.rect.width, payload.rect.height,
+                              payload.color, payload.radius);
+            break;
+        }
+        case DisplayOp::GlyphRun: {
+            GlyphRunHeader header = Read<GlyphRunHeader>(offset);
+            offset += sizeof(header);
+            for (uint32_t i = 0; i < header.count; i++) {
+                GlyphQuad quad = Read<GlyphQuad>(offset);
+                offset += sizeof(quad);
+                renderer.DrawGlyph(quad.x0, quad.y0, quad.x1, quad.y1,
+                                   quad.region, header.color);
+            }
+            break;
+        }
+        case DisplayOp::PushClip:
+            renderer.PushClip(Read<Rect>(offset));
+            break;
+        case DisplayOp::PopClip:
+            renderer.PopClip();
+            break;
+    }
+}
@@ -0,0 +1,172 @@
+#include <GL/glew.h>
+#include "Core/Render/GLRenderer.h"
+#include "glm/ext/matrix_clip_space.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr unsigned int kFrameBinding = 0;
+constexpr UniformId kProjection = HashUniformName("projection");
+constexpr UniformId kText = HashUniformName("text");
+
+}  // namespace
+
+GLRenderer::GLRenderer(Shader& shader, GlyphAtlas& atlas)
+    : shader(shader),
+      text(atlas),
+      frameUniforms(kFrameBinding, sizeof(glm::mat4)),
+      rects(kFrameBinding) {
+    hasFrameBlock = shader.BindUniformBlock("Frame", kFrameBinding);
+}
+
+GLRenderer::~GLRenderer() {
+    if (backFramebuffer) glDeleteFramebuffers(1, &backFramebuffer);
+    if (backTexture) glDeleteTextures(1, &backTexture);
+}
+
+void GLRenderer::BeginFrame(int width, int height, Color clearColor) {
+    retained = false;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Setup(width, height);
+    Clear(clearColor);
+}
+
+bool GLRenderer::BeginRetainedFrame(int width, int height, Color clearColor) {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    bool kept = backFramebuffer && backWidth == viewport[2] &&
+                backHeight == viewport[3];
+    if (!kept && !CreateBackBuffer(viewport[2], viewport[3])) {
+        BeginFrame(width, height, clearColor);
+        return false;
+    }
+
+    retained = true;
+    glBindFramebuffer(GL_FRAMEBUFFER, backFramebuffer);
+    Setup(width, height);
+    if (!kept) Clear(clearColor);
+    return kept;
+}
+
+bool GLRenderer::CreateBackBuffer(int width, int height) {
+    if (width <= 0 || height <= 0) return false;
+    if (!backFramebuffer) glGenFramebuffers(1, &backFramebuffer);
+    if (!backTexture) glGenTextures(1, &backTexture);
+
+    glBindTexture(GL_TEXTURE_2D, backTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, backFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           backTexture, 0);
+    bool complete =
+        glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    backWidth = complete ? width : 0;
+    backHeight = complete ? height : 0;
+    return complete;
+}
+
+void GLRenderer::Clear(Color clearColor) {
+    glClearColor(clearColor.r / 255.0f, clearColor.g / 255.0f,
+                 clearColor.b / 255.0f, clearColor.a / 255.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void GLRenderer::Setup(int width, int height) {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    framebufferHeight = viewport[3];
+    scaleX = width > 0 ? float(viewport[2]) / width : 1.0f;
+    scaleY = height > 0 ? float(viewport[3]) / height : 1.0f;
+    clipStack.clear();
+    pending = Pending::None;
+    glDisable(GL_SCISSOR_TEST);
+
+    // top-left origin, matching layout coordinates
+    glm::mat4 projection = glm::ortho(0.0f, float(width), float(height), 0.0f);
+    shader.Bind();
+    shader.ResetStats();
+    // the rectangle program always reads the block
+    frameUniforms.Update(&projection[0][0], sizeof(projection));
+    if (!hasFrameBlock) shader.SetUniformMat4(kProjection, projection);
+    shader.SetUniformInt(kText, 0);
+    text.BeginFrame();
+    rects.BeginFrame();
+}
+
+void GLRenderer::FillRect(float x, float y, float width, float height,
+                          Color color, float radius) {
+    if (color.a == 0 || width <= 0 || height <= 0) return;
+
+    // keep paint order: glyphs queued so far go first
+    if (pending == Pending::Glyphs) Flush();
+    pending = Pending::Rects;
+    rects.Add({x, y, width, height, {radius, radius, radius, radius}, color,
+               Color(), 0});
+}
+
+void GLRenderer::DrawGlyph(float x0, float y0, float x1, float y1,
+                           const AtlasRegion& region, Color color) {
+    if (pending == Pending::Rects) Flush();
+    pending = Pending::Glyphs;
+    text.AddQuad(x0, y0, x1, y1, region, color);
+}
+
+void GLRenderer::Flush() {
+    if (pending == Pending::Rects) {
+        rects.Flush();
+        shader.Bind();  // glyphs expect their program bound
+    } else if (pending == Pending::Glyphs) {
+        text.Flush();
+    }
+    pending = Pending::None;
+}
+
+void GLRenderer::PushClip(const Rect& clip) {
+    Rect rect = clipStack.empty() ? clip : clipStack.back().Intersect(clip);
+    Flush();
+    clipStack.push_back(rect);
+    ApplyClip();
+}
+
+void GLRenderer::PopClip() {
+    if (clipStack.empty()) return;
+    Flush();
+    clipStack.pop_back();
+    ApplyClip();
+}
+
+void GLRenderer::ApplyClip() {
+    if (clipStack.empty()) {
+        glDisable(GL_SCISSOR_TEST);
+        return;
+    }
+    // scissor boxes are framebuffer pixels with a bottom-left origin
+    const Rect& clip = clipStack.back();
+    int left = int(std::lround(clip.x * scaleX));
+    int right = int(std::lround((clip.x + clip.width) * scaleX));
+    int top = int(std::lround(clip.y * scaleY));
+    int bottom = int(std::lround((clip.y + clip.height) * scaleY));
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(left, framebufferHeight - bottom, std::max(right - left, 0),
+              std::max(bottom - top, 0));
+}
+
+void GLRenderer::EndFrame() {
+    Flush();
+    glDisable(GL_SCISSOR_TEST);
+    if (!retained) return;
+
+    // the back buffer keeps this frame for the next retained one
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, backFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, backWidth, backHeight, 0, 0, backWidth,
+                      backHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    retained = false;
+}
@@ -0,0 +1,269 @@
+#include "Core/Render/Painter.h"
+#include "Core/Hash.h"
+#include "Core/Text/Utf8.h"
+#include "Core/TreeAccess.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct PaintContext {
+    const LayoutEngine& layout;
+    Renderer& renderer;
+    GlyphCache* glyphs;
+    FontId font;
+    DamageTracker* damage;
+    TextLayout* text;
+};
+
+// Covers antialiased edges and glyphs overhanging their advance.
+constexpr float kDamageMargin = 2;
+
+// The first i in [first, end) that pred is false for, pred being true for
+// a leading run only.
+template <typename Predicate>
+size_t PartitionPoint(size_t first, size_t end, Predicate pred) {
+    while (first < end) {
+        size_t middle = first + (end - first) / 2;
+        if (pred(middle)) {
+            first = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return first;
+}
+
+// clip is what of the page is still visible, in the renderer's coordinates.
+template <typename Tree>
+void PaintElement(const PaintContext& context, const Tree& tree,
+                  typename Tree::ConstNode node, float parentX, float parentY,
+                  const Rect& clip) {
+    const ComputedStyle& style = tree.Style(node);
+    if (style.display == Display::None) return;
+
+    uint32_t index = tree.Index(node);
+    const LayoutBox& box = context.layout.GetBox(index);
+    float x = parentX + box.x, y = parentY + box.y;
+    Rect painted = {x + box.overflow.x, y + box.overflow.y,
+                    box.overflow.width, box.overflow.height};
+    if (!painted.Intersects(clip)) return;  // nothing of it would show
+
+    Rect bounds;
+    uint64_t signature = kHashSeed;
+    float radius = 0;
+    if (!style.backgroundColor.IsTransparent()) {
+        radius = style.borderRadius.Resolve(std::min(box.width, box.height), 0);
+        context.renderer.FillRect(x, y, box.width, box.height,
+                                  style.backgroundColor, radius);
+        bounds = {x, y, box.width, box.height};
+    }
+
+    // a clipping box scrolls its content, its own text included
+    bool clips = style.overflow != Overflow::Visible;
+    Rect inner = clip;
+    float contentX = x, contentY = y;
+    if (clips) {
+        inner = clip.Intersect({x, y, box.width, box.height});
+        context.renderer.PushClip(inner);
+        contentX -= box.scrollX;
+        contentY -= box.scrollY;
+    }
+
+    std::string_view innerText = tree.Text(node);
+    if (context.glyphs && !innerText.empty() &&
+        !style.color.IsTransparent()) {
+        uint16_t size = uint16_t(std::lround(style.fontSize.Resolve(0, 16)));
+        float left = contentX + box.text.x, top = contentY + box.text.y;
+        float width, height;
+        if (context.text) {
+            // the width layout settled on breaks at the same words
+            std::shared_ptr<const TextBlock> block = context.text->Layout(
+                innerText, context.font, size, box.text.width);
+            DrawTextBlock(context.renderer, *context.glyphs, context.font,
+                          *block, left, top, size, style.color);
+            width = block->width;
+            height = block->height;
+        } else {
+            float baseline =
+                top + context.glyphs->Ascender(context.font, size);
+            width = DrawText(context.renderer, *context.glyphs, context.font,
+                             innerText, left, baseline, size, style.color) -
+                    left;
+            height = size * 1.2f;
+        }
+        // measured text and drawn glyphs can disagree, cover both
+        Rect text = {left, top, std::max(width, box.text.width),
+                     std::max(height, box.text.height)};
+        bounds = bounds.IsEmpty() ? text : bounds.Union(text);
+        signature = HashValue(signature, style.color);
+        signature = HashValue(signature, size);
+        signature = HashValue(signature, box.text.width);
+        signature = HashBytes(signature, innerText.data(), innerText.size());
+    }
+
+    if (context.damage && !bounds.IsEmpty()) {
+        signature = HashValue(signature, bounds);
+        signature = HashValue(signature, style.backgroundColor);
+        signature = HashValue(signature, radius);
+        bounds = {bounds.x - kDamageMargin, bounds.y - kDamageMargin,
+                  bounds.width + 2 * kDamageMargin,
+                  bounds.height + 2 * kDamageMargin};
+        context.damage->Paint(index, bounds, signature);
+    }
+
+    auto [first, end] = context.layout.LaidOutChildren(tree, node);
+    auto boxOf = [&](size_t i) -> const LayoutBox& {
+        return context.layout.GetBox(tree.Index(tree.Child(node, i)));
+    };
+    if (context.layout.ChildrenSortedByY(index)) {
+        // children in flow: only the run crossing the clip's band can show,
+        // found by the same comparisons Intersects() makes
+        auto above = [&](size_t i) {
+            const LayoutBox& childBox = boxOf(i);
+            float top = contentY + childBox.y + childBox.overflow.y;
+            return !(inner.y < top + childBox.overflow.height);
+        };
+        auto startsInside = [&](size_t i) {
+            const LayoutBox& childBox = boxOf(i);
+            return contentY + childBox.y + childBox.overflow.y <
+                   inner.y + inner.height;
+        };
+        first = PartitionPoint(first, end, above);
+        end = PartitionPoint(first, end, startsInside);
+    }
+    for (size_t i = first; i < end; i++) {
+        PaintElement(context, tree, tree.Child(node, i), contentX, contentY,
+                     inner);
+    }
+    if (clips) context.renderer.PopClip();
+}
+
+template <typename Tree>
+void PaintRoot(const Tree& tree, typename Tree::ConstNode root,
+               const LayoutEngine& layout, Renderer& renderer,
+               GlyphCache* glyphs, FontId font, DamageTracker* damage,
+               TextLayout* text) {
+    if (glyphs && font == kInvalidFont) glyphs = nullptr;
+    PaintContext context = {layout, renderer, glyphs, font, damage, text};
+    const Rect& viewport = layout.Viewport();
+    PaintElement(context, tree, root, -viewport.x, -viewport.y,
+                 {0, 0, viewport.width, viewport.height});
+}
+
+}  // namespace
+
+float DrawText(Renderer& renderer, GlyphCache& glyphs, FontId font,
+               std::string_view text, float x, float baseline,
+               uint16_t pixelSize, Color color) {
+    size_t position = 0;
+    while (position < text.size()) {
+        uint32_t codepoint = DecodeUtf8(text, position);
+        GlyphInfo glyph;
+        if (!glyphs.GetGlyph(font, pixelSize, codepoint, glyph)) continue;
+
+        // whole pixels keep the atlas texels unfiltered
+        float x0 = std::round(x) + glyph.bearingX;
+        float y0 = baseline - glyph.bearingY;
+        if (glyph.region.width > 0 && glyph.region.height > 0) {
+            renderer.DrawGlyph(x0, y0, x0 + glyph.region.width,
+                               y0 + glyph.region.height, glyph.region, color);
+        }
+        x += glyph.advance / 64.0f;
+    }
+    return x;
+}
+
+void DrawTextBlock(Renderer& renderer, GlyphCache& glyphs, FontId font,
+                   const TextBlock& block, float x, float top,
+                   uint16_t pixelSize, Color color) {
+    const ShapedRun& run = *block.run;
+    float baseline = top + run.ascender;
+    for (const TextLine& line : block.lines) {
+        for (uint32_t i = line.start; i < line.end; i++) {
+            GlyphInfo glyph;
+            if (!glyphs.GetGlyph(font, pixelSize, run.codepoints[i], glyph) ||
+                glyph.region.width == 0 || glyph.region.height == 0) {
+                continue;
+            }
+            float x0 = std::round(x + block.GlyphX(line, i)) + glyph.bearingX;
+            float y0 = baseline - glyph.bearingY;
+            renderer.DrawGlyph(x0, y0, x0 + glyph.region.width,
+                               y0 + glyph.region.height, glyph.region, color);
+        }
+        baseline += run.lineHeight;
+    }
+}
+
+void PaintTree(const Element& root, const LayoutEngine& layout,
+               const StyleTable& styles, Renderer& renderer,
+               GlyphCache* glyphs, FontId font, DamageTracker* damage,
+               TextLayout* text) {
+    PaintRoot(ElementTree(styles), &root, layout, renderer, glyphs, font,
+              damage, text);
+}
+
+void PaintTree(const CompiledTree& tree, const LayoutEngine& layout,
+               Renderer& renderer, GlyphCache* glyphs, FontId font,
+               DamageTracker* damage, TextLayout* text) {
+    if (tree.Root() == kInvalidNode) return;
+    PaintRoot(tree, tree.Root(), layout, renderer, glyphs, font, damage,
+              text);
+}
+
+Painter::Painter(GlyphCache* glyphs, FontId font, TextLayout* text)
+    : glyphs(glyphs), font(font), text(text) {}
+
+const DisplayList& Painter::Paint(const Element& root,
+                                  const LayoutEngine& layout,
+                                  const StyleTable& styles) {
+    return Record(ElementTree(styles), &root, &root, layout);
+}
+
+const DisplayList& Painter::Paint(const CompiledTree& tree,
+                                  const LayoutEngine& layout) {
+    if (tree.Root() == kInvalidNode) {
+        list.Clear();
+        damage.Clear();
+        return list;
+    }
+    return Record(tree, tree.Root(), &tree, layout);
+}
+
+template <typename Tree>
+const DisplayList& Painter::Record(const Tree& tree,
+                                   typename Tree::ConstNode root,
+                                   const void* identity,
+                                   const LayoutEngine& layout) {
+    uint64_t atlasGeneration = glyphs ? glyphs->Generation() : 0;
+    if (valid && this->root == identity && this->layout == &layout &&
+        layoutGeneration == layout.Generation() &&
+        glyphGeneration == atlasGeneration) {
+        stats.reused++;
+        damage.Clear();
+        return list;
+    }
+
+    // a different tree or engine shares nothing with what is on screen
+    bool full = !valid || this->root != identity || this->layout != &layout;
+    if (full) tracker.Reset();
+
+    list.Clear();
+    damage.Clear();
+    tracker.BeginRecord(layout.SubtreeSize(tree.Index(root)));
+    PaintRoot(tree, root, layout, list, glyphs, font, &tracker, text);
+    tracker.EndRecord(damage);
+    if (full) {
+        const Rect& viewport = layout.Viewport();
+        damage.SetFull(viewport.width, viewport.height);
+    }
+    stats.recorded++;
+
+    valid = true;
+    this->root = identity;
+    this->layout = &layout;
+    layoutGeneration = layout.Generation();
+    // recording may rasterize glyphs and evict others, read it afterwards
+    glyphGeneration = glyphs ? glyphs->Generation() : 0;
+    return list;
+}
@@ -0,0 +1,119 @@
+#include <GL/glew.h>
+#include "Core/Render/RectRenderer.h"
+#include <cstddef>
+
+namespace {
+
+// The quad is the rectangle itself: the edge fades inside it, so nothing
+// is drawn past its bounds, as in SoftwareRenderer.
+const char* kVertexSource = R"(
+    #version 330 core
+    layout (location = 0) in vec4 rect;
+    layout (location = 1) in vec4 radii;
+    layout (location = 2) in vec4 color;
+    layout (location = 3) in vec4 borderColor;
+    layout (location = 4) in float borderWidth;
+    layout (std140) uniform Frame {
+        mat4 projection;
+    };
+    out vec2 Local;
+    flat out vec2 Size;
+    flat out vec4 Radii;
+    flat out vec4 Color;
+    flat out vec4 BorderColor;
+    flat out float BorderWidth;
+    void main()
+    {
+        // a triangle strip over the corners, no vertex buffer needed
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        Local = corner * rect.zw;
+        gl_Position = projection * vec4(rect.xy + Local, 0.0, 1.0);
+        Size = rect.zw;
+        Radii = radii;
+        Color = color;
+        BorderColor = borderColor;
+        BorderWidth = borderWidth;
+    }
+    )";
+
+const char* kFragmentSource = R"(
+    #version 330 core
+    in vec2 Local;
+    flat in vec2 Size;
+    flat in vec4 Radii;
+    flat in vec4 Color;
+    flat in vec4 BorderColor;
+    flat in float BorderWidth;
+    out vec4 FragColor;
+    void main()
+    {
+        // signed distance to the rounded rectangle, each quadrant with its
+        // own corner's radius
+        vec2 halfSize = Size * 0.5;
+        vec2 p = Local - halfSize;
+        float radius = p.x < 0.0 ? (p.y < 0.0 ? Radii.x : Radii.w)
+                                 : (p.y < 0.0 ? Radii.y : Radii.z);
+        radius = min(radius, min(halfSize.x, halfSize.y));
+        vec2 d = abs(p) - (halfSize - vec2(radius));
+        float dist = length(max(d, 0.0)) + min(max(d.x, d.y), 0.0) - radius;
+
+        // one pixel transition at the outer edge, and at the border's
+        // inner one
+        float alpha = 1.0 - smoothstep(0.0, 1.0, dist);
+        if (alpha < 0.01)
+            discard;
+        vec4 color = Color;
+        if (BorderWidth > 0.0) {
+            color = mix(Color, BorderColor,
+                        smoothstep(0.0, 1.0, dist + BorderWidth));
+        }
+        FragColor = vec4(color.rgb, color.a * alpha);
+    }
+    )";
+
+}  // namespace
+
+RectRenderer::RectRenderer(unsigned int frameBinding)
+    : shader(kVertexSource, kFragmentSource),
+      buffer(256 * sizeof(RectInstance)) {
+    shader.BindUniformBlock("Frame", frameBinding);
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.ID());
+    auto attribute = [](GLuint location, GLint size, GLenum type,
+                        GLboolean normalized, size_t offset) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, size, type, normalized,
+                              sizeof(RectInstance), (void*)offset);
+        glVertexAttribDivisor(location, 1);  // advances once per rectangle
+    };
+    attribute(0, 4, GL_FLOAT, GL_FALSE, offsetof(RectInstance, x));
+    attribute(1, 4, GL_FLOAT, GL_FALSE, offsetof(RectInstance, radii));
+    attribute(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(RectInstance, color));
+    attribute(3, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+              offsetof(RectInstance, borderColor));
+    attribute(4, 1, GL_FLOAT, GL_FALSE, offsetof(RectInstance, borderWidth));
+    glBindVertexArray(0);
+}
+
+RectRenderer::~RectRenderer() { glDeleteVertexArrays(1, &vao); }
+
+void RectRenderer::BeginFrame() {
+    instances.clear();
+    stats = RectRendererStats();
+}
+
+void RectRenderer::Flush() {
+    if (instances.empty()) return;
+
+    shader.Bind();
+    buffer.Upload(instances.data(), instances.size() * sizeof(RectInstance));
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(instances.size()));
+    glBindVertexArray(0);
+
+    stats.drawCalls++;
+    stats.rects += uint32_t(instances.size());
+    instances.clear();
+}
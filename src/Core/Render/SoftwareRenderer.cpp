@@ -0,0 +1,166 @@
+#include "Core/Render/SoftwareRenderer.h"
+#include "Core/Render/Blend.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// First pixel whose center lies at or past edge, kept within [low, high].
+inline int PixelEdge(float edge, int low, int high) {
+    float pixel = std::ceil(edge - 0.5f);
+    return int(std::min(std::max(pixel, float(low)), float(high)));
+}
+
+// Coverage of RectRenderer's rounded rectangle at (x, y), measured
+// from the rectangle's top left corner.
+uint8_t RoundedCoverage(float x, float y, float halfWidth, float halfHeight,
+                        float radius) {
+    float dx = std::abs(x - halfWidth) - (halfWidth - radius);
+    float dy = std::abs(y - halfHeight) - (halfHeight - radius);
+    float outside = std::hypot(std::max(dx, 0.0f), std::max(dy, 0.0f));
+    float distance = outside + std::min(std::max(dx, dy), 0.0f) - radius;
+
+    float t = std::min(std::max(distance, 0.0f), 1.0f);
+    float alpha = 1.0f - t * t * (3.0f - 2.0f * t);  // 1 - smoothstep
+    if (alpha < 0.01f) return 0;
+    return uint8_t(alpha * 255.0f + 0.5f);
+}
+
+}  // namespace
+
+SoftwareRenderer::SoftwareRenderer(const GlyphAtlas& atlas) : atlas(atlas) {}
+
+void SoftwareRenderer::BeginFrame(int width, int height, Color clearColor) {
+    this->width = std::max(width, 0);
+    this->height = std::max(height, 0);
+    pixels.resize(size_t(this->width) * this->height);
+    coverage.resize(this->width);
+    clip = {0, 0, this->width, this->height};
+    clipStack.clear();
+    FillSpan(pixels.data(), pixels.size(), clearColor);
+    pixelsShaded = pixels.size();
+}
+
+bool SoftwareRenderer::BeginRetainedFrame(int width, int height,
+                                          Color clearColor) {
+    if (width != this->width || height != this->height || pixels.empty()) {
+        BeginFrame(width, height, clearColor);
+        return false;
+    }
+    clip = {0, 0, width, height};
+    clipStack.clear();
+    pixelsShaded = 0;
+    return true;
+}
+
+void SoftwareRenderer::FillRect(float x, float y, float width, float height,
+                                Color color, float radius) {
+    int x0 = PixelEdge(x, clip.left, clip.right);
+    int x1 = PixelEdge(x + width, clip.left, clip.right);
+    int y0 = PixelEdge(y, clip.top, clip.bottom);
+    int y1 = PixelEdge(y + height, clip.top, clip.bottom);
+    if (x0 >= x1 || y0 >= y1 || color.a == 0) return;
+    pixelsShaded += uint64_t(x1 - x0) * (y1 - y0);
+
+    radius = std::min(radius, std::min(width, height) * 0.5f);
+    if (radius <= 0) {
+        for (int row = y0; row < y1; row++) {
+            BlendSpan(Row(row) + x0, x1 - x0, color);
+        }
+        return;
+    }
+
+    // only the corner squares need the distance function, the rest of the
+    // rectangle is solid
+    float halfWidth = width * 0.5f, halfHeight = height * 0.5f;
+    for (int row = y0; row < y1; row++) {
+        float localY = row + 0.5f - y;
+        if (localY >= radius && localY <= height - radius) {
+            BlendSpan(Row(row) + x0, x1 - x0, color);
+            continue;
+        }
+        uint8_t* mask = coverage.data();
+        for (int column = x0; column < x1; column++) {
+            float localX = column + 0.5f - x;
+            mask[column - x0] =
+                localX >= radius && localX <= width - radius
+                    ? 255
+                    : RoundedCoverage(localX, localY, halfWidth, halfHeight,
+                                      radius);
+        }
+        BlendSpan(Row(row) + x0, x1 - x0, color, mask);
+    }
+}
+
+void SoftwareRenderer::DrawGlyph(float x0, float y0, float x1, float y1,
+                                 const AtlasRegion& region, Color color) {
+    int left = PixelEdge(x0, clip.left, clip.right);
+    int right = PixelEdge(x1, clip.left, clip.right);
+    int top = PixelEdge(y0, clip.top, clip.bottom);
+    int bottom = PixelEdge(y1, clip.top, clip.bottom);
+    if (left >= right || top >= bottom || region.width == 0 ||
+        region.height == 0) {
+        return;
+    }
+    pixelsShaded += uint64_t(right - left) * (bottom - top);
+
+    float scaleX = region.width / (x1 - x0);
+    float scaleY = region.height / (y1 - y0);
+    // unscaled glyphs on whole pixels read their atlas rows in place
+    bool direct = scaleX == 1.0f && x0 == std::floor(x0);
+
+    const uint8_t* texels = atlas.Pixels();
+    for (int row = top; row < bottom; row++) {
+        int sourceY = std::min(int((row + 0.5f - y0) * scaleY),
+                               region.height - 1);
+        const uint8_t* sourceRow =
+            texels + size_t(region.y + sourceY) * atlas.Width() + region.x;
+        if (direct) {
+            BlendSpan(Row(row) + left, right - left, color,
+                      sourceRow + (left - int(x0)));
+            continue;
+        }
+        uint8_t* mask = coverage.data();
+        for (int column = left; column < right; column++) {
+            int sourceX = std::min(int((column + 0.5f - x0) * scaleX),
+                                   region.width - 1);
+            mask[column - left] = sourceRow[sourceX];
+        }
+        BlendSpan(Row(row) + left, right - left, color, mask);
+    }
+}
+
+void SoftwareRenderer::PushClip(const Rect& rect) {
+    clipStack.push_back(clip);
+    Clip inner = {PixelEdge(rect.x, clip.left, clip.right),
+                  PixelEdge(rect.y, clip.top, clip.bottom),
+                  PixelEdge(rect.x + rect.width, clip.left, clip.right),
+                  PixelEdge(rect.y + rect.height, clip.top, clip.bottom)};
+    clip = inner;
+}
+
+void SoftwareRenderer::PopClip() {
+    if (clipStack.empty()) return;
+    clip = clipStack.back();
+    clipStack.pop_back();
+}
+
+bool SoftwareRenderer::WritePPM(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+    std::vector<uint8_t> rgb(size_t(width) * 3);
+    for (int row = 0; row < height; row++) {
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(
+            pixels.data() + size_t(row) * width);
+        for (int column = 0; column < width; column++) {
+            rgb[column * 3] = source[column * 4];
+            rgb[column * 3 + 1] = source[column * 4 + 1];
+            rgb[column * 3 + 2] = source[column * 4 + 2];
+        }
+        std::fwrite(rgb.data(), 1, rgb.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,21 @@
+#include <GL/glew.h>
+#include "Core/Render/StreamBuffer.h"
+
+StreamBuffer::StreamBuffer(size_t initialSize) : capacity(initialSize) {
+    glGenBuffers(1, &bufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(capacity), nullptr,
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+StreamBuffer::~StreamBuffer() { glDeleteBuffers(1, &bufferID); }
+
+void StreamBuffer::Upload(const void* data, size_t size) {
+    while (capacity < size) capacity *= 2;
+    glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+    // orphan the old storage so the driver never stalls on the last frame
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(capacity), nullptr,
+                 GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(size), data);
+}
@@ -1,29 +1,67 @@
 
 #include "Core/Shader.h"
+#include "Core/ProgramCache.h"
 #include "glm/fwd.hpp"
 #include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
+namespace {
+
+// Binary search of the reflected table, for both const and mutable access.
+template <typename Table>
+auto FindById(Table& table, UniformId id) -> decltype(&table[0]) {
+    auto it = std::lower_bound(
+        table.begin(), table.end(), id,
+        [](const auto& uniform, UniformId id) { return uniform.id < id; });
+    return it != table.end() && it->id == id ? &*it : nullptr;
+}
+
+}  // namespace
+
 std::string LoadShaderSource(const std::string& path) {
     std::ifstream file(path);
+    if (!file) {
+        std::cerr << "[Shader] Could not open shader file: " << path << "\n";
+        return std::string();
+    }
     std::stringstream buffer;
     buffer << file.rdbuf();
     return buffer.str();
 }
 
-Shader::Shader(const std::string& vertexSrc, const std::string& fragmentSrc) {
-    std::string vertexCode = LoadShaderSource(vertexSrc);
-    std::string fragmentCode = LoadShaderSource(fragmentSrc);
-
-    unsigned int vertexShader = CompileShader(GL_VERTEX_SHADER, vertexCode);
-    unsigned int fragmentShader =
-        CompileShader(GL_FRAGMENT_SHADER, fragmentCode);
-    rendererID = LinkProgram(vertexShader, fragmentShader);
+// GLSL always spans lines (#version needs its own), a path never does.
+std::string ResolveShaderSource(const std::string& pathOrSource) {
+    if (pathOrSource.find('\n') != std::string::npos) return pathOrSource;
+    return LoadShaderSource(pathOrSource);
+}
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+Shader::Shader(const std::string& vertexSrc, const std::string& fragmentSrc) {
+    std::string vertexCode = ResolveShaderSource(vertexSrc);
+    std::string fragmentCode = ResolveShaderSource(fragmentSrc);
+
+    ProgramCache& cache = ProgramCache::Global();
+    rendererID = cache.Load(vertexCode, fragmentCode);
+    if (!rendererID) {
+        auto start = std::chrono::steady_clock::now();
+        unsigned int vertexShader =
+            CompileShader(GL_VERTEX_SHADER, vertexCode);
+        unsigned int fragmentShader =
+            CompileShader(GL_FRAGMENT_SHADER, fragmentCode);
+        rendererID = LinkProgram(vertexShader, fragmentShader);
+
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        double compileMs = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+        cache.Store(rendererID, vertexCode, fragmentCode, compileMs);
+    }
+    ReflectUniforms();
 }
 
 Shader::~Shader() { glDeleteProgram(rendererID); }
@@ -33,27 +71,108 @@ void Shader::Bind() { glUseProgram(rendererID); }
 void Shader::Unbind() { glUseProgram(0); }
 
 void Shader::SetUniformMat4(const std::string& name, const glm::mat4& value) {
-    GLint loc = GetUniformLocation(name);
-    if (loc != -1) glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]);
+    SetUniformMat4(HashUniformName(name), value);
 }
 
 void Shader::SetUniformFloat(const std::string& name, float value) {
-    GLint loc = GetUniformLocation(name);
-    if (loc != -1) glUniform1f(loc, value);
+    SetUniformFloat(HashUniformName(name), value);
+}
+
+void Shader::SetUniformFloat2(const std::string& name, const glm::vec2& value) {
+    SetUniformFloat2(HashUniformName(name), value);
 }
 
 void Shader::SetUniformFloat3(const std::string& name, const glm::vec3& value) {
-    GLint loc = GetUniformLocation(name);
-    if (loc != -1) glUniform3f(loc, value.x, value.y, value.z);
+    SetUniformFloat3(HashUniformName(name), value);
 }
 
 void Shader::SetUniformInt(const std::string& name, int value) {
-    GLint loc = GetUniformLocation(name);
+    SetUniformInt(HashUniformName(name), value);
+}
+
+void Shader::SetUniformMat4(UniformId id, const glm::mat4& value) {
+    GLint loc = PrepareSet(id, &value[0][0], sizeof(value));
+    if (loc != -1) glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::SetUniformFloat(UniformId id, float value) {
+    GLint loc = PrepareSet(id, &value, sizeof(value));
+    if (loc != -1) glUniform1f(loc, value);
+}
+
+void Shader::SetUniformFloat2(UniformId id, const glm::vec2& value) {
+    GLint loc = PrepareSet(id, &value.x, sizeof(value));
+    if (loc != -1) glUniform2f(loc, value.x, value.y);
+}
+
+void Shader::SetUniformFloat3(UniformId id, const glm::vec3& value) {
+    GLint loc = PrepareSet(id, &value.x, sizeof(value));
+    if (loc != -1) glUniform3f(loc, value.x, value.y, value.z);
+}
+
+void Shader::SetUniformInt(UniformId id, int value) {
+    GLint loc = PrepareSet(id, &value, sizeof(value));
     if (loc != -1) glUniform1i(loc, value);
 }
 
-int Shader::GetUniformLocation(const std::string& name) const {
-    return glGetUniformLocation(rendererID, name.c_str());
+bool Shader::BindUniformBlock(const std::string& name, unsigned int binding) {
+    GLuint index = glGetUniformBlockIndex(rendererID, name.c_str());
+    if (index == GL_INVALID_INDEX) return false;
+    glUniformBlockBinding(rendererID, index, binding);
+    return true;
+}
+
+void Shader::ReflectUniforms() {
+    uniforms.clear();
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(rendererID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(rendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> name(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(rendererID, GLuint(i), GLsizei(name.size()),
+                           &length, &size, &type, name.data());
+        // members of uniform blocks have no location
+        GLint location = glGetUniformLocation(rendererID, name.data());
+        if (location == -1) continue;
+
+        std::string_view view(name.data(), length);
+        if (view.size() > 3 && view.substr(view.size() - 3) == "[0]") {
+            view.remove_suffix(3);
+        }
+        uniforms.push_back({HashUniformName(view), location, 0, {}});
+    }
+
+    std::sort(uniforms.begin(), uniforms.end(),
+              [](const Uniform& a, const Uniform& b) { return a.id < b.id; });
+    for (size_t i = 1; i < uniforms.size(); i++) {
+        if (uniforms[i].id == uniforms[i - 1].id) {
+            std::cerr << "[Shader] Uniform name hash collision\n";
+        }
+    }
+}
+
+const Shader::Uniform* Shader::FindUniform(UniformId id) const {
+    return FindById(uniforms, id);
+}
+
+int Shader::PrepareSet(UniformId id, const void* value, size_t size) {
+    stats.uniformSets++;
+    Uniform* uniform = FindById(uniforms, id);
+    if (!uniform) return -1;
+
+    if (uniform->valueSize == size &&
+        std::memcmp(uniform->value, value, size) == 0) {
+        stats.skipped++;
+        return -1;
+    }
+    uniform->valueSize = uint8_t(size);
+    std::memcpy(uniform->value, value, size);
+    stats.uploads++;
+    return uniform->location;
 }
 
 unsigned int Shader::CompileShader(unsigned int type,
@@ -79,6 +198,7 @@ unsigned int Shader::LinkProgram(unsigned int vertexShader,
     unsigned int program = glCreateProgram();
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
+    ProgramCache::Global().MarkRetrievable(program);
     glLinkProgram(program);
 
     int success;
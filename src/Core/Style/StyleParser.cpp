@@ -0,0 +1,517 @@
+#include "Core/Style/StyleParser.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+inline bool IsCssSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f';
+}
+
+inline char ToLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+std::string_view Trim(std::string_view text) {
+    size_t begin = 0, end = text.size();
+    while (begin < end && IsCssSpace(text[begin])) begin++;
+    while (end > begin && IsCssSpace(text[end - 1])) end--;
+    return text.substr(begin, end - begin);
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (ToLower(a[i]) != b[i]) return false;
+    }
+    return true;
+}
+
+// Parses a decimal number into 26.6 fixed point; consumes the digits from
+// text and leaves the unit suffix.
+bool ParseFixed(std::string_view& text, int32_t& fixed) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+        negative = text[i] == '-';
+        i++;
+    }
+
+    int64_t integer = 0;
+    size_t digits = 0;
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+        if (integer < (int64_t(1) << 24)) {
+            integer = integer * 10 + (text[i] - '0');
+        }
+        i++;
+        digits++;
+    }
+
+    int64_t fraction = 0, scale = 1;
+    if (i < text.size() && text[i] == '.') {
+        i++;
+        while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+            if (scale < 1000000) {
+                fraction = fraction * 10 + (text[i] - '0');
+                scale *= 10;
+            }
+            i++;
+            digits++;
+        }
+    }
+    if (digits == 0) return false;
+
+    int64_t value = integer * 64 + (fraction * 64 + scale / 2) / scale;
+    if (negative) value = -value;
+    // past the 26.6 range a number stops at its ends instead of wrapping
+    fixed = static_cast<int32_t>(std::clamp<int64_t>(value, INT32_MIN,
+                                                     INT32_MAX));
+    text.remove_prefix(i);
+    return true;
+}
+
+bool ParseHexDigit(char c, uint8_t& value) {
+    c = ToLower(c);
+    if (c >= '0' && c <= '9') {
+        value = uint8_t(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+        value = uint8_t(c - 'a' + 10);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseHexColor(std::string_view hex, Color& color) {
+    uint8_t digits[8];
+    if (hex.size() != 3 && hex.size() != 4 && hex.size() != 6 &&
+        hex.size() != 8)
+        return false;
+    for (size_t i = 0; i < hex.size(); i++) {
+        if (!ParseHexDigit(hex[i], digits[i])) return false;
+    }
+
+    uint8_t channels[4] = {0, 0, 0, 255};
+    bool shortForm = hex.size() <= 4;
+    size_t count = shortForm ? hex.size() : hex.size() / 2;
+    for (size_t i = 0; i < count; i++) {
+        channels[i] = shortForm
+                          ? uint8_t(digits[i] * 17)
+                          : uint8_t(digits[i * 2] * 16 + digits[i * 2 + 1]);
+    }
+    color = {channels[0], channels[1], channels[2], channels[3]};
+    return true;
+}
+
+// rgb(r, g, b) and rgba(r, g, b, a) with integer channels and 0..1 alpha
+bool ParseRgbFunction(std::string_view args, bool hasAlpha, Color& color) {
+    int32_t channels[4] = {0, 0, 0, 64};
+    size_t count = hasAlpha ? 4 : 3;
+    for (size_t i = 0; i < count; i++) {
+        args = Trim(args);
+        if (!ParseFixed(args, channels[i])) return false;
+        args = Trim(args);
+        if (i + 1 < count) {
+            if (args.empty() || args[0] != ',') return false;
+            args.remove_prefix(1);
+        }
+    }
+    if (!Trim(args).empty()) return false;
+
+    auto clamp = [](int32_t value, int32_t max) {
+        return value < 0 ? 0 : (value > max ? max : value);
+    };
+    color = {uint8_t(clamp(channels[0] >> 6, 255)),
+             uint8_t(clamp(channels[1] >> 6, 255)),
+             uint8_t(clamp(channels[2] >> 6, 255)),
+             uint8_t(clamp(channels[3], 64) * 255 / 64)};
+    return true;
+}
+
+struct NamedColor {
+    std::string_view name;
+    Color color;
+};
+
+constexpr NamedColor kNamedColors[] = {
+    {"transparent", {0, 0, 0, 0}},
+    {"black", {0, 0, 0, 255}},
+    {"white", {255, 255, 255, 255}},
+    {"red", {255, 0, 0, 255}},
+    {"green", {0, 128, 0, 255}},
+    {"lime", {0, 255, 0, 255}},
+    {"blue", {0, 0, 255, 255}},
+    {"yellow", {255, 255, 0, 255}},
+    {"aqua", {0, 255, 255, 255}},
+    {"cyan", {0, 255, 255, 255}},
+    {"magenta", {255, 0, 255, 255}},
+    {"fuchsia", {255, 0, 255, 255}},
+    {"gray", {128, 128, 128, 255}},
+    {"grey", {128, 128, 128, 255}},
+    {"silver", {192, 192, 192, 255}},
+    {"lightgray", {211, 211, 211, 255}},
+    {"darkgray", {169, 169, 169, 255}},
+    {"maroon", {128, 0, 0, 255}},
+    {"olive", {128, 128, 0, 255}},
+    {"navy", {0, 0, 128, 255}},
+    {"purple", {128, 0, 128, 255}},
+    {"teal", {0, 128, 128, 255}},
+    {"orange", {255, 165, 0, 255}},
+    {"pink", {255, 192, 203, 255}},
+    {"brown", {165, 42, 42, 255}},
+    {"cadetblue", {95, 158, 160, 255}},
+    {"steelblue", {70, 130, 180, 255}},
+    {"skyblue", {135, 206, 235, 255}},
+    {"coral", {255, 127, 80, 255}},
+    {"gold", {255, 215, 0, 255}},
+    {"indigo", {75, 0, 130, 255}},
+    {"violet", {238, 130, 238, 255}},
+    {"tomato", {255, 99, 71, 255}},
+    {"whitesmoke", {245, 245, 245, 255}},
+};
+
+template <typename Enum, size_t N>
+bool ParseKeyword(std::string_view text,
+                  const std::pair<std::string_view, Enum> (&keywords)[N],
+                  Enum& value) {
+    for (const auto& keyword : keywords) {
+        if (EqualsIgnoreCase(text, keyword.first)) {
+            value = keyword.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+constexpr std::pair<std::string_view, Display> kDisplayKeywords[] = {
+    {"block", Display::Block},
+    {"inline", Display::Inline},
+    {"flex", Display::Flex},
+    {"none", Display::None},
+};
+
+constexpr std::pair<std::string_view, FlexDirection> kFlexDirectionKeywords[] =
+    {
+        {"row", FlexDirection::Row},
+        {"column", FlexDirection::Column},
+};
+
+constexpr std::pair<std::string_view, JustifyContent> kJustifyKeywords[] = {
+    {"flex-start", JustifyContent::FlexStart},
+    {"start", JustifyContent::FlexStart},
+    {"flex-end", JustifyContent::FlexEnd},
+    {"end", JustifyContent::FlexEnd},
+    {"center", JustifyContent::Center},
+    {"space-between", JustifyContent::SpaceBetween},
+    {"space-around", JustifyContent::SpaceAround},
+    {"space-evenly", JustifyContent::SpaceEvenly},
+};
+
+constexpr std::pair<std::string_view, AlignItems> kAlignKeywords[] = {
+    {"stretch", AlignItems::Stretch},
+    {"flex-start", AlignItems::FlexStart},
+    {"start", AlignItems::FlexStart},
+    {"flex-end", AlignItems::FlexEnd},
+    {"end", AlignItems::FlexEnd},
+    {"center", AlignItems::Center},
+};
+
+constexpr std::pair<std::string_view, Overflow> kOverflowKeywords[] = {
+    {"visible", Overflow::Visible},
+    {"hidden", Overflow::Hidden},
+    {"clip", Overflow::Hidden},
+    {"scroll", Overflow::Scroll},
+    {"auto", Overflow::Scroll},
+};
+
+constexpr std::pair<std::string_view, Virtualize> kVirtualizeKeywords[] = {
+    {"none", Virtualize::None},
+    {"rows", Virtualize::Rows},
+};
+
+// margin/padding shorthand: 1 to 4 lengths, CSS clockwise expansion
+bool ParseBoxShorthand(std::string_view text, Length (&sides)[4]) {
+    Length values[4];
+    size_t count = 0;
+    while (true) {
+        text = Trim(text);
+        if (text.empty()) break;
+        if (count == 4) return false;
+
+        size_t end = 0;
+        while (end < text.size() && !IsCssSpace(text[end])) end++;
+        if (!ParseLength(text.substr(0, end), values[count++])) return false;
+        text.remove_prefix(end);
+    }
+    if (count == 0) return false;
+
+    sides[kTop] = values[0];
+    sides[kRight] = count > 1 ? values[1] : values[0];
+    sides[kBottom] = count > 2 ? values[2] : values[0];
+    sides[kLeft] = count > 3 ? values[3] : sides[kRight];
+    return true;
+}
+
+enum class Property : uint8_t {
+    Display,
+    FlexDirection,
+    JustifyContent,
+    AlignItems,
+    Overflow,
+    Virtualize,
+    Width,
+    Height,
+    Margin,
+    MarginTop,
+    MarginRight,
+    MarginBottom,
+    MarginLeft,
+    Padding,
+    PaddingTop,
+    PaddingRight,
+    PaddingBottom,
+    PaddingLeft,
+    BorderRadius,
+    FontSize,
+    BackgroundColor,
+    Background,
+    Color,
+};
+
+constexpr std::pair<std::string_view, Property> kProperties[] = {
+    {"display", Property::Display},
+    {"flex-direction", Property::FlexDirection},
+    {"justify-content", Property::JustifyContent},
+    {"align-items", Property::AlignItems},
+    {"overflow", Property::Overflow},
+    {"virtualize", Property::Virtualize},
+    {"width", Property::Width},
+    {"height", Property::Height},
+    {"margin", Property::Margin},
+    {"margin-top", Property::MarginTop},
+    {"margin-right", Property::MarginRight},
+    {"margin-bottom", Property::MarginBottom},
+    {"margin-left", Property::MarginLeft},
+    {"padding", Property::Padding},
+    {"padding-top", Property::PaddingTop},
+    {"padding-right", Property::PaddingRight},
+    {"padding-bottom", Property::PaddingBottom},
+    {"padding-left", Property::PaddingLeft},
+    {"border-radius", Property::BorderRadius},
+    {"font-size", Property::FontSize},
+    {"background-color", Property::BackgroundColor},
+    {"background", Property::Background},
+    {"color", Property::Color},
+};
+
+bool ApplyProperty(Property id, std::string_view value, ComputedStyle& style) {
+    switch (id) {
+        case Property::Display:
+            return ParseKeyword(value, kDisplayKeywords, style.display);
+        case Property::FlexDirection:
+            return ParseKeyword(value, kFlexDirectionKeywords,
+                                style.flexDirection);
+        case Property::JustifyContent:
+            return ParseKeyword(value, kJustifyKeywords, style.justifyContent);
+        case Property::AlignItems:
+            return ParseKeyword(value, kAlignKeywords, style.alignItems);
+        case Property::Overflow:
+            return ParseKeyword(value, kOverflowKeywords, style.overflow);
+        case Property::Virtualize:
+            return ParseKeyword(value, kVirtualizeKeywords, style.virtualize);
+        case Property::Width: return ParseLength(value, style.width);
+        case Property::Height: return ParseLength(value, style.height);
+        case Property::Margin: return ParseBoxShorthand(value, style.margin);
+        case Property::MarginTop: return ParseLength(value, style.margin[kTop]);
+        case Property::MarginRight:
+            return ParseLength(value, style.margin[kRight]);
+        case Property::MarginBottom:
+            return ParseLength(value, style.margin[kBottom]);
+        case Property::MarginLeft:
+            return ParseLength(value, style.margin[kLeft]);
+        case Property::Padding: return ParseBoxShorthand(value, style.padding);
+        case Property::PaddingTop:
+            return ParseLength(value, style.padding[kTop]);
+        case Property::PaddingRight:
+            return ParseLength(value, style.padding[kRight]);
+        case Property::PaddingBottom:
+            return ParseLength(value, style.padding[kBottom]);
+        case Property::PaddingLeft:
+            return ParseLength(value, style.padding[kLeft]);
+        case Property::BorderRadius:
+            return ParseLength(value, style.borderRadius);
+        case Property::FontSize: {
+            Length size;
+            if (!ParseLength(value, size) || size.unit != LengthUnit::Px)
+                return false;
+            style.fontSize = size;
+            return true;
+        }
+        case Property::BackgroundColor:
+        case Property::Background:
+            return ParseColor(value, style.backgroundColor);
+        case Property::Color: return ParseColor(value, style.color);
+    }
+    return false;
+}
+
+// The fields a property writes, for DeclarationBlock.
+uint32_t PropertyFields(Property id) {
+    switch (id) {
+        case Property::Display: return kFieldDisplay;
+        case Property::FlexDirection: return kFieldFlexDirection;
+        case Property::JustifyContent: return kFieldJustifyContent;
+        case Property::AlignItems: return kFieldAlignItems;
+        case Property::Overflow: return kFieldOverflow;
+        case Property::Virtualize: return kFieldVirtualize;
+        case Property::Width: return kFieldWidth;
+        case Property::Height: return kFieldHeight;
+        case Property::Margin:
+            return kFieldMarginTop | kFieldMarginRight | kFieldMarginBottom |
+                   kFieldMarginLeft;
+        case Property::MarginTop: return kFieldMarginTop;
+        case Property::MarginRight: return kFieldMarginRight;
+        case Property::MarginBottom: return kFieldMarginBottom;
+        case Property::MarginLeft: return kFieldMarginLeft;
+        case Property::Padding:
+            return kFieldPaddingTop | kFieldPaddingRight |
+                   kFieldPaddingBottom | kFieldPaddingLeft;
+        case Property::PaddingTop: return kFieldPaddingTop;
+        case Property::PaddingRight: return kFieldPaddingRight;
+        case Property::PaddingBottom: return kFieldPaddingBottom;
+        case Property::PaddingLeft: return kFieldPaddingLeft;
+        case Property::BorderRadius: return kFieldBorderRadius;
+        case Property::FontSize: return kFieldFontSize;
+        case Property::BackgroundColor:
+        case Property::Background: return kFieldBackgroundColor;
+        case Property::Color: return kFieldColor;
+    }
+    return 0;
+}
+
+}  // namespace
+
+bool ParseLength(std::string_view text, Length& length) {
+    text = Trim(text);
+    if (EqualsIgnoreCase(text, "auto")) {
+        length = Length::Auto();
+        return true;
+    }
+
+    int32_t value;
+    if (!ParseFixed(text, value)) return false;
+
+    if (text.empty()) {
+        // only a bare zero may omit its unit
+        if (value != 0) return false;
+        length = {0, LengthUnit::Px};
+    } else if (EqualsIgnoreCase(text, "px")) {
+        length = {value, LengthUnit::Px};
+    } else if (text == "%") {
+        length = {value, LengthUnit::Percent};
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseColor(std::string_view text, Color& color) {
+    text = Trim(text);
+    if (text.empty()) return false;
+    if (text[0] == '#') return ParseHexColor(text.substr(1), color);
+
+    size_t open = text.find('(');
+    if (open != std::string_view::npos) {
+        if (text.back() != ')') return false;
+        std::string_view name = Trim(text.substr(0, open));
+        std::string_view args = text.substr(open + 1, text.size() - open - 2);
+        if (EqualsIgnoreCase(name, "rgb"))
+            return ParseRgbFunction(args, false, color);
+        if (EqualsIgnoreCase(name, "rgba"))
+            return ParseRgbFunction(args, true, color);
+        return false;
+    }
+
+    for (const NamedColor& named : kNamedColors) {
+        if (EqualsIgnoreCase(text, named.name)) {
+            color = named.color;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ApplyDeclaration(std::string_view property, std::string_view value,
+                      ComputedStyle& style) {
+    Property id;
+    if (!ParseKeyword(Trim(property), kProperties, id)) return false;
+    return ApplyProperty(id, Trim(value), style);
+}
+
+void ParseInlineStyle(std::string_view declarations, ComputedStyle& style) {
+    while (!declarations.empty()) {
+        size_t end = declarations.find(';');
+        std::string_view declaration = declarations.substr(0, end);
+        declarations.remove_prefix(
+            end == std::string_view::npos ? declarations.size() : end + 1);
+
+        size_t colon = declaration.find(':');
+        if (colon == std::string_view::npos) continue;
+
+        ApplyDeclaration(declaration.substr(0, colon),
+                         declaration.substr(colon + 1), style);
+    }
+}
+
+void ParseDeclarationBlock(std::string_view declarations,
+                           DeclarationBlock& block) {
+    while (!declarations.empty()) {
+        size_t end = declarations.find(';');
+        std::string_view declaration = declarations.substr(0, end);
+        declarations.remove_prefix(
+            end == std::string_view::npos ? declarations.size() : end + 1);
+
+        size_t colon = declaration.find(':');
+        if (colon == std::string_view::npos) continue;
+
+        Property id;
+        if (!ParseKeyword(Trim(declaration.substr(0, colon)), kProperties,
+                          id)) {
+            continue;
+        }
+        if (ApplyProperty(id, Trim(declaration.substr(colon + 1)),
+                          block.values)) {
+            block.fields |= PropertyFields(id);
+        }
+    }
+}
+
+void DeclarationBlock::ApplyTo(ComputedStyle& style) const {
+    if (fields & kFieldDisplay) style.display = values.display;
+    if (fields & kFieldFlexDirection) {
+        style.flexDirection = values.flexDirection;
+    }
+    if (fields & kFieldJustifyContent) {
+        style.justifyContent = values.justifyContent;
+    }
+    if (fields & kFieldAlignItems) style.alignItems = values.alignItems;
+    if (fields & kFieldOverflow) style.overflow = values.overflow;
+    if (fields & kFieldVirtualize) style.virtualize = values.virtualize;
+    if (fields & kFieldWidth) style.width = values.width;
+    if (fields & kFieldHeight) style.height = values.height;
+    for (int side = 0; side < 4; side++) {
+        if (fields & (kFieldMarginTop << side)) {
+            style.margin[side] = values.margin[side];
+        }
+        if (fields & (kFieldPaddingTop << side)) {
+            style.padding[side] = values.padding[side];
+        }
+    }
+    if (fields & kFieldBorderRadius) style.borderRadius = values.borderRadius;
+    if (fields & kFieldFontSize) style.fontSize = values.fontSize;
+    if (fields & kFieldBackgroundColor) {
+        style.backgroundColor = values.backgroundColor;
+    }
+    if (fields & kFieldColor) style.color = values.color;
+}
@@ -0,0 +1,453 @@
+#include "Core/Style/StyleSheet.h"
+#include "Core/Hash.h"
+#include "Core/Parser/SourceBuffer.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+inline bool IsCssSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f';
+}
+
+inline bool IsNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '-' || c == '_' ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+void SkipSpace(std::string_view text, size_t& position) {
+    while (position < text.size() && IsCssSpace(text[position])) position++;
+}
+
+std::string_view ReadName(std::string_view text, size_t& position) {
+    size_t start = position;
+    while (position < text.size() && IsNameChar(text[position])) position++;
+    return text.substr(start, position - start);
+}
+
+std::string StripComments(std::string_view css) {
+    std::string stripped;
+    stripped.reserve(css.size());
+    while (!css.empty()) {
+        size_t open = css.find("/*");
+        stripped.append(css.substr(0, open));
+        if (open == std::string_view::npos) break;
+        size_t close = css.find("*/", open + 2);
+        // a comment separates like whitespace does
+        stripped.push_back(' ');
+        css.remove_prefix(close == std::string_view::npos ? css.size()
+                                                          : close + 2);
+    }
+    return stripped;
+}
+
+// Position of the '}' closing the block opened at open, npos if the sheet
+// ends first.
+size_t FindBlockEnd(std::string_view css, size_t open) {
+    int depth = 0;
+    for (size_t i = open; i < css.size(); i++) {
+        if (css[i] == '{') {
+            depth++;
+        } else if (css[i] == '}' && --depth == 0) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// One selector of a list, written left to right.
+bool ParseSelector(std::string_view text, Selector& selector) {
+    std::vector<CompoundSelector> compounds;
+    std::vector<Combinator> combinators;
+    size_t i = 0;
+    SkipSpace(text, i);
+    while (true) {
+        CompoundSelector compound;
+        bool any = false;
+        if (i < text.size() && text[i] == '*') {
+            i++;
+            any = true;
+        } else if (i < text.size() && IsNameChar(text[i])) {
+            compound.tag = InternAtom(ReadName(text, i));
+            any = true;
+        }
+        while (i < text.size() && (text[i] == '.' || text[i] == '#')) {
+            char kind = text[i++];
+            std::string_view name = ReadName(text, i);
+            if (name.empty()) return false;
+            if (kind == '.') {
+                compound.classes.push_back(InternAtom(name));
+            } else if (compound.id == kInvalidAtom) {
+                compound.id = InternAtom(name);
+            } else {
+                return false;  // two ids
+            }
+            any = true;
+        }
+        if (!any) return false;
+        compounds.push_back(std::move(compound));
+
+        size_t end = i;
+        SkipSpace(text, i);
+        if (i == text.size()) break;
+        if (text[i] == '>') {
+            i++;
+            SkipSpace(text, i);
+            combinators.push_back(Combinator::Child);
+        } else if (i > end) {
+            combinators.push_back(Combinator::Descendant);
+        } else {
+            return false;  // pseudo-classes, attributes, sibling combinators
+        }
+    }
+
+    std::reverse(compounds.begin(), compounds.end());
+    std::reverse(combinators.begin(), combinators.end());
+
+    uint32_t ids = 0, classes = 0, types = 0;
+    size_t hashes = 0;
+    auto addHash = [&](SelectorKey kind, Atom atom) {
+        if (hashes < Selector::kAncestorHashes) {
+            selector.ancestorHashes[hashes++] = AncestorKeyHash(kind, atom);
+        }
+    };
+    for (size_t k = 0; k < compounds.size(); k++) {
+        const CompoundSelector& compound = compounds[k];
+        ids += compound.id != kInvalidAtom;
+        classes += uint32_t(compound.classes.size());
+        types += compound.tag != kInvalidAtom;
+        if (k == 0) continue;
+        // the most selective keys first, the filter has room for a few
+        if (compound.id != kInvalidAtom) addHash(SelectorKey::Id, compound.id);
+        for (Atom name : compound.classes) addHash(SelectorKey::Class, name);
+        if (compound.tag != kInvalidAtom) {
+            addHash(SelectorKey::Tag, compound.tag);
+        }
+    }
+    selector.specificity = std::min(ids, 255u) << 16 |
+                           std::min(classes, 255u) << 8 |
+                           std::min(types, 255u);
+    selector.compounds = std::move(compounds);
+    selector.combinators = std::move(combinators);
+    return true;
+}
+
+// A selector list is dropped whole if any of it is unsupported, as in CSS.
+bool ParseSelectorList(std::string_view text, std::vector<Selector>& list) {
+    while (true) {
+        size_t comma = text.find(',');
+        Selector selector;
+        if (!ParseSelector(text.substr(0, comma), selector)) return false;
+        list.push_back(std::move(selector));
+        if (comma == std::string_view::npos) return true;
+        text.remove_prefix(comma + 1);
+    }
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        char c = (a[i] >= 'A' && a[i] <= 'Z') ? char(a[i] - 'A' + 'a') : a[i];
+        if (c != b[i]) return false;
+    }
+    return true;
+}
+
+// rel="alternate stylesheet" and the like
+bool HasToken(std::string_view list, std::string_view token) {
+    size_t i = 0;
+    while (i < list.size()) {
+        SkipSpace(list, i);
+        size_t start = i;
+        while (i < list.size() && !IsCssSpace(list[i])) i++;
+        if (EqualsIgnoreCase(list.substr(start, i - start), token)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CollectElement(const Element& element, const std::string& baseDirectory,
+                    StyleSheet& sheet) {
+    if (element.tag == kAtomStyle) {
+        sheet.Parse(element.innerText);
+    } else if (element.tag == kAtomLink &&
+               HasToken(element.GetAttribute(kAtomRel), "stylesheet")) {
+        const std::string& href = element.GetAttribute(kAtomHref);
+        if (!href.empty()) {
+            std::string path = href[0] == '/' || baseDirectory.empty()
+                                   ? href
+                                   : baseDirectory + '/' + href;
+            SourceBuffer source = SourceBuffer::Map(path);
+            if (source.IsOpen()) sheet.Parse(source.View());
+        }
+    }
+    for (const auto& child : element.children) {
+        CollectElement(*child, baseDirectory, sheet);
+    }
+}
+
+const std::vector<RuleEntry>& Bucket(
+    const std::unordered_map<Atom, std::vector<RuleEntry>>& buckets,
+    Atom key) {
+    static const std::vector<RuleEntry> empty;
+    auto found = buckets.find(key);
+    return found == buckets.end() ? empty : found->second;
+}
+
+}  // namespace
+
+void AncestorFilter::Add(uint32_t hash) {
+    for (uint32_t slot : {hash & kMask, (hash >> kBits) & kMask}) {
+        if (counters[slot] != 255) counters[slot]++;
+    }
+}
+
+void AncestorFilter::Remove(uint32_t hash) {
+    for (uint32_t slot : {hash & kMask, (hash >> kBits) & kMask}) {
+        if (counters[slot] != 255) counters[slot]--;
+    }
+}
+
+uint32_t AncestorKeyHash(SelectorKey kind, Atom atom) {
+    // the top 24 bits of a multiplicative hash feed both filter slots
+    uint64_t mixed =
+        (uint64_t(atom) << 2 | uint64_t(kind)) * 0x9E3779B97F4A7C15ull;
+    uint32_t hash = uint32_t(mixed >> 40);
+    return hash ? hash : 1;
+}
+
+void StyleSheet::Parse(std::string_view source) {
+    std::string css = StripComments(source);
+    std::string_view rest = css;
+    std::vector<Selector> selectors;
+    while (true) {
+        size_t start = 0;
+        SkipSpace(rest, start);
+        rest.remove_prefix(start);
+        if (rest.empty()) break;
+
+        size_t open = rest.find('{');
+        if (rest[0] == '@') {
+            // at-rules are not supported, skip the statement or its block
+            size_t semicolon = rest.find(';');
+            if (semicolon < open) {
+                rest.remove_prefix(semicolon + 1);
+                continue;
+            }
+        }
+        if (open == std::string_view::npos) break;
+        size_t close = FindBlockEnd(rest, open);
+        std::string_view prelude = rest.substr(0, open);
+        std::string_view body = rest.substr(open + 1, close - open - 1);
+        rest.remove_prefix(close == std::string_view::npos ? rest.size()
+                                                           : close + 1);
+        if (prelude.empty() || prelude[0] == '@') continue;
+
+        selectors.clear();
+        if (!ParseSelectorList(prelude, selectors)) continue;
+        DeclarationBlock block;
+        ParseDeclarationBlock(body, block);
+        if (!block.fields) continue;
+
+        uint32_t index = uint32_t(blocks.size());
+        blocks.push_back(block);
+        for (Selector& selector : selectors) {
+            AddRule(std::move(selector), index);
+        }
+    }
+}
+
+void StyleSheet::AddRule(Selector selector, uint32_t block) {
+    usesAncestors |= selector.compounds.size() > 1;
+    RuleEntry entry = {uint32_t(rules.size()), {}};
+    std::copy(std::begin(selector.ancestorHashes),
+              std::end(selector.ancestorHashes), entry.ancestorHashes);
+    const CompoundSelector& subject = selector.compounds[0];
+    if (subject.id != kInvalidAtom) {
+        idRules[subject.id].push_back(entry);
+    } else if (!subject.classes.empty()) {
+        classRules[subject.classes[0]].push_back(entry);
+    } else if (subject.tag != kInvalidAtom) {
+        tagRules[subject.tag].push_back(entry);
+    } else {
+        universalRules.push_back(entry);
+    }
+    rules.push_back({std::move(selector), block});
+}
+
+std::shared_ptr<const StyleSheet> CollectStyleSheets(
+    const Element& root, const std::string& documentPath) {
+    size_t slash = documentPath.rfind('/');
+    std::string baseDirectory =
+        slash == std::string::npos ? std::string()
+                                   : documentPath.substr(0, slash ? slash : 1);
+    auto sheet = std::make_shared<StyleSheet>();
+    CollectElement(root, baseDirectory, *sheet);
+    if (sheet->Empty()) return nullptr;
+    return sheet;
+}
+
+void SelectorMatcher::SetStyleSheet(
+    std::shared_ptr<const StyleSheet> styleSheet) {
+    sheet = std::move(styleSheet);
+    ancestors.clear();
+    classes.clear();
+    filter = AncestorFilter();
+}
+
+SelectorMatcher::Key SelectorMatcher::MakeKey(Atom tag, std::string_view id,
+                                              std::string_view classList) {
+    Key key = {tag, id.empty() ? kInvalidAtom : FindAtom(id),
+               uint32_t(classes.size()), 0, 0};
+    size_t i = 0;
+    while (i < classList.size()) {
+        SkipSpace(classList, i);
+        size_t start = i;
+        while (i < classList.size() && !IsCssSpace(classList[i])) i++;
+        if (i == start) break;
+        // a name no selector uses was never interned and matches nothing
+        Atom name = FindAtom(classList.substr(start, i - start));
+        if (name == kInvalidAtom) continue;
+        auto first = classes.begin() + key.firstClass;
+        if (std::find(first, classes.end(), name) != classes.end()) continue;
+        classes.push_back(name);
+        key.classCount++;
+    }
+    return key;
+}
+
+void SelectorMatcher::PushAncestor(Atom tag, std::string_view id,
+                                   std::string_view classList) {
+    if (!Active()) return;
+    Key key = MakeKey(tag, id, classList);
+    // FNV-1a over the keys, root first; classes come in attribute order
+    uint64_t ancestry =
+        ancestors.empty() ? kHashSeed : ancestors.back().ancestry;
+    auto mix = [&ancestry](uint64_t value) {
+        ancestry = HashWord(ancestry, value);
+    };
+    mix(key.tag);
+    mix(uint64_t(key.id) << 32 | key.classCount);
+    for (uint32_t i = 0; i < key.classCount; i++) {
+        mix(classes[key.firstClass + i]);
+    }
+    key.ancestry = ancestry;
+    ancestors.push_back(key);
+    filter.Add(AncestorKeyHash(SelectorKey::Tag, key.tag));
+    if (key.id != kInvalidAtom) {
+        filter.Add(AncestorKeyHash(SelectorKey::Id, key.id));
+    }
+    for (uint32_t i = 0; i < key.classCount; i++) {
+        filter.Add(AncestorKeyHash(SelectorKey::Class,
+                                   classes[key.firstClass + i]));
+    }
+}
+
+void SelectorMatcher::PopAncestor() {
+    if (!Active() || ancestors.empty()) return;
+    const Key& key = ancestors.back();
+    filter.Remove(AncestorKeyHash(SelectorKey::Tag, key.tag));
+    if (key.id != kInvalidAtom) {
+        filter.Remove(AncestorKeyHash(SelectorKey::Id, key.id));
+    }
+    for (uint32_t i = 0; i < key.classCount; i++) {
+        filter.Remove(AncestorKeyHash(SelectorKey::Class,
+                                      classes[key.firstClass + i]));
+    }
+    classes.resize(key.firstClass);
+    ancestors.pop_back();
+}
+
+bool SelectorMatcher::Matches(const CompoundSelector& compound,
+                              const Key& key) const {
+    if (compound.tag != kInvalidAtom && compound.tag != key.tag) return false;
+    if (compound.id != kInvalidAtom && compound.id != key.id) return false;
+    auto first = classes.begin() + key.firstClass;
+    auto last = first + key.classCount;
+    for (Atom name : compound.classes) {
+        if (std::find(first, last, name) == last) return false;
+    }
+    return true;
+}
+
+// Matches compounds[compound] onwards against ancestors[0, limit), the
+// nearest last. A descendant combinator backtracks to farther ancestors.
+bool SelectorMatcher::MatchAncestors(const Selector& selector,
+                                     size_t compound, size_t limit) const {
+    if (compound == selector.compounds.size()) return true;
+    const CompoundSelector& wanted = selector.compounds[compound];
+    if (selector.combinators[compound - 1] == Combinator::Child) {
+        return limit > 0 && Matches(wanted, ancestors[limit - 1]) &&
+               MatchAncestors(selector, compound + 1, limit - 1);
+    }
+    for (size_t i = limit; i-- > 0;) {
+        if (Matches(wanted, ancestors[i]) &&
+            MatchAncestors(selector, compound + 1, i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SelectorMatcher::Consider(uint32_t rule, const uint32_t* ancestorHashes,
+                               const Key& subject) {
+    stats.candidates++;
+    if (useFilter) {
+        for (size_t i = 0; i < Selector::kAncestorHashes; i++) {
+            if (!ancestorHashes[i]) break;
+            if (!filter.MayContain(ancestorHashes[i])) {
+                stats.filtered++;
+                return;
+            }
+        }
+    }
+    const Selector& selector = sheet->rules[rule].selector;
+    if (Matches(selector.compounds[0], subject) &&
+        MatchAncestors(selector, 1, ancestors.size())) {
+        stats.matched++;
+        matched.push_back(rule);
+    }
+}
+
+void SelectorMatcher::Apply(Atom tag, std::string_view id,
+                            std::string_view classList,
+                            ComputedStyle& style) {
+    if (!Active()) return;
+    Key subject = MakeKey(tag, id, classList);
+    matched.clear();
+    if (useBuckets) {
+        auto consider = [&](const std::vector<RuleEntry>& bucket) {
+            for (const RuleEntry& entry : bucket) {
+                Consider(entry.rule, entry.ancestorHashes, subject);
+            }
+        };
+        if (subject.id != kInvalidAtom) {
+            consider(Bucket(sheet->idRules, subject.id));
+        }
+        for (uint32_t i = 0; i < subject.classCount; i++) {
+            consider(
+                Bucket(sheet->classRules, classes[subject.firstClass + i]));
+        }
+        consider(Bucket(sheet->tagRules, subject.tag));
+        consider(sheet->universalRules);
+    } else {
+        for (uint32_t i = 0; i < sheet->rules.size(); i++) {
+            Consider(i, sheet->rules[i].selector.ancestorHashes, subject);
+        }
+    }
+    classes.resize(subject.firstClass);
+
+    // ties in specificity go to the later rule
+    std::sort(matched.begin(), matched.end(),
+              [this](uint32_t a, uint32_t b) {
+                  uint32_t left = sheet->rules[a].selector.specificity;
+                  uint32_t right = sheet->rules[b].selector.specificity;
+                  return left != right ? left < right : a < b;
+              });
+    for (uint32_t index : matched) {
+        sheet->blocks[sheet->rules[index].block].ApplyTo(style);
+    }
+}
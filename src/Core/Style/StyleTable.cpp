@@ -0,0 +1,190 @@
+#include "Core/Style/StyleTable.h"
+#include "Core/Style/StyleParser.h"
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+// user-agent defaults: metadata elements are never rendered
+void ApplyDefaultStyle(Atom tag, ComputedStyle& style) {
+    if (tag == kAtomHead || tag == kAtomMeta || tag == kAtomTitle ||
+        tag == kAtomStyle || tag == kAtomLink) {
+        style.display = Display::None;
+    }
+}
+
+bool SameAttributes(const Element& a, const Element& b) {
+    if (a.attributes.size() != b.attributes.size()) return false;
+    for (size_t i = 0; i < a.attributes.size(); i++) {
+        if (a.attributes[i].name != b.attributes[i].name ||
+            a.attributes[i].value != b.attributes[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SameAttributes(const Node& a, const Node& b) {
+    if (a.attributeCount != b.attributeCount) return false;
+    for (uint32_t i = 0; i < a.attributeCount; i++) {
+        if (a.Attributes()[i].name != b.Attributes()[i].name ||
+            a.Attributes()[i].value != b.Attributes()[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+const ComputedStyle StyleTable::kInitialStyle;
+
+std::shared_ptr<const ComputedStyle>& StyleTable::Slot(uint32_t index) {
+    if (index >= styles.size()) styles.resize(index + 1);
+    return styles[index];
+}
+
+void StyleTable::BeginWalk() {
+    for (SharingCandidate& candidate : candidates) {
+        candidate = SharingCandidate();
+    }
+    nextCandidate = 0;
+}
+
+ComputedStyle StyleTable::Cascade(const Element& element,
+                                  const ComputedStyle& parent) {
+    ComputedStyle style;
+    style.InheritFrom(parent);
+    ApplyDefaultStyle(element.tag, style);
+    if (matcher.Active()) {
+        matcher.Apply(element.tag, element.GetAttribute(kAtomId),
+                      element.GetAttribute(kAtomClass), style);
+    }
+    if (const ElementAttribute* inline_style =
+            element.FindAttribute(kAtomStyle)) {
+        ParseInlineStyle(inline_style->value, style);
+    }
+    return style;
+}
+
+const ComputedStyle& StyleTable::ResolveNode(const Element& element,
+                                             const ComputedStyle& parent) {
+    std::shared_ptr<const ComputedStyle>& slot = Slot(element.index);
+    if (!sharing) {
+        sharingStats.resolved++;
+        slot = std::make_shared<const ComputedStyle>(Cascade(element, parent));
+        return *slot;
+    }
+
+    uint64_t ancestry = matcher.Ancestry();
+    for (const SharingCandidate& candidate : candidates) {
+        if (candidate.parent == &parent && candidate.ancestry == ancestry &&
+            candidate.element->tag == element.tag &&
+            SameAttributes(*candidate.element, element)) {
+            sharingStats.shared++;
+            slot = candidate.style;
+            return *slot;
+        }
+    }
+    sharingStats.resolved++;
+    slot = std::make_shared<const ComputedStyle>(Cascade(element, parent));
+    candidates[nextCandidate] = {&element, &parent, ancestry, slot};
+    nextCandidate = (nextCandidate + 1) % kSharingCandidates;
+    return *slot;
+}
+
+void StyleTable::ResolveElement(const Element& element,
+                                const ComputedStyle& parent) {
+    const ComputedStyle& style = ResolveNode(element, parent);
+    if (element.children.empty()) return;
+    PushAncestor(element);
+    for (const auto& child : element.children) {
+        ResolveElement(*child, style);
+    }
+    PopAncestor();
+}
+
+void StyleTable::Resolve(const Element& root) {
+    BeginWalk();
+    ResolveElement(root, kInitialStyle);
+}
+
+void StyleTable::ResolveSubtree(const Element& element) {
+    std::shared_ptr<Element> parent = element.parent.lock();
+    std::vector<std::shared_ptr<Element>> ancestors;
+    if (matcher.Active()) {
+        for (auto ancestor = parent; ancestor;
+             ancestor = ancestor->parent.lock()) {
+            ancestors.push_back(ancestor);
+        }
+    }
+    for (auto ancestor = ancestors.rbegin(); ancestor != ancestors.rend();
+         ++ancestor) {
+        PushAncestor(**ancestor);
+    }
+    BeginWalk();
+    ResolveElement(element, parent ? Get(parent->index) : kInitialStyle);
+    for (size_t i = 0; i < ancestors.size(); i++) PopAncestor();
+}
+
+void StyleTable::Resolve(const Document& document) {
+    styles.resize(document.NodeCount());
+
+    // nodes are created in document order, parents always come first, so
+    // the ancestors stay a stack: pop until the top is the node's parent
+    std::vector<NodeId> ancestors;
+    for (NodeId id = 0; id < document.NodeCount(); id++) {
+        const Node& node = document.GetNode(id);
+        std::string_view idAttribute, classes;
+        if (matcher.Active()) {
+            while (!ancestors.empty() && ancestors.back() != node.parent) {
+                ancestors.pop_back();
+                matcher.PopAncestor();
+            }
+            idAttribute = document.GetAttribute(id, kAtomId);
+            classes = document.GetAttribute(id, kAtomClass);
+        }
+
+        // the only candidate here is an alike leaf sibling right before
+        const Node* previous = id > 0 ? &document.GetNode(id - 1) : nullptr;
+        if (sharing && previous && previous->parent == node.parent &&
+            previous->firstChild == kInvalidNode &&
+            previous->tag == node.tag && SameAttributes(*previous, node)) {
+            sharingStats.shared++;
+            styles[id] = styles[id - 1];
+        } else {
+            ComputedStyle style;
+            if (node.parent != kInvalidNode) {
+                style.InheritFrom(*styles[node.parent]);
+            }
+            ApplyDefaultStyle(node.tag, style);
+            if (matcher.Active()) {
+                matcher.Apply(node.tag, idAttribute, classes, style);
+            }
+            std::string_view inline_style =
+                document.GetAttribute(id, kAtomStyle);
+            if (!inline_style.empty()) ParseInlineStyle(inline_style, style);
+            sharingStats.resolved++;
+            styles[id] = std::make_shared<const ComputedStyle>(style);
+        }
+
+        if (matcher.Active() && node.firstChild != kInvalidNode) {
+            ancestors.push_back(id);
+            matcher.PushAncestor(node.tag, idAttribute, classes);
+        }
+    }
+    for (size_t i = 0; i < ancestors.size(); i++) matcher.PopAncestor();
+}
+
+void StyleTable::Assign(
+    std::vector<std::shared_ptr<const ComputedStyle>> resolved) {
+    styles = std::move(resolved);
+}
+
+size_t StyleTable::DistinctStyles() const {
+    std::unordered_set<const ComputedStyle*> distinct;
+    for (const auto& style : styles) {
+        if (style) distinct.insert(style.get());
+    }
+    return distinct.size();
+}
@@ -0,0 +1,138 @@
+#include <GL/glew.h>
+#include "Core/Text/GlyphAtlas.h"
+#include <algorithm>
+#include <cstring>
+
+// one empty texel around every glyph keeps linear filtering from bleeding
+static constexpr int kGlyphPadding = 1;
+
+bool ShelfPacker::Pack(int w, int h, AtlasRegion& region) {
+    if (w > width || h > height) return false;
+
+    // a freed slot first, the one wasting the least area
+    size_t bestFree = freeSlots.size();
+    for (size_t i = 0; i < freeSlots.size(); i++) {
+        const AtlasRegion& slot = freeSlots[i];
+        if (slot.width >= w && slot.height >= h &&
+            (bestFree == freeSlots.size() ||
+             slot.width * slot.height < freeSlots[bestFree].width *
+                                            freeSlots[bestFree].height)) {
+            bestFree = i;
+        }
+    }
+    if (bestFree < freeSlots.size()) {
+        region = freeSlots[bestFree];
+        freeSlots[bestFree] = freeSlots.back();
+        freeSlots.pop_back();
+        packedArea += uint64_t(region.width) * region.height;
+        return true;
+    }
+
+    // best fit: the shortest shelf that is tall enough and has room
+    Shelf* best = nullptr;
+    for (Shelf& shelf : shelves) {
+        if (shelf.height >= h && shelf.x + w <= width &&
+            (!best || shelf.height < best->height)) {
+            best = &shelf;
+        }
+    }
+
+    if (!best) {
+        if (nextShelfY + h > height) return false;
+        shelves.push_back({nextShelfY, h, 0});
+        nextShelfY += h;
+        best = &shelves.back();
+    }
+
+    region = {uint16_t(best->x), uint16_t(best->y), uint16_t(w), uint16_t(h)};
+    best->x += w;
+    packedArea += uint64_t(w) * h;
+    return true;
+}
+
+void ShelfPacker::Free(const AtlasRegion& region) {
+    freeSlots.push_back(region);
+    packedArea -= uint64_t(region.width) * region.height;
+}
+
+void ShelfPacker::Clear() {
+    shelves.clear();
+    freeSlots.clear();
+    nextShelfY = 0;
+    packedArea = 0;
+}
+
+GlyphAtlas::GlyphAtlas(int width, int height)
+    : width(width),
+      height(height),
+      packer(width, height),
+      pixels(size_t(width) * height, 0),
+      dirtyTop(0),
+      dirtyBottom(height) {}
+
+GlyphAtlas::~GlyphAtlas() {
+    if (textureID) glDeleteTextures(1, &textureID);
+}
+
+bool GlyphAtlas::Add(const uint8_t* bitmap, int w, int h, int pitch,
+                     AtlasRegion& region, AtlasRegion* slot) {
+    AtlasRegion padded;
+    if (!packer.Pack(w + kGlyphPadding, h + kGlyphPadding, padded)) {
+        return false;
+    }
+
+    // a reused slot may be larger than the glyph, clear what it held
+    for (int row = 0; row < padded.height; row++) {
+        uint8_t* dst = &pixels[size_t(padded.y + row) * width + padded.x];
+        if (row < h) {
+            std::memcpy(dst, bitmap + ptrdiff_t(row) * pitch, size_t(w));
+            std::memset(dst + w, 0, size_t(padded.width - w));
+        } else {
+            std::memset(dst, 0, padded.width);
+        }
+    }
+
+    region = {padded.x, padded.y, uint16_t(w), uint16_t(h)};
+    if (slot) *slot = padded;
+    dirtyTop = std::min(dirtyTop, int(padded.y));
+    dirtyBottom = std::max(dirtyBottom, int(padded.y) + int(padded.height));
+    glyphCount++;
+    return true;
+}
+
+void GlyphAtlas::Free(const AtlasRegion& slot) {
+    packer.Free(slot);
+    glyphCount--;
+}
+
+void GlyphAtlas::Clear() {
+    packer.Clear();
+    std::fill(pixels.begin(), pixels.end(), 0);
+    dirtyTop = 0;
+    dirtyBottom = height;
+    glyphCount = 0;
+}
+
+void GlyphAtlas::Upload() {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (!textureID) {
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED,
+                     GL_UNSIGNED_BYTE, pixels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    } else if (dirtyTop < dirtyBottom) {
+        // rows are contiguous, so a full-width strip is one upload
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyTop, width,
+                        dirtyBottom - dirtyTop, GL_RED, GL_UNSIGNED_BYTE,
+                        &pixels[size_t(dirtyTop) * width]);
+    }
+
+    dirtyTop = height;
+    dirtyBottom = 0;
+}
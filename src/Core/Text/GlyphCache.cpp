@@ -0,0 +1,227 @@
+#include "Core/Text/GlyphCache.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <iostream>
+
+namespace {
+
+uint64_t MakeKey(FontId font, uint16_t pixelSize, uint32_t codepoint) {
+    return (uint64_t(font) << 48) | (uint64_t(pixelSize) << 32) | codepoint;
+}
+
+uint64_t Hash(uint64_t key) {
+    // splitmix64 finalizer
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    return key ^ (key >> 31);
+}
+
+size_t SlotBytes(const AtlasRegion& slot) {
+    return size_t(slot.width) * slot.height;
+}
+
+}  // namespace
+
+GlyphCache::GlyphCache(GlyphAtlas& atlas, size_t memoryBudget)
+    : atlas(atlas), memoryBudget(memoryBudget), table(256, 0) {
+    if (FT_Init_FreeType(&library)) {
+        std::cerr << "Could not init FreeType Library\n";
+        library = nullptr;
+    }
+}
+
+GlyphCache::~GlyphCache() {
+    for (FT_Face face : faces) FT_Done_Face(face);
+    if (library) FT_Done_FreeType(library);
+}
+
+FontId GlyphCache::LoadFont(const std::string& path) {
+    FT_Face face;
+    if (!library || faces.size() >= kInvalidFont ||
+        FT_New_Face(library, path.c_str(), 0, &face)) {
+        std::cerr << "Failed to load font: " << path << std::endl;
+        return kInvalidFont;
+    }
+    faces.push_back(face);
+    faceSizes.push_back(0);
+    return FontId(faces.size() - 1);
+}
+
+void GlyphCache::SelectSize(FontId font, uint16_t pixelSize) {
+    if (faceSizes[font] == pixelSize) return;
+    FT_Set_Pixel_Sizes(faces[font], 0, pixelSize);
+    faceSizes[font] = pixelSize;
+}
+
+int GlyphCache::Ascender(FontId font, uint16_t pixelSize) {
+    SelectSize(font, pixelSize);
+    return int(faces[font]->size->metrics.ascender >> 6);
+}
+
+void GlyphCache::SetMemoryBudget(size_t bytes) {
+    memoryBudget = bytes;
+    while (stats.bytesInUse > memoryBudget && EvictOne()) {
+    }
+}
+
+bool GlyphCache::GetGlyph(FontId font, uint16_t pixelSize,
+                          uint32_t codepoint, GlyphInfo& glyph) {
+    if (font >= faces.size()) return false;
+
+    uint64_t key = MakeKey(font, pixelSize, codepoint);
+    uint32_t index = Find(key);
+    if (index != kNone) {
+        stats.hits++;
+        Entry& entry = entries[index];
+        entry.frame = frame;
+        if (head != index) {
+            Unlink(index);
+            PushFront(index);
+        }
+        glyph = entry.glyph;
+        return true;
+    }
+
+    stats.misses++;
+    Entry entry = {key, {}, {}, frame, kNone, kNone};
+    if (!Rasterize(font, pixelSize, codepoint, entry)) {
+        stats.failures++;
+        return false;
+    }
+
+    if (freeEntries.empty()) {
+        index = uint32_t(entries.size());
+        entries.push_back(entry);
+    } else {
+        index = freeEntries.back();
+        freeEntries.pop_back();
+        entries[index] = entry;
+    }
+    PushFront(index);
+    Insert(key, index);
+    stats.entries++;
+    stats.bytesInUse += SlotBytes(entry.slot);
+
+    glyph = entry.glyph;
+    return true;
+}
+
+bool GlyphCache::Rasterize(FontId font, uint16_t pixelSize,
+                           uint32_t codepoint, Entry& entry) {
+    SelectSize(font, pixelSize);
+    FT_Face face = faces[font];
+    if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) return false;
+
+    const FT_Bitmap& bitmap = face->glyph->bitmap;
+    entry.glyph.bearingX = int16_t(face->glyph->bitmap_left);
+    entry.glyph.bearingY = int16_t(face->glyph->bitmap_top);
+    entry.glyph.advance = int32_t(face->glyph->advance.x);
+    if (bitmap.width == 0 || bitmap.rows == 0) return true;
+
+    size_t bytes = size_t(bitmap.width + 1) * (bitmap.rows + 1);
+    while (stats.bytesInUse + bytes > memoryBudget && EvictOne()) {
+    }
+
+    // FT_Load_Char above is the only FreeType call, the bitmap stays valid
+    // while evictions hand atlas space back
+    while (!atlas.Add(bitmap.buffer, int(bitmap.width), int(bitmap.rows),
+                      bitmap.pitch, entry.glyph.region, &entry.slot)) {
+        if (!EvictOne()) return false;
+    }
+    return true;
+}
+
+bool GlyphCache::EvictOne() {
+    if (tail == kNone || entries[tail].frame == frame) return false;
+
+    uint32_t index = tail;
+    Entry& entry = entries[index];
+    Unlink(index);
+    Erase(entry.key);
+    if (entry.slot.width > 0) atlas.Free(entry.slot);
+
+    stats.bytesInUse -= SlotBytes(entry.slot);
+    stats.entries--;
+    stats.evictions++;
+    generation++;
+    freeEntries.push_back(index);
+    return true;
+}
+
+void GlyphCache::Unlink(uint32_t index) {
+    Entry& entry = entries[index];
+    if (entry.prev != kNone) {
+        entries[entry.prev].next = entry.next;
+    } else {
+        head = entry.next;
+    }
+    if (entry.next != kNone) {
+        entries[entry.next].prev = entry.prev;
+    } else {
+        tail = entry.prev;
+    }
+    entry.prev = entry.next = kNone;
+}
+
+void GlyphCache::PushFront(uint32_t index) {
+    Entry& entry = entries[index];
+    entry.prev = kNone;
+    entry.next = head;
+    if (head != kNone) entries[head].prev = index;
+    head = index;
+    if (tail == kNone) tail = index;
+}
+
+uint32_t GlyphCache::Find(uint64_t key) const {
+    size_t mask = table.size() - 1;
+    for (size_t bucket = Hash(key) & mask;; bucket = (bucket + 1) & mask) {
+        uint32_t slot = table[bucket];
+        if (slot == 0) return kNone;
+        if (entries[slot - 1].key == key) return slot - 1;
+    }
+}
+
+void GlyphCache::Insert(uint64_t key, uint32_t index) {
+    // keep the load factor under one half so probe runs stay short
+    if ((stats.entries + 1) * 2 > table.size()) Grow();
+
+    size_t mask = table.size() - 1;
+    size_t bucket = Hash(key) & mask;
+    while (table[bucket] != 0) bucket = (bucket + 1) & mask;
+    table[bucket] = index + 1;
+}
+
+void GlyphCache::Erase(uint64_t key) {
+    size_t mask = table.size() - 1;
+    size_t bucket = Hash(key) & mask;
+    while (entries[table[bucket] - 1].key != key) {
+        bucket = (bucket + 1) & mask;
+    }
+
+    // backward-shift deletion, no tombstones to slow later probes
+    size_t hole = bucket;
+    for (size_t next = (hole + 1) & mask; table[next] != 0;
+         next = (next + 1) & mask) {
+        size_t home = Hash(entries[table[next] - 1].key) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table[hole] = table[next];
+            hole = next;
+        }
+    }
+    table[hole] = 0;
+}
+
+void GlyphCache::Grow() {
+    std::vector<uint32_t> old(table.size() * 2, 0);
+    old.swap(table);
+
+    size_t mask = table.size() - 1;
+    for (uint32_t slot : old) {
+        if (slot == 0) continue;
+        size_t bucket = Hash(entries[slot - 1].key) & mask;
+        while (table[bucket] != 0) bucket = (bucket + 1) & mask;
+        table[bucket] = slot;
+    }
+}
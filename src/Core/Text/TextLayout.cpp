@@ -0,0 +1,228 @@
+#include "Core/Text/TextLayout.h"
+#include "Core/Hash.h"
+#include "Core/Text/Utf8.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+
+uint64_t MakeKey(FontId font, uint16_t pixelSize, uint32_t codepoint) {
+    return (uint64_t(font) << 48) | (uint64_t(pixelSize) << 32) | codepoint;
+}
+
+uint64_t RunKey(std::string_view text, FontId font, uint16_t pixelSize) {
+    return HashBytes(kHashSeed, text.data(), text.size()) ^
+           MakeKey(font, pixelSize, 0);
+}
+
+bool IsSpace(uint32_t codepoint) {
+    return codepoint == ' ' || codepoint == '\t' || codepoint == '\n' ||
+           codepoint == '\r';
+}
+
+}  // namespace
+
+TextLayout::TextLayout(GlyphCache& glyphs, size_t memoryBudget)
+    : glyphs(glyphs), memoryBudget(memoryBudget) {}
+
+std::shared_ptr<const TextBlock> TextLayout::Layout(std::string_view text,
+                                                    FontId font,
+                                                    uint16_t pixelSize,
+                                                    float maxWidth) {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t key = RunKey(text, font, pixelSize);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        Entry& entry = *found->second;
+        if (entry.text == text && entry.font == font &&
+            entry.pixelSize == pixelSize) {
+            stats.runHits++;
+            entries.splice(entries.begin(), entries, found->second);
+            for (auto block = entry.blocks.rbegin();
+                 block != entry.blocks.rend(); ++block) {
+                if ((*block)->maxWidth == maxWidth) {
+                    stats.blockHits++;
+                    return *block;
+                }
+            }
+        } else {
+            // a hash collision, the newer text takes the slot
+            stats.bytesInUse -= entry.bytes;
+            stats.entries--;
+            entries.erase(found->second);
+            index.erase(found);
+            found = index.end();
+        }
+    }
+    if (found == index.end()) {
+        stats.runMisses++;
+        std::shared_ptr<const ShapedRun> run =
+            Shape(text, font, pixelSize);
+        size_t bytes = text.size() + run->ByteSize();
+        entries.push_front(
+            {key, std::string(text), font, pixelSize, std::move(run), {},
+             bytes});
+        found = index.emplace(key, entries.begin()).first;
+        stats.bytesInUse += bytes;
+        stats.entries++;
+    }
+
+    Entry& entry = *found->second;
+    stats.blockMisses++;
+    std::shared_ptr<const TextBlock> block = Break(entry.run, maxWidth);
+    if (entry.blocks.size() == kBlocksPerRun) {
+        size_t dropped = entry.blocks.front()->lines.size() * sizeof(TextLine);
+        entry.bytes -= dropped;
+        stats.bytesInUse -= dropped;
+        entry.blocks.erase(entry.blocks.begin());
+    }
+    size_t added = block->lines.size() * sizeof(TextLine);
+    entry.bytes += added;
+    stats.bytesInUse += added;
+    entry.blocks.push_back(block);
+    Trim();
+    return block;
+}
+
+TextMeasurer TextLayout::Measurer(FontId font) {
+    return [this, font](std::string_view text, float fontSize,
+                        float maxWidth) {
+        std::shared_ptr<const TextBlock> block = Layout(
+            text, font, uint16_t(std::lround(fontSize)), maxWidth);
+        return TextSize{block->width, block->height};
+    };
+}
+
+void TextLayout::Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    stats.bytesInUse = 0;
+    stats.entries = 0;
+}
+
+TextLayoutStats TextLayout::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::shared_ptr<const ShapedRun> TextLayout::Shape(std::string_view text,
+                                                   FontId font,
+                                                   uint16_t pixelSize) {
+    auto run = std::make_shared<ShapedRun>();
+    if (font == kInvalidFont) return run;
+
+    glyphs.SelectSize(font, pixelSize);
+    FT_Face face = glyphs.Face(font);
+    run->lineHeight = float(face->size->metrics.height >> 6);
+    run->ascender = float(face->size->metrics.ascender >> 6);
+    bool kerning = FT_HAS_KERNING(face);
+
+    run->codepoints.reserve(text.size());
+    run->pens.reserve(text.size() + 1);
+    // 26.6, saturating far beyond any screen
+    int64_t pen = 0;
+    uint32_t previous = 0;
+    size_t position = 0;
+    const Metrics* ascii[128] = {};  // spares most lookups
+    while (position < text.size()) {
+        uint32_t codepoint = DecodeUtf8(text, position);
+        const Metrics* glyph = codepoint < 128 ? ascii[codepoint] : nullptr;
+        if (!glyph) {
+            glyph = &GlyphMetrics(font, pixelSize, codepoint);
+            if (codepoint < 128) ascii[codepoint] = glyph;
+        }
+        if (kerning && previous && glyph->glyphIndex) {
+            pen += Kerning(font, pixelSize, previous, glyph->glyphIndex);
+        }
+        run->codepoints.push_back(codepoint);
+        run->pens.push_back(int32_t(std::min<int64_t>(pen, INT32_MAX)));
+        pen += glyph->advance;
+        previous = glyph->glyphIndex;
+    }
+    run->pens.push_back(int32_t(std::min<int64_t>(pen, INT32_MAX)));
+
+    uint32_t count = uint32_t(run->codepoints.size());
+    for (uint32_t i = 0; i < count;) {
+        while (i < count && IsSpace(run->codepoints[i])) i++;
+        if (i == count) break;
+        uint32_t start = i;
+        while (i < count && !IsSpace(run->codepoints[i])) i++;
+        run->words.push_back({start, i});
+    }
+    return run;
+}
+
+const TextLayout::Metrics& TextLayout::GlyphMetrics(FontId font,
+                                                    uint16_t pixelSize,
+                                                    uint32_t codepoint) {
+    auto [it, inserted] =
+        metrics.emplace(MakeKey(font, pixelSize, codepoint), Metrics{0, 0});
+    if (inserted) {
+        // the same load GlyphCache renders with, so advances agree
+        FT_Face face = glyphs.Face(font);
+        it->second.glyphIndex = FT_Get_Char_Index(face, codepoint);
+        if (!FT_Load_Glyph(face, it->second.glyphIndex, FT_LOAD_DEFAULT)) {
+            it->second.advance = int32_t(face->glyph->advance.x);
+        }
+    }
+    return it->second;
+}
+
+int32_t TextLayout::Kerning(FontId font, uint16_t pixelSize, uint32_t left,
+                            uint32_t right) {
+    FT_Face face = glyphs.Face(font);
+    FT_Vector delta;
+    if (left > 0xFFFF || right > 0xFFFF) {
+        return FT_Get_Kerning(face, left, right, FT_KERNING_DEFAULT, &delta)
+                   ? 0
+                   : int32_t(delta.x);
+    }
+    uint64_t key = MakeKey(font, pixelSize, left << 16 | right);
+    auto [it, inserted] = kerningPairs.emplace(key, 0);
+    if (inserted &&
+        !FT_Get_Kerning(face, left, right, FT_KERNING_DEFAULT, &delta)) {
+        it->second = int32_t(delta.x);
+    }
+    return it->second;
+}
+
+std::shared_ptr<const TextBlock> TextLayout::Break(
+    const std::shared_ptr<const ShapedRun>& run, float maxWidth) const {
+    auto block = std::make_shared<TextBlock>();
+    block->run = run;
+    block->maxWidth = maxWidth;
+
+    const std::vector<ShapedRun::Word>& words = run->words;
+    const std::vector<int32_t>& pens = run->pens;
+    float limit = maxWidth * 64;
+    size_t next = 0;
+    while (next < words.size()) {
+        // the first word always goes on the line, the rest while they fit
+        uint32_t start = words[next].start, end = words[next].end;
+        for (next++; next < words.size(); next++) {
+            if (float(pens[words[next].end] - pens[start]) > limit) break;
+            end = words[next].end;
+        }
+        float width = float(pens[end] - pens[start]) / 64;
+        block->lines.push_back({start, end, width});
+        block->width = std::max(block->width, width);
+    }
+    block->height = float(block->lines.size()) * run->lineHeight;
+    return block;
+}
+
+void TextLayout::Trim() {
+    // the entry just used stays, whatever its size
+    while (stats.bytesInUse > memoryBudget && entries.size() > 1) {
+        Entry& victim = entries.back();
+        stats.bytesInUse -= victim.bytes;
+        stats.entries--;
+        stats.evictions++;
+        index.erase(victim.key);
+        entries.pop_back();
+    }
+}
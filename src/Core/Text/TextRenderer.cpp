@@ -0,0 +1,93 @@
+#include <GL/glew.h>
+#include "Core/Text/TextRenderer.h"
+#include <cstddef>
+
+TextRenderer::TextRenderer(GlyphAtlas& atlas)
+    : atlas(atlas), buffer(1024 * 4 * sizeof(TextVertex)) {
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &ebo);
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.ID());
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex),
+                          (void*)offsetof(TextVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextVertex),
+                          (void*)offsetof(TextVertex, r));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBindVertexArray(0);
+
+    Reserve(1024);
+}
+
+TextRenderer::~TextRenderer() {
+    glDeleteBuffers(1, &ebo);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void TextRenderer::Reserve(size_t quads) {
+    if (quads <= indexedQuads) return;
+    while (indexedQuads < quads) {
+        indexedQuads = indexedQuads ? indexedQuads * 2 : 1024;
+    }
+
+    // the index pattern never changes, it only grows with the vertices
+    std::vector<uint32_t> indices(indexedQuads * 6);
+    for (size_t quad = 0; quad < indexedQuads; quad++) {
+        uint32_t base = uint32_t(quad * 4);
+        uint32_t* index = &indices[quad * 6];
+        index[0] = base;
+        index[1] = base + 1;
+        index[2] = base + 2;
+        index[3] = base;
+        index[4] = base + 2;
+        index[5] = base + 3;
+    }
+
+    glBindVertexArray(vao);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t),
+                 indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+void TextRenderer::BeginFrame() {
+    vertices.clear();
+    stats = TextRendererStats();
+}
+
+void TextRenderer::AddQuad(float x0, float y0, float x1, float y1,
+                           const AtlasRegion& region, Color color) {
+    float scaleU = 1.0f / atlas.Width(), scaleV = 1.0f / atlas.Height();
+    float u0 = region.x * scaleU, v0 = region.y * scaleV;
+    float u1 = (region.x + region.width) * scaleU;
+    float v1 = (region.y + region.height) * scaleV;
+    AddQuad(x0, y0, x1, y1, u0, v0, u1, v1, color);
+}
+
+void TextRenderer::AddQuad(float x0, float y0, float x1, float y1, float u0,
+                           float v0, float u1, float v1, Color color) {
+    vertices.push_back({x0, y0, u0, v0, color.r, color.g, color.b, color.a});
+    vertices.push_back({x0, y1, u0, v1, color.r, color.g, color.b, color.a});
+    vertices.push_back({x1, y1, u1, v1, color.r, color.g, color.b, color.a});
+    vertices.push_back({x1, y0, u1, v0, color.r, color.g, color.b, color.a});
+}
+
+void TextRenderer::Flush() {
+    if (vertices.empty()) return;
+
+    size_t quads = vertices.size() / 4;
+    Reserve(quads);
+    atlas.Upload();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas.TextureID());
+    buffer.Upload(vertices.data(), vertices.size() * sizeof(TextVertex));
+    glBindVertexArray(vao);
+    glDrawElements(GL_TRIANGLES, GLsizei(quads * 6), GL_UNSIGNED_INT, nullptr);
+    glBindVertexArray(0);
+
+    stats.drawCalls++;
+    stats.quads += uint32_t(quads);
+    vertices.clear();
+}
@@ -0,0 +1,128 @@
+#include "Core/ThreadPool.h"
+#include <algorithm>
+
+namespace {
+
+// Queue of the pool the current thread works for, so a nested ParallelFor
+// pushes onto its own deque.
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentQueue = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(unsigned threads) {
+    threads = std::max(threads, 1u);
+    for (unsigned i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, size_t(i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+size_t ThreadPool::CurrentQueue() const {
+    return currentPool == this ? currentQueue : 0;
+}
+
+void ThreadPool::ParallelFor(size_t count,
+                             const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+    if (workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; i++) task(i);
+        return;
+    }
+
+    std::atomic<size_t> pending{count};
+    size_t own = CurrentQueue();
+    {
+        // pushed in reverse so the owner pops them in index order
+        Queue& queue = *queues[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queued.fetch_add(count - 1, std::memory_order_release);
+        for (size_t i = count; i-- > 1;) {
+            queue.tasks.push_back({&task, i, &pending});
+        }
+    }
+    {
+        // a worker between its check and its wait would miss the notify
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+
+    Execute({&task, 0, &pending});
+    // help out until every task of this loop is done, ours may be stolen
+    Task next;
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (Pop(own, next) || Steal(own, next)) {
+            Execute(next);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&] {
+            return pending.load(std::memory_order_acquire) == 0 ||
+                   queued.load(std::memory_order_acquire) != 0;
+        });
+    }
+}
+
+bool ThreadPool::Pop(size_t queue, Task& task) {
+    Queue& own = *queues[queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.tasks.empty()) return false;
+    task = own.tasks.back();
+    own.tasks.pop_back();
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::Steal(size_t thief, Task& task) {
+    for (size_t i = 1; i < queues.size(); i++) {
+        Queue& victim = *queues[(thief + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::Execute(const Task& task) {
+    (*task.function)(task.index);
+    // the last task wakes the loop's caller; pending lives on its stack, so
+    // it is not touched after the count drops
+    if (task.pending->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        {
+            // a caller between its check and its wait would miss the notify
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+    }
+}
+
+void ThreadPool::WorkerLoop(size_t queue) {
+    currentPool = this;
+    currentQueue = queue;
+    Task task;
+    for (;;) {
+        if (Pop(queue, task) || Steal(queue, task)) {
+            Execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] {
+            return stopping || queued.load(std::memory_order_acquire) != 0;
+        });
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,32 @@
+#include <GL/glew.h>
+#include "Core/UniformBuffer.h"
+#include <cstring>
+
+UniformBuffer::UniformBuffer(unsigned int binding, size_t size)
+    : binding(binding), contents(size) {
+    glGenBuffers(1, &bufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+    // zero filled, so the CPU copy matches from the start
+    glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(size), contents.data(),
+                 GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, bufferID);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformBuffer::~UniformBuffer() { glDeleteBuffers(1, &bufferID); }
+
+bool UniformBuffer::Update(const void* data, size_t size, size_t offset) {
+    if (offset + size > contents.size()) return false;
+    if (std::memcmp(&contents[offset], data, size) == 0) {
+        skipped++;
+        return false;
+    }
+
+    std::memcpy(&contents[offset], data, size);
+    glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+    glBufferSubData(GL_UNIFORM_BUFFER, GLintptr(offset), GLsizeiptr(size),
+                    data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    uploads++;
+    return true;
+}
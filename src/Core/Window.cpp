@@ -23,10 +23,91 @@ Window::Window(int width, int height, const std::string& name) {
     }
     glfwMakeContextCurrent(window);
     MakeWindowBorderless(window);
+    InstallEventCounters();
+}
+
+void Window::InstallEventCounters() {
+    // GLFW callbacks are plain function pointers; the Window comes back
+    // through the user pointer
+    glfwSetWindowUserPointer(window, this);
+    glfwSetKeyCallback(
+        window, [](GLFWwindow* w, int key, int, int action, int mods) {
+            InputEvent event;
+            event.type = action == GLFW_RELEASE ? InputEventType::KeyUp
+                                                : InputEventType::KeyDown;
+            event.key = key;
+            event.mods = mods;
+            QueueEvent(w, event);
+        });
+    glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int codepoint) {
+        InputEvent event;
+        event.type = InputEventType::Char;
+        event.codepoint = codepoint;
+        QueueEvent(w, event);
+    });
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double x, double y) {
+        auto* self = static_cast<Window*>(glfwGetWindowUserPointer(w));
+        self->cursorX = x;
+        self->cursorY = y;
+        InputEvent event;
+        event.type = InputEventType::MouseMove;
+        QueueEvent(w, event);
+    });
+    glfwSetMouseButtonCallback(
+        window, [](GLFWwindow* w, int button, int action, int mods) {
+            InputEvent event;
+            event.type = action == GLFW_PRESS ? InputEventType::MouseDown
+                                              : InputEventType::MouseUp;
+            event.button = button;
+            event.mods = mods;
+            QueueEvent(w, event);
+        });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double dx, double dy) {
+        InputEvent event;
+        event.type = InputEventType::Scroll;
+        event.scrollX = float(dx);
+        event.scrollY = float(dy);
+        QueueEvent(w, event);
+    });
+    glfwSetFramebufferSizeCallback(
+        window, [](GLFWwindow* w, int, int) { CountEvent(w); });
+    glfwSetWindowRefreshCallback(window,
+                                 [](GLFWwindow* w) { CountEvent(w); });
+    glfwSetWindowFocusCallback(window,
+                               [](GLFWwindow* w, int) { CountEvent(w); });
+}
+
+void Window::CountEvent(GLFWwindow* handle) {
+    static_cast<Window*>(glfwGetWindowUserPointer(handle))->eventCount++;
+}
+
+void Window::QueueEvent(GLFWwindow* handle, InputEvent event) {
+    auto* self = static_cast<Window*>(glfwGetWindowUserPointer(handle));
+    self->eventCount++;
+    event.x = float(self->cursorX);
+    event.y = float(self->cursorY);
+    if (event.type == InputEventType::MouseMove && !self->events.empty() &&
+        self->events.back().type == InputEventType::MouseMove) {
+        self->events.back() = event;  // coalesced
+        return;
+    }
+    self->events.push_back(event);
+}
+
+std::vector<InputEvent> Window::TakeEvents() {
+    std::vector<InputEvent> taken;
+    taken.swap(events);
+    return taken;
 }
 
 void Window::PollEvents() { glfwPollEvents(); }
 
+void Window::WaitEvents(double timeout) { glfwWaitEventsTimeout(timeout); }
+
+void Window::SwapBuffers() { glfwSwapBuffers(window); }
+
+void Window::SetSwapInterval(int interval) { glfwSwapInterval(interval); }
+
 bool Window::ShouldClose() const { return glfwWindowShouldClose(window); }
 
 Window::~Window() {